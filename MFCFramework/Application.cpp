@@ -31,7 +31,7 @@
  * Constructor.
  */
 Application::Application(void){
-
+	frameworkVersion = 0;
 
 }
 
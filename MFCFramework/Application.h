@@ -76,6 +76,8 @@ public:
 
     //this is the physical world that contains all the objects inside
     SimBiConFramework* conF;
+    //this goes up every time conF is replaced, so that whoever keeps pointers into the old framework knows they are not valid anymore
+    int frameworkVersion;
 
 };
 
@@ -22,9 +22,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "GLCallbacks.h"
 #include "SkinningTechnique.h"
-#include "FloorTechnique.h"
-#include "LightingTechnique.h"
-#include "WireFrameTechnique.h"
+#include "Floor.h"
+#include "SkeletonRenderer.h"
+#include "SimulationThread.h"
 #include "Skybox.h"
 #include "MeshLoader_Skel.h"
 #include "MeshLoader.h"
@@ -55,15 +55,17 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #undef min
 
 #include "Objectives1.h"
-#include <shark/Algorithms/DirectSearch/MOCMA.h>
+#include "ParallelMOCMA.h"
 
 using namespace shark;
 using namespace std;
 
 #define RENDERING
 //#define PHYSX_DEBUGGING
-//#define LONG_HAND
-//#define LONG_LEG
+
+// The floor covers what used to be a grid of 40x40 tiles, 10 units apart
+#define FLOOR_SIZE 400.0f
+#define FLOOR_TILE_SIZE 10.0f
 
 // Inherent from CGLCallbacks to override those virtual interface
 class CBVHPlayer : public CGLCallbacks
@@ -73,8 +75,9 @@ public:
     CBVHPlayer()
     {
          m_SkinningTechnique = NULL;
-         m_FloorTechnique = NULL;
-         m_LightingTechnique = NULL;
+         m_SkeletonRenderer = NULL;
+         m_BoundFrameworkVersion = -1;
+         m_Simulation = NULL;
          m_Skeleton = NULL;
          m_Floor = NULL;
          m_BoxMesh = NULL;
@@ -82,26 +85,14 @@ public:
          m_Box13Mesh = NULL;
          m_Box14Mesh = NULL;
          m_Box32Mesh = NULL;
-         Pelvis = NULL;
-         Torso = NULL;
-         Head = NULL;
-         lUpperarm = NULL;
-         lLowerarm = NULL;
-         rUpperarm = NULL;
-         rLowerarm = NULL;
-         lUpperleg = NULL;
-         lLowerleg = NULL;
-         rUpperleg = NULL;
-         rLowerleg = NULL;
-         lFoot = NULL;
-         rFoot = NULL;
-         m_FloorTexture = NULL;
 //          m_Plane = NULL;
 //          m_PhysicsSDK = NULL;
 //          gScene = NULL;
 //          m_Box = NULL;
          m_GameCamera = NULL;        
          m_SkyBox = NULL;
+         m_Evaluator = NULL;
+         m_EvaluationCache = NULL;
 /*         m_AF = NULL;*/
  
          m_DirectionLight.AmbientIntensity = 1.0f;
@@ -113,54 +104,42 @@ public:
 
     ~CBVHPlayer()
     {
+         // The simulation thread has to stop before the application it steps goes away
+         SAFE_DELETE(m_Simulation);
          SAFE_DELETE(m_SkinningTechnique);
-         SAFE_DELETE(m_FloorTechnique);
-         SAFE_DELETE(m_LightingTechnique);
+         SAFE_DELETE(m_SkeletonRenderer);
          SAFE_DELETE(m_Floor);
          SAFE_DELETE(m_BoxMesh);
          SAFE_DELETE(m_Box12Mesh);
          SAFE_DELETE(m_Box13Mesh);
          SAFE_DELETE(m_Box14Mesh);
          SAFE_DELETE(m_Box32Mesh);
-         SAFE_DELETE(m_FloorTexture);
-         SAFE_DELETE(Pelvis);
-         SAFE_DELETE(Torso);
-         SAFE_DELETE(Head);
-         SAFE_DELETE(lUpperarm);
-         SAFE_DELETE(lLowerarm);
-         SAFE_DELETE(rUpperarm);
-         SAFE_DELETE(rLowerarm);
-         SAFE_DELETE(lUpperleg);
-         SAFE_DELETE(lLowerleg);
-         SAFE_DELETE(rUpperleg);
-         SAFE_DELETE(rLowerleg);
-         SAFE_DELETE(lFoot);
-         SAFE_DELETE(rFoot);
 /*         SAFE_DELETE(m_PhysicsSDK);*/
 /*         SAFE_DELETE(m_Box);*/
          SAFE_DELETE(m_SkyBox);
          SAFE_DELETE(m_Skeleton);    
          SAFE_DELETE(m_GameCamera);
          //SAFE_DELETE(m_AF);
+         SAFE_DELETE(m_Evaluator);
+         SAFE_DELETE(m_EvaluationCache);
          SAFE_DELETE(Globals::app);
     }
 
     virtual void Render()
     {
+        // When rendering, the simulation steps on its own thread and the bodies are drawn from the poses it publishes
+#ifndef RENDERING
 //         if(gScene)
 //         {
             StepPhysX();
 //         }
+#endif
 
         // Clear the color buffer
 #ifdef RENDERING
 #ifndef PHYSX_DEBUGGING       
-        RigidBody* Bone1 = (Globals::app)->conF->getCharacter()->getARBByName("pelvis"); 
-        Point3d Origin1(0, 0, 0);
-        Point3d BoneWorldFrame1(0, 0, 0);
-        BoneWorldFrame1 = Bone1->getWorldCoordinates(Origin1);
-        //Bone1 = NULL;
-        //m_GameCamera->m_pos = Vector3f(BoneWorldFrame1.getX()+3.0f, BoneWorldFrame1.getY(), BoneWorldFrame1.getZ()+3.0f);
+        //Point3d RootPos = (Globals::app)->conF->getCharacter()->getRoot()->getCMPosition();
+        //m_GameCamera->m_pos = Vector3f(RootPos.getX()+3.0f, RootPos.getY(), RootPos.getZ()+3.0f);
         m_GameCamera->m_target = Vector3f(-3.0f, 0, -3.0f);
         m_GameCamera->m_up = Vector3f(0.0f, 1.0f, 0);
         m_GameCamera->OnRender();
@@ -175,202 +154,20 @@ public:
         p.SetCamera(m_GameCamera->GetPos(), m_GameCamera->GetTarget(), m_GameCamera->GetUp());
         p.SetPerspectiveProj(m_persProjInfo);
         glDisable(GL_CULL_FACE);
-        m_FloorTechnique->Enable();
-        m_FloorTexture->Bind(GL_TEXTURE0); 
-
-        for(int i = 0; i < 40; ++i)
-        {
-            for(int j = 0; j < 40; ++j)
-            {
-                p.Rotate(-90.0f, 0.0f, 0.0f);
-                p.Scale(5.0f, 5.0f, 5.0f);
-                p.WorldPos(-200.0f + i * 10.0f, -0.0f, -200.0f + j * 10.0f);
-#ifdef LONG_LEG
-                p.WorldPos(-200.0f + i * 10.0f, -0.50f, -200.0f + j * 10.0f);
-#endif
-
-                m_FloorTechnique->SetWVP(p.GetWVPTrans());
-                m_FloorTechnique->SetWorldMatrix(p.GetWorldTrans());
-
-                m_Floor->Render();
-            }
-        }
+        m_Floor->Render(p.GetVPTrans());
 
         glEnable(GL_CULL_FACE);
-        RigidBody* Bone = NULL;
-        Point3d BoneWorldFrame(0, 0, 0);
-        Point3d Origin(0, 0, 0);
 
-
-
-        int i  = 0;
-        for(i = 0; i < 13; ++i)
+        // The bodies are bound to their meshes once per character, so a reloaded character is bound again
+        int PosesVersion = m_Simulation->getPoses(m_BodyPoses);
+        if(PosesVersion >= 0 && PosesVersion != m_BoundFrameworkVersion)
         {
-//             PxTransform BoxTrans = m_AF->mBodyNodes[i]->getBody()->getRigidBodyEntity()->getGlobalPose();
-//             Vector3f scaleFactor = m_AF->mBodyNodes[i]->getGeometry();
-            switch(i)
-            {
-                case 0: 
-                    {
-                        Bone = (Globals::app)->conF->getCharacter()->getARBByName("pelvis"); 
-                        break;
-                    }
-                case 1: 
-                    {
-                        Bone = (Globals::app)->conF->getCharacter()->getARBByName("torso"); 
-                        break;
-                    }
-                case 2: 
-                    {
-                        Bone = (Globals::app)->conF->getCharacter()->getARBByName("head"); 
-                        break;
-                    }
-                case 3: 
-                    {
-                        Bone = (Globals::app)->conF->getCharacter()->getARBByName("lUpperarm"); 
-                        break;
-                    }
-                case 4:
-                    {
-                        Bone = (Globals::app)->conF->getCharacter()->getARBByName("lLowerarm"); 
-                        break;
-                    }
-                case 5:
-                    {
-                        Bone = (Globals::app)->conF->getCharacter()->getARBByName("rUpperarm"); 
-                        break;
-                    }
-                case 6:
-                    {
-                        Bone = (Globals::app)->conF->getCharacter()->getARBByName("rLowerarm"); 
-                        break;
-                    }
-                case 7:
-                    {
-                        Bone = (Globals::app)->conF->getCharacter()->getARBByName("lUpperleg"); 
-                        break;
-                    }
-                case 8: 
-                    {
-                        Bone = (Globals::app)->conF->getCharacter()->getARBByName("lLowerleg");
-                        break;
-                    }
-                case 9:
-                    {
-                        Bone = (Globals::app)->conF->getCharacter()->getARBByName("rUpperleg"); 
-                        break;
-                    }
-                case 10:
-                    {
-                        Bone = (Globals::app)->conF->getCharacter()->getARBByName("rLowerleg"); 
-                        break;
-                    }
-                case 11: 
-                    {
-                        Bone = (Globals::app)->conF->getCharacter()->getARBByName("lFoot");
-                        break;
-                    }
-                case 12:
-                    {
-                        Bone = (Globals::app)->conF->getCharacter()->getARBByName("rFoot"); 
-                        break;
-                    }
-            }
-            BoneWorldFrame = Bone->getWorldCoordinates(Origin);
-            p.WorldPos(BoneWorldFrame.getX(), BoneWorldFrame.getY(), BoneWorldFrame.getZ());
-//             PxReal angle1, angle2, angle3;
-//             PxVec3 axis1(1.0, 0.0, 0.0), axis2(0.0, 1.0, 0.0), axis3(0.0, 0.0, 1.0);
-//             Quaternion q(BoxTrans.q.x, BoxTrans.q.y, BoxTrans.q.z, -BoxTrans.q.w);
-//             fout << Bone->getParentJoint()->getParentJointPosition().getX() << "\t" << Bone->getParentJoint()->getParentJointPosition().getY()
-//                 << "\t" << Bone->getParentJoint()->getParentJointPosition().getZ() << "\t";
-
-            Quaternion q = Bone->getOrientation().getComplexConjugate();
-            //Bone = NULL;
-           
-//             Quaternion q1;
-//             Bone->getParentJoint()->computeRelativeOrientation(q1);
-//             fout << q1.v.getX() << "\t" << q1.v.getY() << "\t" << q1.v.getZ() << "\t" << q1.s << endl;
-
-            p.Rotate(q);
-            p.Scale(1.0, 1.0, 1.0);
-
-#ifdef LONG_HAND
-            if(i == 4 || i == 6)
-            {
-                p.WorldPos(BoneWorldFrame.getX(), BoneWorldFrame.getY(), BoneWorldFrame.getZ());
-                p.Scale(1.3333, 3.0, 3.0);
-            }
-            if(i == 3 || i == 5)
-            {
-                p.WorldPos(BoneWorldFrame.getX(), BoneWorldFrame.getY(), BoneWorldFrame.getZ());
-                p.Scale(1.0, 3.0, 3.0);
-            }
-#endif
-
-#ifdef LONG_LEG
-            if(i == 8 || i == 10)
-            {
-                p.WorldPos(BoneWorldFrame.getX(), BoneWorldFrame.getY(), BoneWorldFrame.getZ());
-                p.Scale(1.0, 2.0, 1.0);
-            }
-#endif
+            BindCharacter();
+        }
 
-            m_LightingTechnique->Enable();
-            m_LightingTechnique->SetWVP(p.GetWVPTrans());
-            m_LightingTechnique->SetWorldMatrix(p.GetWorldTrans());
-            
-            switch(i)
-            {
-                case 0: Pelvis->Render(); break;
-                case 1: Torso->Render(); break;
-                case 2: Head->Render(); break;
-                case 3: lUpperarm->Render(); break;
-                case 4: lLowerarm->Render(); break;
-                case 5: rUpperarm->Render(); break;
-                case 6: rLowerarm->Render(); break;
-                case 7: lUpperleg->Render(); break;
-                case 8: lLowerleg->Render(); break;
-                case 9: rUpperleg->Render(); break;
-                case 10: rLowerleg->Render(); break;
-                case 11: lFoot->Render(); break;
-                case 12: rFoot->Render(); break;
-            }
-
-            glPolygonOffset(-1.0f, -1.0f);
-            glEnable(GL_POLYGON_OFFSET_LINE);
-            glEnable(GL_LINE_SMOOTH);
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-            glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-            glLineWidth(0.5f);
-
-            Vector3f vBlack = COLOR_BLACK;
-            m_WireframeTechnique->Enable();
-            m_WireframeTechnique->SetColor(vBlack);
-            m_WireframeTechnique->SetWVP(p.GetWVPTrans());
-            m_WireframeTechnique->SetWorldMatrix(p.GetWorldTrans());
-
-            switch(i)
-            {
-                case 0: Pelvis->Render(); break;
-                case 1: Torso->Render(); break;
-                case 2: Head->Render(); break;
-                case 3: lUpperarm->Render(); break;
-                case 4: lLowerarm->Render(); break;
-                case 5: rUpperarm->Render(); break;
-                case 6: rLowerarm->Render(); break;
-                case 7: lUpperleg->Render(); break;
-                case 8: lLowerleg->Render(); break;
-                case 9: rUpperleg->Render(); break;
-                case 10: rLowerleg->Render(); break;
-                case 11: lFoot->Render(); break;
-                case 12: rFoot->Render(); break;
-            }
-
-            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-            glDisable(GL_POLYGON_OFFSET_LINE);
-            glLineWidth(1.0f);
-            glDisable(GL_BLEND);
+        if(PosesVersion >= 0 && PosesVersion == m_BoundFrameworkVersion)
+        {
+            m_SkeletonRenderer->Render(p.GetVPTrans(), m_BodyPoses);
         }
 
         p.Scale(0.1f, 0.1f, 0.1f);
@@ -444,30 +241,22 @@ public:
         m_SkinningTechnique->SetDirectionalLight(m_DirectionLight);
         m_SkinningTechnique->SetMatSpecularPower(0);
 
-        m_FloorTechnique = new FloorTechnique();
-        if (!m_FloorTechnique->Init()) 
+        m_DirectionLight.Color = COLOR_WHITE;
+        // The floor is moved to the height of the ground of each character when it is bound
+        m_Floor = new Floor(Vector3f(-FLOOR_TILE_SIZE / 2.0f, 0.0f, -FLOOR_TILE_SIZE / 2.0f), FLOOR_SIZE, FLOOR_TILE_SIZE);
+        if (!m_Floor->Init("../Data/Texture/Floor.bmp", m_DirectionLight)) 
         {
-            printf("Error initializing the Floor technique\n");
+            printf("Error initializing the Floor\n");
             return false;
         }
-        m_DirectionLight.Color = COLOR_WHITE;
-        m_FloorTechnique->Enable();
-        m_FloorTechnique->SetDirectionalLight(m_DirectionLight);
-        m_FloorTechnique->SetTextureUnit(0);
 
-        m_LightingTechnique = new LightingTechnique();
-        if (!m_LightingTechnique->Init()) 
+        m_DirectionLight.Color = COLOR_PURPLE;
+        m_SkeletonRenderer = new SkeletonRenderer();
+        if (!m_SkeletonRenderer->Init(m_DirectionLight)) 
         {
-            printf("Error initializing the Lighting Technique\n");
+            printf("Error initializing the Skeleton renderer\n");
             return false;
         }
-        m_DirectionLight.Color = COLOR_PURPLE;
-        m_LightingTechnique->Enable();
-        m_LightingTechnique->SetDirectionalLight(m_DirectionLight);
-        m_LightingTechnique->SetTextureUnit(0);
-
-        m_WireframeTechnique = new WireFrameTechnique();
-        m_WireframeTechnique->Init();
 
 //         m_Skeleton = new MeshSkel();
 //         if (!m_Skeleton->LoadMesh("../Data/BVH/Boxing_Toes.bvh"))
@@ -475,12 +264,6 @@ public:
 //             return false;
 //         }
 
-        m_Floor = new Mesh();
-        if(!m_Floor->LoadMesh("../Data/OBJ/quad.obj"))
-        {
-            return false;
-        }
-
         AllocConsole();
 
 //         m_BoxMesh = new Mesh();
@@ -507,96 +290,17 @@ public:
 //             return false;
 //         }
 
-        Pelvis = new Mesh();
-        if(!Pelvis->LoadMesh("../Data/OBJ/pelvis_2_s.obj"))
-        {
-            return false;
-        }
-
-        Torso = new Mesh();
-        if(!Torso->LoadMesh("../Data/OBJ/torso_2_s_v2.obj"))
-        {
-            return false;
-        }
-
-        Head = new Mesh();
-        if(!Head->LoadMesh("../Data/OBJ/head_s.obj"))
-        {
-            return false;
-        }
-
-        lUpperarm = new Mesh();
-        if(!lUpperarm->LoadMesh("../Data/OBJ/lupperarm.obj"))
-        {
-            return false;
-        }
-
-        lLowerarm = new Mesh();
-        if(!lLowerarm->LoadMesh("../Data/OBJ/llowerarm.obj"))
-        {
-            return false;
-        }
-
-        rUpperarm = new Mesh();
-        if(!rUpperarm->LoadMesh("../Data/OBJ/rupperarm.obj"))
-        {
-            return false;
-        }
-        
-        rLowerarm = new Mesh();
-        if(!rLowerarm->LoadMesh("../Data/OBJ/rlowerarm.obj"))
-        {
-            return false;
-        }
-
-        lUpperleg = new Mesh();
-        if(!lUpperleg->LoadMesh("../Data/OBJ/lupperleg.obj"))
-        {
-            return false;
-        }
-
-        lLowerleg = new Mesh();
-        if(!lLowerleg->LoadMesh("../Data/OBJ/llowerleg.obj"))
-        {
-            return false;
-        }
-
-        rUpperleg = new Mesh();
-        if(!rUpperleg->LoadMesh("../Data/OBJ/rupperleg.obj"))
-        {
-            return false;
-        }
-
-        rLowerleg = new Mesh();
-        if(!rLowerleg->LoadMesh("../Data/OBJ/rlowerleg.obj"))
-        {
-            return false;
-        }
-
-        lFoot= new Mesh();
-        if(!lFoot->LoadMesh("../Data/OBJ/lfoot.obj"))
-        {
-            return false;
-        }
-
-        rFoot= new Mesh();
-        if(!rFoot->LoadMesh("../Data/OBJ/rfoot.obj"))
-        {
-            return false;
-        }
-
-        m_FloorTexture = new Texture(GL_TEXTURE_2D, "../Data/Texture/Floor.bmp");
-        if(!m_FloorTexture->Load(GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR_MIPMAP_LINEAR, GL_CLAMP_TO_EDGE))
-        {
-            return false;
-        }
-
         m_startTime = GetCurrentTimeMillis();
 
         Globals::app = new ControllerEditor();
 
         (Globals::app)->init();
 
+#ifdef RENDERING
+        m_Simulation = new SimulationThread(Globals::app);
+        m_Simulation->start();
+#endif
+
 //         std::vector<RealVector> data;
 //         ifstream dataFile;
 //         dataFile.open("../Data/Optimization/fwalk.in");
@@ -611,6 +315,15 @@ public:
         
         //RealVector point(23);
 #ifndef RENDERING
+        //every generation is simulated in parallel, one independent simulation per hardware thread
+        m_Evaluator = new ParallelEvaluator();
+        obj1.setParallelEvaluator(m_Evaluator);
+        //the points that were already simulated, in this run or in one that was stopped, are not simulated again. The results only
+        //carry over while the engine config, the input file and the files it loads stay the same
+        m_EvaluationCache = new EvaluationCache("../Data/Optimization/evaluations.cache");
+        m_EvaluationCache->addFileToContext("../controllerconfig.txt");
+        m_EvaluationCache->addConFileToContext(((ControllerEditor*)Globals::app)->inputFile);
+        obj1.setEvaluationCache(m_EvaluationCache);
         mocma.init(obj1);
 #endif
 
@@ -652,16 +365,30 @@ public:
         return true;
     }
 
+    // Binds the bodies of the current character to the meshes that draw them, and puts the floor
+    // at the height of its ground. How each mesh is placed and scaled comes from the .rbs file
+    void BindCharacter()
+    {
+        vector<BodyLayout> Layout;
+        double GroundHeight;
+        m_BoundFrameworkVersion = m_Simulation->getLayout(Layout, &GroundHeight);
+
+        m_Floor->SetHeight((float)GroundHeight);
+
+        if(!m_SkeletonRenderer->SetLayout(Layout))
+        {
+            printf("None of the bodies of the character can be drawn\n");
+        }
+    }
+
     void StepPhysX()					//Stepping PhysX
     { 
 
 
-#ifdef RENDERING
-        (Globals::app)->processTask();
-#else 
+#ifndef RENDERING
         mocma.step(obj1);
         stepNum++;
-        if(obj1.evaluationCounter() == 5010)
+        if(obj1.evaluationCounter() >= 5010)
         {
             exit(0);
         }
@@ -716,30 +443,17 @@ public:
 
 private:
     SkinningTechnique* m_SkinningTechnique;
-    FloorTechnique* m_FloorTechnique;
-    LightingTechnique* m_LightingTechnique;
-    WireFrameTechnique* m_WireframeTechnique;
+    SkeletonRenderer* m_SkeletonRenderer;
+    int m_BoundFrameworkVersion;
+    SimulationThread* m_Simulation;
+    vector<BodyPose> m_BodyPoses;
     MeshSkel* m_Skeleton;
-    Mesh* m_Floor;
+    Floor* m_Floor;
     Mesh* m_BoxMesh;
     Mesh* m_Box12Mesh;
     Mesh* m_Box13Mesh;
     Mesh* m_Box14Mesh;
     Mesh* m_Box32Mesh;
-    Mesh* Pelvis;
-    Mesh* Torso;
-    Mesh* Head;
-    Mesh* lUpperarm;
-    Mesh* lLowerarm;
-    Mesh* rUpperarm;
-    Mesh* rLowerarm;
-    Mesh* lUpperleg;
-    Mesh* lLowerleg;
-    Mesh* rUpperleg;
-    Mesh* rLowerleg;
-    Mesh* lFoot;
-    Mesh* rFoot;
-    Texture* m_FloorTexture;
     DirectionalLight m_DirectionLight;
     //PxScene* gScene;
 
@@ -749,7 +463,9 @@ private:
     Vector3f m_position;
     float m_scale;
     
-    MOCMA mocma;
+    ParallelMOCMA mocma;
     ObjectiveFunctions obj1;
+    ParallelEvaluator* m_Evaluator;
+    EvaluationCache* m_EvaluationCache;
     int stepNum;
 };
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <RigidBody.h>
+
+#include <vector>
+#include <string>
+#include <atomic>
+
+using namespace std;
+
+/**
+	The position of the center of mass and the orientation of one body, in world coordinates.
+*/
+struct BodyPose{
+	Point3d position;
+	Quaternion orientation;
+};
+
+/**
+	What the renderer needs to know about one body of the simulated character. The bodies are listed in the same order as
+	the poses of a snapshot.
+*/
+struct BodyLayout{
+	string name;
+	vector<RBMesh> meshes;
+};
+
+/**
+	The state of all the bodies of the character after one tick of the simulation.
+*/
+struct BodySnapshot{
+	//the value of Application::frameworkVersion when the snapshot was taken. Two snapshots describe the same bodies only if this is the same
+	int frameworkVersion;
+	//the wall clock time at which the snapshot was taken, in seconds
+	double time;
+	vector<BodyPose> poses;
+
+	BodySnapshot(){
+		frameworkVersion = -1;
+		time = 0;
+	}
+};
+
+//the bits of the shared slot of a BodySnapshotBuffer: the index of the snapshot, and whether it was published since the reader last took it
+#define SNAPSHOT_INDEX_MASK		3
+#define SNAPSHOT_FRESH			4
+
+/**
+	This class hands the snapshots of one writer (the simulation thread) to one reader (the render thread) without any locks. Each side
+	owns one of the three snapshots, and the third one is exchanged atomically: the writer fills its snapshot and swaps it with the
+	shared one, and the reader swaps its own snapshot with the shared one only when something new was published. Neither side ever
+	waits for the other, and the reader always gets the most recent snapshot that was completely written.
+*/
+class BodySnapshotBuffer{
+private:
+	BodySnapshot snapshots[3];
+	//the snapshot that neither side holds, with SNAPSHOT_FRESH set if the writer put it there after the reader last took one
+	atomic<int> shared;
+	//the snapshot that is being written, only used by the writer
+	int back;
+	//the snapshot that is being read, only used by the reader
+	int front;
+
+public:
+	BodySnapshotBuffer() : shared(1){
+		back = 0;
+		front = 2;
+	}
+
+	/**
+		returns the snapshot the writer fills in - it is not seen by the reader until it is published
+	*/
+	inline BodySnapshot& getBack(){
+		return snapshots[back];
+	}
+
+	/**
+		hands the snapshot that was filled in to the reader, and gives the writer a new one to fill
+	*/
+	inline void publish(){
+		back = shared.exchange(back | SNAPSHOT_FRESH) & SNAPSHOT_INDEX_MASK;
+	}
+
+	/**
+		takes the most recently published snapshot, if there is one the reader has not seen yet. Returns false otherwise, in which case
+		the front snapshot does not change.
+	*/
+	inline bool acquire(){
+		if ((shared.load() & SNAPSHOT_FRESH) == 0)
+			return false;
+		front = shared.exchange(front) & SNAPSHOT_INDEX_MASK;
+		return true;
+	}
+
+	/**
+		returns the snapshot the reader took last
+	*/
+	inline const BodySnapshot& getFront() const{
+		return snapshots[front];
+	}
+};
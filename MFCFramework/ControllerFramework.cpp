@@ -31,6 +31,7 @@
 #include <windows.h>
 #include <conio.h>
 #include <iostream>
+#include <fstream>
 
 
 /**
@@ -40,6 +41,7 @@ ControllerEditor::ControllerEditor(void)
 {
 	strcpy(inputFile,  "..\\Data\\init\\input.conF");
     this->world = NULL;
+    conF = NULL;
 
 	loadFramework();
 
@@ -52,6 +54,14 @@ ControllerEditor::ControllerEditor(void)
     stepNum = 0;
     FootSize = Vector3d(0, 0, 0);
     nextControlShotToWrite = 0;
+    lastRolloutHash = 0;
+
+    //a candidate that trips one of these would fall anyway, so it gets the same penalty as a fall, only sooner
+    abortPredicates.addPredicate(new DivergenceAbort());
+    abortPredicates.addPredicate(new COMHeightAbort());
+    abortPredicates.addPredicate(new TorsoTiltAbort());
+    abortPredicates.addPredicate(new NoProgressAbort());
+    abortFailingRollouts = false;
 }
 
 
@@ -77,8 +87,11 @@ void ControllerEditor::loadFramework(){
  * This method is used to create a physical world and load the objects in it.
  */
 void ControllerEditor::loadFramework( int controlShot ){
-    if(this->world != NULL) this->world->destroyAllObjects();
+	//the framework owns its world, so this gets rid of the old world as well
+	delete conF;
+	conF = NULL;
 	this->world = NULL;
+	frameworkVersion++;
 	//create a new world, and load some bodies
 	try{
 		if( controlShot < 0 ) {
@@ -87,7 +100,6 @@ void ControllerEditor::loadFramework( int controlShot ){
 		else {
 			char conFile[256];
 			sprintf(conFile, "..\\controlShots\\cs%05d.sbc", controlShot);
-            delete conF;
 			conF = new SimBiConFramework(inputFile, conFile);
 		}
 		avgSpeed = 0;
@@ -219,6 +231,7 @@ void ControllerEditor::restart(){
 	conF->setState(conState);
 	avgSpeed = 0;
 	timesVelSampled = 0;
+	abortPredicates.reset(conF->getCharacter());
 }
 
 
@@ -441,6 +454,29 @@ void ControllerEditor::reloadParameters(vector<double> OptimizedParameters)
     states.clear();
 }
 
+/**
+	This method saves the current reduced character state and the optimized parameters, together with the foot step
+	size they produced, as control shot number shotIndex.
+*/
+void ControllerEditor::saveOptimizationShot(int shotIndex, const vector<double>& OptimizedParameters, const Vector3d& footSize)
+{
+    char stateFileName[100]="";
+    char fileName[100]="";
+
+    sprintf(stateFileName, "../Data/controlShots/controlshots%05d.rs", shotIndex);
+    conF->getCharacter()->saveReducedStateToFile(stateFileName);
+
+    sprintf(fileName, "../Data/controlShots/controlshots%05d.sbc", shotIndex);
+    ofstream resFile;
+    resFile.open(fileName);
+    for(size_t j = 0; j < OptimizedParameters.size(); ++j)
+    {
+        resFile << OptimizedParameters[j] << std::endl;
+    }
+    resFile << footSize.x << " " << footSize.z << endl;
+    resFile.close();
+}
+
 Vector3d ControllerEditor::processTask()
 {
 	double simulationTime = 0;
@@ -453,7 +489,9 @@ Vector3d ControllerEditor::processTask()
 		double phi = conF->getController()->getPhase();
 		lastFSMState = conF->getController()->getFSMState();
 		double signChange = (conF->getController()->getStance() == RIGHT_STANCE)?-1:1;
-		Globals::targetPosePhase = phi;
+		//only the editor that is on screen drives the displayed phase - the optimization workers have their own editors
+		if (Globals::app == this)
+			Globals::targetPosePhase = phi;
 		//Tcl_UpdateLinkedVar( Globals::tclInterpreter, "targetPosePhase" );
 
 //		tprintf("d = %2.4lf, v = %2.4lf\n", conF->con->d.x, conF->con->v.x);
@@ -601,6 +639,12 @@ Vector3d ControllerEditor::processTask()
 				    break;
 			    }
             //}
+            if (abortFailingRollouts && abortPredicates.check(conF->getCharacter(), SimGlobals::dt) != NULL)
+            {
+                FootSize = Vector3d((23-stepNum)*100000, 0, (23-stepNum)*100000);
+                stepNum = 23;
+                break;
+            }
             if(stepNum > 20)
             {
                 restart();
@@ -614,10 +658,14 @@ Vector3d ControllerEditor::processTask()
 
 Vector3d ControllerEditor::TenStep(int& controlShotToWrite)
 {
+    abortPredicates.reset(conF->getCharacter());
+    abortFailingRollouts = true;
     while(stepNum < 23)
     {
         processTask();
     }
+    abortFailingRollouts = false;
+    lastRolloutHash = conF->getWorld()->getStepHash();
     stepNum = 0;
     FootSize.x /= 20;
     FootSize.y /= 20;
@@ -21,7 +21,10 @@
 	If not, see <http://www.gnu.org/licenses/>.
 */
 
+#pragma once
+
 #include <SimBiConFramework.h>
+#include <RolloutAbort.h>
 #include "Application.h"
 #include <Trajectory.h>
 #include <Vector3d.h>
@@ -43,6 +46,13 @@ public:
 
     int stepNum;
     Vector3d FootSize;
+	//the step hash of the world at the end of the last TenStep rollout. It is only computed in deterministic mode (see World),
+	//and it is the same for two rollouts only if they went exactly the same way
+	unsigned long long lastRolloutHash;
+	//the tests that stop a TenStep rollout as soon as the character is bound to fall, instead of simulating it until it does
+	RolloutAbortSet abortPredicates;
+	//this is true while TenStep runs - the rollouts that are watched on screen are never stopped early
+	bool abortFailingRollouts;
 //     ObjectiveFunctions obj1;
 //     shark::MOCMA mocma;
 
@@ -143,6 +153,12 @@ public:
 
     virtual void reloadParameters(vector<double> OptimizedParameters);
 
+	/**
+		This method saves the current reduced character state and the optimized parameters, together with the foot step
+		size they produced, as control shot number shotIndex.
+	*/
+	void saveOptimizationShot(int shotIndex, const vector<double>& OptimizedParameters, const Vector3d& footSize);
+
 	/**
      *	This method is used when a mouse event gets generated. This method returns true if the message gets processed, false otherwise.
 	 */
@@ -0,0 +1,142 @@
+#include "stdafx.h"
+
+#include "EvaluationCache.h"
+#include <PUtils.h>
+#include <ConUtils.h>
+#include <math.h>
+
+/**
+	this method adds the n bytes passed in to the hash h (64 bit FNV-1a)
+*/
+static unsigned long long hashBytes(unsigned long long h, const void* data, size_t n){
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i=0;i<n;i++){
+		h ^= bytes[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+/**
+	Constructor - the results already in the file are loaded, and the new ones are appended to it. If tolerance is positive,
+	the parameters are rounded to a multiple of it before they are looked up.
+*/
+EvaluationCache::EvaluationCache(const char* fileName, double tolerance){
+	this->tolerance = tolerance;
+	contextHash = 14695981039346656037ULL;
+
+	loadFromFile(fileName);
+	cacheFile = fopen(fileName, "a");
+	if (cacheFile == NULL)
+		printf("Cannot open the evaluation cache %s - the results will not be saved\n", fileName);
+}
+
+/**
+	Destructor
+*/
+EvaluationCache::~EvaluationCache(void){
+	if (cacheFile != NULL)
+		fclose(cacheFile);
+}
+
+/**
+	This method reads all the results that are in the file passed in as a parameter.
+*/
+void EvaluationCache::loadFromFile(const char* fileName){
+	FILE* f = fopen(fileName, "r");
+	if (f == NULL)
+		return;
+
+	char buffer[200];
+	while (fgets(buffer, 200, f) != NULL){
+		unsigned long long key;
+		Vector3d footSize;
+		//a line that is cut short (the optimization was killed while it was being written) is simply skipped
+		if (sscanf(buffer, "%llx %lf %lf %lf", &key, &footSize.x, &footSize.y, &footSize.z) == 4)
+			results[key] = footSize;
+	}
+	fclose(f);
+}
+
+/**
+	This method adds the content of the file passed in as a parameter to the context of the results. If the file is missing, its
+	name is used instead.
+*/
+void EvaluationCache::addFileToContext(const char* fileName){
+	FILE* f = fopen(fileName, "rb");
+	if (f == NULL){
+		contextHash = hashBytes(contextHash, fileName, strlen(fileName));
+		return;
+	}
+
+	char buffer[4096];
+	size_t n;
+	while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0)
+		contextHash = hashBytes(contextHash, buffer, n);
+	fclose(f);
+}
+
+/**
+	This method adds the content of the input file of a SimBiConFramework to the context of the results, together with the
+	content of the .rbs and .sbc files that it loads.
+*/
+void EvaluationCache::addConFileToContext(const char* fileName){
+	addFileToContext(fileName);
+
+	FILE* f = fopen(fileName, "r");
+	if (f == NULL)
+		return;
+
+	char buffer[200];
+	while (fgets(buffer, 200, f) != NULL){
+		char* line = lTrim(buffer);
+		int lineType = getConLineType(line);
+		if (lineType == LOAD_RB_FILE || lineType == LOAD_CON_FILE)
+			addFileToContext(trim(line));
+	}
+	fclose(f);
+}
+
+/**
+	This method returns the key of the set of parameters passed in as a parameter.
+*/
+unsigned long long EvaluationCache::getKey(const vector<double>& params){
+	unsigned long long h = contextHash;
+	int count = (int)params.size();
+	h = hashBytes(h, &count, sizeof(count));
+	for (size_t i=0;i<params.size();i++){
+		if (tolerance > 0){
+			long long q = (long long)floor(params[i] / tolerance + 0.5);
+			h = hashBytes(h, &q, sizeof(q));
+		}else{
+			//0 and -0 are the same parameter
+			double p = (params[i] == 0) ? 0 : params[i];
+			h = hashBytes(h, &p, sizeof(p));
+		}
+	}
+	return h;
+}
+
+/**
+	This method returns true and sets footSize if the result for this set of parameters is known, and returns false otherwise.
+*/
+bool EvaluationCache::lookUp(const vector<double>& params, Vector3d* footSize){
+	map<unsigned long long, Vector3d>::iterator it = results.find(getKey(params));
+	if (it == results.end())
+		return false;
+	*footSize = it->second;
+	return true;
+}
+
+/**
+	This method stores the result of a set of parameters, in memory and in the file.
+*/
+void EvaluationCache::store(const vector<double>& params, const Vector3d& footSize){
+	unsigned long long key = getKey(params);
+	results[key] = footSize;
+	if (cacheFile == NULL)
+		return;
+	//the values are written with enough digits to be read back exactly
+	fprintf(cacheFile, "%016llx %.17g %.17g %.17g\n", key, footSize.x, footSize.y, footSize.z);
+	fflush(cacheFile);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <Vector3d.h>
+
+#include <stdio.h>
+#include <vector>
+#include <map>
+
+using namespace std;
+
+/**
+	This class remembers the foot step size that each set of controller parameters produced, so that a point the optimizer has
+	already tried does not need to be simulated again. The results are appended to a file as soon as they are known, so they
+	survive the optimization being killed, and a restarted optimization skips every point that was already evaluated.
+
+	A result is only found again if the simulation is set up exactly as it was when it was stored: the key of an entry is a hash
+	of the parameters together with the content of the files that define the simulation (see addFileToContext). The rollouts
+	need to be repeatable for the cached results to stand in for new ones, so the cache is meant to be used with the
+	deterministic mode of the physics (see World::isDeterministic).
+*/
+class EvaluationCache{
+private:
+	//the foot step sizes that are known, by key
+	map<unsigned long long, Vector3d> results;
+	//the file the new results are appended to
+	FILE* cacheFile;
+	//if this is positive, the parameters are rounded to a multiple of it, so points closer than that share their result
+	double tolerance;
+	//the hash of everything, other than the parameters, that decides the outcome of a rollout
+	unsigned long long contextHash;
+
+	/**
+		This method reads all the results that are in the file passed in as a parameter.
+	*/
+	void loadFromFile(const char* fileName);
+
+	/**
+		This method returns the key of the set of parameters passed in as a parameter.
+	*/
+	unsigned long long getKey(const vector<double>& params);
+
+public:
+	/**
+		Constructor - the results already in the file are loaded, and the new ones are appended to it. If tolerance is positive,
+		the parameters are rounded to a multiple of it before they are looked up.
+	*/
+	EvaluationCache(const char* fileName, double tolerance = 0);
+
+	/**
+		Destructor
+	*/
+	~EvaluationCache(void);
+
+	/**
+		This method adds the content of the file passed in as a parameter to the context of the results. If the file is missing, its
+		name is used instead.
+	*/
+	void addFileToContext(const char* fileName);
+
+	/**
+		This method adds the content of the input file of a SimBiConFramework to the context of the results, together with the
+		content of the .rbs and .sbc files that it loads.
+	*/
+	void addConFileToContext(const char* fileName);
+
+	/**
+		This method returns true and sets footSize if the result for this set of parameters is known, and returns false otherwise.
+	*/
+	bool lookUp(const vector<double>& params, Vector3d* footSize);
+
+	/**
+		This method stores the result of a set of parameters, in memory and in the file.
+	*/
+	void store(const vector<double>& params, const Vector3d& footSize);
+
+	/**
+		Returns the number of results that are known
+	*/
+	inline int getResultCount(){
+		return (int)results.size();
+	}
+};
@@ -0,0 +1,108 @@
+/*
+
+	Copyright 2014 Rudy Snow
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stdafx.h"
+
+#include "Floor.h"
+#include "Pipeline.h"
+#include "GLUtil.h"
+
+Floor::Floor(const Vector3f& Center, float Size, float TileSize)
+{
+    m_Center = Center;
+    m_Size = Size;
+    UpdateWorldTransform();
+
+    m_TexScale = Size / TileSize;
+
+    m_pFloorTechnique = NULL;
+    m_pTexture = NULL;
+    m_pMesh = NULL;
+}
+
+
+Floor::~Floor()
+{
+    SAFE_DELETE(m_pFloorTechnique);
+    SAFE_DELETE(m_pTexture);
+    SAFE_DELETE(m_pMesh);
+}
+
+
+bool Floor::Init(const string& TextureFilename, const DirectionalLight& Light)
+{
+    m_pFloorTechnique = new FloorTechnique();
+
+    if (!m_pFloorTechnique->Init()) 
+    {
+        printf("Error initializing the Floor technique\n");
+        return false;
+    }
+
+    m_pFloorTechnique->Enable();
+    m_pFloorTechnique->SetDirectionalLight(Light);
+    m_pFloorTechnique->SetTextureUnit(0);
+    m_pFloorTechnique->SetTextureScale(m_TexScale);
+    m_pFloorTechnique->SetWorldMatrix(m_World);
+
+    // The texture coordinates go past 1, so the texture has to repeat rather than clamp
+    m_pTexture = new Texture(GL_TEXTURE_2D, TextureFilename.c_str());
+
+    if (!m_pTexture->Load(GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR_MIPMAP_LINEAR, GL_REPEAT)) 
+    {
+        return false;
+    }
+
+    m_pMesh = new Mesh();
+
+    return m_pMesh->LoadMesh("../Data/OBJ/quad.obj");
+}
+
+void Floor::UpdateWorldTransform()
+{
+    // quad.obj spans [-1, 1] in the XY plane, so it is laid down on the ground and scaled
+    // to half the size of the floor
+    Pipeline p;
+    p.Rotate(-90.0f, 0.0f, 0.0f);
+    p.Scale(m_Size / 2.0f, m_Size / 2.0f, m_Size / 2.0f);
+    p.WorldPos(m_Center);
+    m_World = p.GetWorldTrans();
+}
+
+
+void Floor::SetHeight(float Height)
+{
+    m_Center.y = Height;
+    UpdateWorldTransform();
+
+    if (m_pFloorTechnique)
+    {
+        m_pFloorTechnique->Enable();
+        m_pFloorTechnique->SetWorldMatrix(m_World);
+    }
+}
+
+
+void Floor::Render(const Matrix4f& VP)
+{
+    m_pFloorTechnique->Enable();
+    m_pFloorTechnique->SetWVP(VP * m_World);
+    m_pTexture->Bind(GL_TEXTURE0);
+
+    m_pMesh->Render();
+}
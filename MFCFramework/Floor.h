@@ -0,0 +1,54 @@
+/*
+
+	Copyright 2014 Rudy Snow
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FLOOR_H
+#define	FLOOR_H
+
+#include "FloorTechnique.h"
+#include "Texture.h"
+#include "MeshLoader.h"
+
+// The ground is a single quad that covers the whole floor. Its texture is repeated once per
+// tile, so the whole floor costs one draw call however many tiles it has.
+class Floor
+{
+public:
+    Floor(const Vector3f& Center, float Size, float TileSize);
+
+    ~Floor();
+
+    bool Init(const string& TextureFilename, const DirectionalLight& Light);
+
+    void Render(const Matrix4f& VP);
+
+    // Moves the floor up or down, so that it is drawn where the ground of the simulation is
+    void SetHeight(float Height);
+
+private:
+    void UpdateWorldTransform();
+
+    FloorTechnique* m_pFloorTechnique;
+    Texture* m_pTexture;
+    Mesh* m_pMesh;
+    Vector3f m_Center;
+    float m_Size;
+    Matrix4f m_World;
+    float m_TexScale;
+};
+
+#endif	/* FLOOR_H */
@@ -54,6 +54,7 @@ bool FloorTechnique::Init()
     m_LightWVPLocation = GetUniformLocation("gLightWVP");
     m_WorldMatrixLocation = GetUniformLocation("gWorld");
     m_samplerLocation = GetUniformLocation("gSampler");
+    m_texScaleLocation = GetUniformLocation("gTexScale");
     m_shadowMapLocation = GetUniformLocation("gShadowMap");
     m_eyeWorldPosLocation = GetUniformLocation("gEyeWorldPos");
     m_dirLightLocation.Color = GetUniformLocation("gDirectionalLight.Base.Color");
@@ -69,6 +70,7 @@ bool FloorTechnique::Init()
         m_WVPLocation == INVALID_UNIFORM_LOCATION ||
         m_LightWVPLocation == INVALID_UNIFORM_LOCATION ||
         m_WorldMatrixLocation == INVALID_UNIFORM_LOCATION ||
+        m_texScaleLocation == INVALID_UNIFORM_LOCATION ||
         m_samplerLocation == INVALID_UNIFORM_LOCATION ||
         m_shadowMapLocation == INVALID_UNIFORM_LOCATION ||
         m_eyeWorldPosLocation == INVALID_UNIFORM_LOCATION ||
@@ -192,6 +194,12 @@ void FloorTechnique::SetTextureUnit(unsigned int TextureUnit)
 }
 
 
+void FloorTechnique::SetTextureScale(float Scale)
+{
+    glUniform1f(m_texScaleLocation, Scale);
+}
+
+
 void FloorTechnique::SetShadowMapTextureUnit(unsigned int TextureUnit)
 {
     glUniform1i(m_shadowMapLocation, TextureUnit);
@@ -27,8 +27,9 @@
 
 //#define CHECK_BVH_UNIFORM_STATUS
 
-LightingTechnique::LightingTechnique()
+LightingTechnique::LightingTechnique(bool Instanced)
 {   
+    m_Instanced = Instanced;
 }
 
 bool LightingTechnique::Init()
@@ -37,7 +38,7 @@ bool LightingTechnique::Init()
         return false;
     }
 
-    if (!AddShader(GL_VERTEX_SHADER, "../Data/GLEffects/Lighting.vp")) 
+    if (!AddShader(GL_VERTEX_SHADER, m_Instanced ? "../Data/GLEffects/Instanced.vp" : "../Data/GLEffects/Lighting.vp")) 
     {
         return false;
     }
@@ -55,6 +56,10 @@ bool LightingTechnique::Init()
     m_WVPLocation = GetUniformLocation("gWVP");
     m_LightWVPLocation = GetUniformLocation("gLightWVP");
     m_WorldMatrixLocation = GetUniformLocation("gWorld");
+    m_VPLocation = GetUniformLocation("gVP");
+    m_transformsLocation = GetUniformLocation("gTransforms");
+    m_baseInstanceLocation = GetUniformLocation("gBaseInstance");
+    m_LightVPLocation = GetUniformLocation("gLightVP");
     m_samplerLocation = GetUniformLocation("gSampler");
     m_shadowMapLocation = GetUniformLocation("gShadowMap");
     m_eyeWorldPosLocation = GetUniformLocation("gEyeWorldPos");
@@ -194,6 +199,30 @@ void LightingTechnique::SetWorldMatrix(const Matrix4f& WorldInverse)
 }
 
 
+void LightingTechnique::SetVP(const Matrix4f& VP)
+{
+    glUniformMatrix4fv(m_VPLocation, 1, GL_TRUE, (const GLfloat*)VP.m);
+}
+
+
+void LightingTechnique::SetTransformTextureUnit(unsigned int TextureUnit)
+{
+    glUniform1i(m_transformsLocation, TextureUnit);
+}
+
+
+void LightingTechnique::SetBaseInstance(unsigned int BaseInstance)
+{
+    glUniform1i(m_baseInstanceLocation, BaseInstance);
+}
+
+
+void LightingTechnique::SetLightVP(const Matrix4f& LightVP)
+{
+    glUniformMatrix4fv(m_LightVPLocation, 1, GL_TRUE, (const GLfloat*)LightVP.m);
+}
+
+
 void LightingTechnique::SetTextureUnit(unsigned int TextureUnit)
 {
     glUniform1i(m_samplerLocation, TextureUnit);
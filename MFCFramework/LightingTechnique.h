@@ -31,7 +31,9 @@ public:
     static const unsigned int MAX_POINT_LIGHTS = 2;
     static const unsigned int MAX_SPOT_LIGHTS = 2;
 
-    LightingTechnique();
+    // An instanced technique fetches the world matrices from a TransformBuffer (see
+    // Mesh::RenderInstanced), and only takes the view-projection as a uniform
+    LightingTechnique(bool Instanced = false);
 
     virtual ~LightingTechnique() {}
     
@@ -40,6 +42,10 @@ public:
     void SetWVP(const Matrix4f& WVP);
     void SetLightWVP(const Matrix4f& LightWVP);
     void SetWorldMatrix(const Matrix4f& WVP);
+    void SetVP(const Matrix4f& VP);
+    void SetTransformTextureUnit(unsigned int TextureUnit);
+    void SetBaseInstance(unsigned int BaseInstance);
+    void SetLightVP(const Matrix4f& LightVP);
     void SetTextureUnit(unsigned int TextureUnit);
     void SetShadowMapTextureUnit(unsigned int TextureUnit);
     void SetDirectionalLight(const DirectionalLight& Light);
@@ -51,7 +57,13 @@ public:
 
 private:
 
+    bool m_Instanced;
+
     GLuint m_WVPLocation;
+    GLuint m_VPLocation;
+    GLuint m_transformsLocation;
+    GLuint m_baseInstanceLocation;
+    GLuint m_LightVPLocation;
     GLuint m_LightWVPLocation;
     GLuint m_WorldMatrixLocation;
     GLuint m_samplerLocation;
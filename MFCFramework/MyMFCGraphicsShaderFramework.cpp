@@ -10,6 +10,8 @@
 
 #include "MyMFCGraphicsShaderFrameworkDoc.h"
 #include "MyMFCGraphicsShaderFrameworkView.h"
+#include <World.h>
+#include <Profiler.h>
 
 #ifdef _DEBUG
 #define new DEBUG_NEW
@@ -82,6 +84,10 @@ BOOL CMyMFCGraphicsShaderFrameworkApp::InitInstance()
 
 	AfxEnableControlContainer();
 
+	//'profile' on the engine line of controllerconfig.txt times the phases of every simulation step, and reports them when the program exits
+	if (World::isEngineOptionSet("profile"))
+		Profiler::reportAtExit("../profile.json");
+
 	EnableTaskbarInteraction(FALSE);
 
 	// AfxInitRichEdit2() is required to use RichEdit control	
@@ -6,6 +6,8 @@
 #include <shark/Rng/GlobalRng.h>
 
 #include "ControllerFramwork.h"
+#include "ParallelEvaluator.h"
+#include "EvaluationCache.h"
 
 #include <time.h>
 #include <windows.h>
@@ -28,7 +30,7 @@ namespace shark {
     {
     public:
         ObjectiveFunctions(std::size_t dimensions = 27, std::size_t objectives = 2)
-            :m_dimensions(dimensions), m_objectives(objectives)
+            :m_dimensions(dimensions), m_objectives(objectives), m_parallelEvaluator(NULL), m_evaluationCache(NULL)
         {
             m_features |= CAN_PROPOSE_STARTING_POINT;
         }
@@ -60,6 +62,18 @@ namespace shark {
             file.close();
         }
 
+        /// Attaches the evaluator used by evalBatch. Without one, batches are evaluated one point at a time on Globals::app.
+        void setParallelEvaluator( ParallelEvaluator* evaluator )
+        {
+            m_parallelEvaluator = evaluator;
+        }
+
+        /// Attaches the cache that eval and evalBatch look the points up in before simulating them, and store the new results in.
+        void setEvaluationCache( EvaluationCache* cache )
+        {
+            m_evaluationCache = cache;
+        }
+
         ResultType eval( const SearchPointType & input )const 
         {
             m_evaluationCounter++;
@@ -78,31 +92,25 @@ namespace shark {
                 _cprintf("%lf ", input(i));
                 tmpp.push_back(input(i));
             }
-            (Globals::app)->reloadParameters(tmpp);
             _cprintf("\n\n");
+            //the control shots need the state the rollout ends in, so those points are always simulated
+            bool writeControlShot = (m_evaluationCounter >= 5000 && m_evaluationCounter <= 5009);
             int controlShotToWrite = 0;
-            Vector3d footSize = (Globals::app)->TenStep(controlShotToWrite);
+            Vector3d footSize;
+            if(writeControlShot || m_evaluationCache == NULL || !m_evaluationCache->lookUp(tmpp, &footSize))
+            {
+                (Globals::app)->reloadParameters(tmpp);
+                footSize = (Globals::app)->TenStep(controlShotToWrite);
+                if(m_evaluationCache != NULL)
+                    m_evaluationCache->store(tmpp, footSize);
+            }
+            else
+                _cprintf("cached\n");
             _cprintf("output: %lf %lf %lf\n\n", footSize.x, footSize.y, footSize.z);
-            ResultType result(m_objectives);
-            result(0) = abs(footSize.x*1000 - 300);
-            result(1) = abs(footSize.z*1000 - 100);
-            if(m_evaluationCounter >= 5000 && m_evaluationCounter <= 5009)
+            ResultType result = objectivesFromFootSize(footSize);
+            if(writeControlShot)
             {
-                char stateFileName[100]="";
-                char fileName[100]="";
-
-                sprintf(stateFileName, "../Data/controlShots/controlshots%05d.rs", controlShotToWrite);
-                (Globals::app)->conF->getCharacter()->saveReducedStateToFile(stateFileName);                
-                
-                sprintf(fileName, "../Data/controlShots/controlshots%05d.sbc", controlShotToWrite);
-                ofstream resFile;
-                resFile.open(fileName);
-                for(size_t j = 0; j < 27; ++j)
-                {
-                    resFile << input[j] << std::endl;		
-                }
-                resFile << footSize.x << " " << footSize.z << endl;
-                resFile.close();
+                ((ControllerEditor*)Globals::app)->saveOptimizationShot(controlShotToWrite, tmpp, footSize);
             }
 
             _cprintf("res: %lf %lf\n\n", result(0), result(1));
@@ -111,7 +119,79 @@ namespace shark {
             //system("pause");
             return result;
         }
+
+        /// Evaluates a whole generation of search points. With a parallel evaluator attached, the points are spread over
+        /// its independent simulations; results[i] always belongs to inputs[i].
+        void evalBatch( const std::vector<SearchPointType> & inputs, std::vector<ResultType> & results )const
+        {
+            results.resize(inputs.size());
+            if(m_parallelEvaluator == NULL)
+            {
+                for(std::size_t i = 0; i < inputs.size(); ++i)
+                    results[i] = eval(inputs[i]);
+                return;
+            }
+
+            vector<vector<double> > params(inputs.size());
+            vector<int> controlShots(inputs.size(), -1);
+            for(std::size_t i = 0; i < inputs.size(); ++i)
+            {
+                m_evaluationCounter++;
+                for(std::size_t j = 0; j < m_dimensions; ++j)
+                    params[i].push_back(inputs[i](j));
+                //eval numbers its control shots with the index TenStep cycles through (nextControlShotToWrite, 0..9), which
+                //only depends on the order of the rollouts. The workers of a batch finish in any order, so here the number
+                //comes from the evaluation counter instead: evaluation 5000+k is saved as control shot k
+                if(m_evaluationCounter >= 5000 && m_evaluationCounter <= 5009)
+                    controlShots[i] = (int)m_evaluationCounter - 5000;
+            }
+
+            //only the points whose result is not known yet are simulated
+            vector<Vector3d> footSizes(inputs.size());
+            vector<std::size_t> toSimulate;
+            for(std::size_t i = 0; i < inputs.size(); ++i)
+            {
+                if(controlShots[i] >= 0 || m_evaluationCache == NULL || !m_evaluationCache->lookUp(params[i], &footSizes[i]))
+                    toSimulate.push_back(i);
+            }
+
+            vector<vector<double> > simulatedParams(toSimulate.size());
+            vector<int> simulatedControlShots(toSimulate.size());
+            for(std::size_t i = 0; i < toSimulate.size(); ++i)
+            {
+                simulatedParams[i] = params[toSimulate[i]];
+                simulatedControlShots[i] = controlShots[toSimulate[i]];
+            }
+            vector<Vector3d> simulatedFootSizes;
+            m_parallelEvaluator->evaluate(simulatedParams, simulatedFootSizes, &simulatedControlShots);
+            for(std::size_t i = 0; i < toSimulate.size(); ++i)
+            {
+                footSizes[toSimulate[i]] = simulatedFootSizes[i];
+                if(m_evaluationCache != NULL)
+                    m_evaluationCache->store(simulatedParams[i], simulatedFootSizes[i]);
+            }
+            if(m_evaluationCache != NULL)
+                _cprintf("%d of %d points were cached\n", (int)(inputs.size() - toSimulate.size()), (int)inputs.size());
+
+            for(std::size_t i = 0; i < inputs.size(); ++i)
+            {
+                results[i] = objectivesFromFootSize(footSizes[i]);
+                _cprintf("%d: output: %lf %lf %lf res: %lf %lf\n", (int)(m_evaluationCounter - inputs.size() + i + 1),
+                    footSizes[i].x, footSizes[i].y, footSizes[i].z, results[i](0), results[i](1));
+            }
+        }
     private:
+        /// Turns the average foot step size of a rollout into the objective vector.
+        ResultType objectivesFromFootSize( const Vector3d & footSize )const
+        {
+            ResultType result(m_objectives);
+            result(0) = abs(footSize.x*1000 - 300);
+            result(1) = abs(footSize.z*1000 - 100);
+            return result;
+        }
+
+        ParallelEvaluator* m_parallelEvaluator;
+        EvaluationCache* m_evaluationCache;
         double m_a;
         std::size_t m_dimensions;
         std::size_t m_objectives;
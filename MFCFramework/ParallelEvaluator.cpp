@@ -0,0 +1,159 @@
+#include "stdafx.h"
+
+#include "ParallelEvaluator.h"
+#include <PhysicsGlobals.h>
+
+//building and tearing down a simulation goes through the PhysX SDK and the shared globals, so only one worker at a time does it
+static mutex editorLifetimeLock;
+
+/**
+	Constructor - starts workerCount workers. If workerCount is not positive, one worker per hardware thread is used. The workers
+	already keep all the cores busy, so by default the scene of each one only gets a single PhysX dispatcher thread. This only
+	applies to the scenes of the workers, the setting in PhysicsGlobals is left as it is.
+*/
+ParallelEvaluator::ParallelEvaluator(int workerCount, int physXThreadsPerWorker){
+	if (workerCount <= 0)
+		workerCount = (int)thread::hardware_concurrency();
+	if (workerCount <= 0)
+		workerCount = 1;
+
+	this->physXThreadsPerWorker = physXThreadsPerWorker;
+
+	batchParams = NULL;
+	batchControlShots = NULL;
+	batchResults = NULL;
+	batchID = 0;
+	nextCandidate = 0;
+	busyWorkers = 0;
+	readyWorkers = 0;
+	shuttingDown = false;
+
+	editors.resize(workerCount, NULL);
+	for (int i=0;i<workerCount;i++)
+		workers.push_back(new thread(&ParallelEvaluator::workerLoop, this, i));
+
+	//wait until every worker has its simulation loaded
+	unique_lock<mutex> lock(batchLock);
+	while (readyWorkers < workerCount)
+		batchFinished.wait(lock);
+}
+
+/**
+	Destructor - stops the workers and frees their simulations.
+*/
+ParallelEvaluator::~ParallelEvaluator(void){
+	{
+		lock_guard<mutex> lock(batchLock);
+		shuttingDown = true;
+	}
+	batchStarted.notify_all();
+
+	for (uint i=0;i<workers.size();i++){
+		workers[i]->join();
+		delete workers[i];
+	}
+	workers.clear();
+	editors.clear();
+}
+
+/**
+	This is the main loop of each worker thread.
+*/
+void ParallelEvaluator::workerLoop(int workerIndex){
+	ControllerEditor* editor = NULL;
+	{
+		lock_guard<mutex> lifetimeLock(editorLifetimeLock);
+		//the world reads the thread count when it is created, so it is only changed for as long as the editor is being built
+		int physXThreadCount = PhysicsGlobals::physXThreadCount;
+		PhysicsGlobals::physXThreadCount = physXThreadsPerWorker;
+		editor = new ControllerEditor();
+		PhysicsGlobals::physXThreadCount = physXThreadCount;
+	}
+
+	int lastBatchID;
+	{
+		lock_guard<mutex> lock(batchLock);
+		editors[workerIndex] = editor;
+		lastBatchID = batchID;
+		readyWorkers++;
+	}
+	batchFinished.notify_all();
+
+	while (true){
+		uint index;
+		{
+			unique_lock<mutex> lock(batchLock);
+			while (!shuttingDown && batchID == lastBatchID)
+				batchStarted.wait(lock);
+			if (shuttingDown)
+				break;
+			lastBatchID = batchID;
+		}
+
+		//keep grabbing candidates until there are none left in this batch
+		while (true){
+			{
+				lock_guard<mutex> lock(batchLock);
+				if (nextCandidate >= batchParams->size())
+					break;
+				index = nextCandidate++;
+			}
+			evaluateCandidate(editor, index);
+		}
+
+		bool lastOne;
+		{
+			lock_guard<mutex> lock(batchLock);
+			busyWorkers--;
+			lastOne = (busyWorkers == 0);
+		}
+		if (lastOne)
+			batchFinished.notify_all();
+	}
+
+	lock_guard<mutex> lifetimeLock(editorLifetimeLock);
+	//the framework takes its world down with it
+	delete editor->conF;
+	delete editor;
+}
+
+/**
+	This method runs one candidate on the editor passed in as a parameter.
+*/
+void ParallelEvaluator::evaluateCandidate(ControllerEditor* editor, uint index){
+	editor->reloadParameters((*batchParams)[index]);
+	int controlShotToWrite = 0;
+	Vector3d footSize = editor->TenStep(controlShotToWrite);
+	(*batchResults)[index] = footSize;
+
+	if (batchControlShots != NULL && (*batchControlShots)[index] >= 0)
+		editor->saveOptimizationShot((*batchControlShots)[index], (*batchParams)[index], footSize);
+}
+
+/**
+	This method evaluates all the parameter vectors passed in and returns, for each one of them, the average foot step
+	size obtained with TenStep. footSizes[i] always corresponds to params[i]. If controlShots is not NULL, then the
+	candidates for which controlShots[i] >= 0 are also saved as control shot number controlShots[i]. The index TenStep picks
+	(nextControlShotToWrite) is ignored here, since it depends on the order the workers happen to run the rollouts in.
+*/
+void ParallelEvaluator::evaluate(const vector<vector<double> >& params, vector<Vector3d>& footSizes, const vector<int>* controlShots){
+	footSizes.resize(params.size());
+	if (params.size() == 0)
+		return;
+
+	unique_lock<mutex> lock(batchLock);
+	batchParams = &params;
+	batchControlShots = controlShots;
+	batchResults = &footSizes;
+	nextCandidate = 0;
+	busyWorkers = (int)workers.size();
+	batchID++;
+	batchStarted.notify_all();
+
+	while (busyWorkers > 0)
+		batchFinished.wait(lock);
+
+	batchParams = NULL;
+	batchControlShots = NULL;
+	batchResults = NULL;
+}
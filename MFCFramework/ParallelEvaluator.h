@@ -0,0 +1,81 @@
+#pragma once
+
+#include "ControllerFramwork.h"
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+/**
+	This class is used to evaluate a whole batch of controller parameters at once (typically one MOCMA generation). It keeps
+	a pool of worker threads, and each worker owns an independent ControllerEditor (and therefore its own physical world and
+	controller). The candidates of a batch are handed out to whichever worker is free, and the results are written back in
+	the order of the input, so the caller does not care which worker ran which candidate.
+*/
+class ParallelEvaluator{
+private:
+	//the editors owned by the workers - each one is created and destroyed on the thread of its worker
+	vector<ControllerEditor*> editors;
+	vector<thread*> workers;
+
+	//this lock protects all the batch bookkeeping below
+	mutex batchLock;
+	condition_variable batchStarted;
+	condition_variable batchFinished;
+
+	//the batch that is currently being evaluated
+	const vector<vector<double> >* batchParams;
+	const vector<int>* batchControlShots;
+	vector<Vector3d>* batchResults;
+	//each new batch gets a new id, this is how the workers know there is more work to do
+	int batchID;
+	//index of the next candidate that needs a worker, and the number of workers still busy with the current batch
+	uint nextCandidate;
+	int busyWorkers;
+	//number of workers whose editor has been built
+	int readyWorkers;
+	//the number of PhysX dispatcher threads given to the scene of each worker
+	int physXThreadsPerWorker;
+	bool shuttingDown;
+
+	/**
+		This is the main loop of each worker thread.
+	*/
+	void workerLoop(int workerIndex);
+
+	/**
+		This method runs one candidate on the editor passed in as a parameter.
+	*/
+	void evaluateCandidate(ControllerEditor* editor, uint index);
+
+public:
+	/**
+		Constructor - starts workerCount workers. If workerCount is not positive, one worker per hardware thread is used. The workers
+		already keep all the cores busy, so by default the scene of each one only gets a single PhysX dispatcher thread. This only
+		applies to the scenes of the workers, the setting in PhysicsGlobals is left as it is.
+	*/
+	ParallelEvaluator(int workerCount = 0, int physXThreadsPerWorker = 1);
+
+	/**
+		Destructor - stops the workers and frees their simulations.
+	*/
+	~ParallelEvaluator(void);
+
+	/**
+		Returns the number of worker threads (i.e. the number of independent simulations)
+	*/
+	inline int getWorkerCount(){
+		return (int)workers.size();
+	}
+
+	/**
+		This method evaluates all the parameter vectors passed in and returns, for each one of them, the average foot step
+		size obtained with TenStep. footSizes[i] always corresponds to params[i]. If controlShots is not NULL, then the
+		candidates for which controlShots[i] >= 0 are also saved as control shot number controlShots[i]. The index TenStep picks
+		(nextControlShotToWrite) is ignored here, since it depends on the order the workers happen to run the rollouts in.
+	*/
+	void evaluate(const vector<vector<double> >& params, vector<Vector3d>& footSizes, const vector<int>* controlShots = NULL);
+};
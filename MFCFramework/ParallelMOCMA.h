@@ -0,0 +1,73 @@
+#ifndef _PARALLELMOCMA_H
+#define _PARALLELMOCMA_H
+
+#include "Objectives1.h"
+#include <shark/Algorithms/DirectSearch/MOCMA.h>
+
+namespace shark {
+    /*! \brief MO-CMA-ES that evaluates each generation as one batch
+    *
+    *  The generation step is the same as in shark::MOCMA, except that all the offspring are
+    *  handed to ObjectiveFunctions::evalBatch together instead of being evaluated one by one,
+    *  so that they can be simulated in parallel.
+    */
+    class ParallelMOCMA : public MOCMA
+    {
+    public:
+        std::string name() const
+        {
+            return "ParallelMOCMA";
+        }
+
+        void step( ObjectiveFunctions const& function )
+        {
+            //generate new offspring
+            for (std::size_t i = 0; i < mu(); i++) {
+                m_pop[mu()+i] = m_pop[i];
+                m_pop[mu()+i].mutate();
+            }
+
+            //evaluate the whole generation at once, repairing infeasible points the same way the PenalizingEvaluator does
+            std::vector<ObjectiveFunctions::SearchPointType> points(mu());
+            for (std::size_t i = 0; i < mu(); i++) {
+                points[i] = m_pop[mu()+i].searchPoint();
+                if( !function.isFeasible( points[i] ) )
+                    function.closestFeasible( points[i] );
+            }
+            std::vector<ObjectiveFunctions::ResultType> results;
+            function.evalBatch(points, results);
+            for (std::size_t i = 0; i < mu(); i++) {
+                CMAIndividual<RealVector>& individual = m_pop[mu()+i];
+                individual.unpenalizedFitness() = results[i];
+                individual.penalizedFitness() = results[i];
+                if( !function.isFeasible( individual.searchPoint() ) )
+                    m_evaluator.penalize(individual.searchPoint(), points[i], individual.penalizedFitness());
+            }
+
+            //select, and determine from the selection which parent-offspring pair has been successfull
+            m_selection(m_pop,m_mu);
+            for (std::size_t i = 0; i < mu(); i++) {
+                CMAChromosome::IndividualSuccess offspringSuccess = CMAChromosome::Unsuccessful;
+                if ( m_notionOfSuccess == PopulationBased && m_pop[mu()+i].selected()) {
+                    m_pop[mu()+i].updateAsOffspring();
+                    offspringSuccess = CMAChromosome::Successful;
+                }
+                else if ( m_notionOfSuccess == IndividualBased && m_pop[mu()+i].selected() && m_pop[mu()+i].rank() <= m_pop[i].rank()) {
+                    m_pop[mu()+i].updateAsOffspring();
+                    offspringSuccess = CMAChromosome::Successful;
+                }
+                if(m_pop[i].selected())
+                    m_pop[i].updateAsParent(offspringSuccess);
+            }
+
+            //partition the selected individuals to the front and generate the solution set
+            std::partition(m_pop.begin(), m_pop.end(),CMAIndividual<RealVector>::IsSelected);
+            for (unsigned int i = 0; i < mu(); i++) {
+                noalias(m_best[i].point) = m_pop[i].searchPoint();
+                m_best[i].value = m_pop[i].unpenalizedFitness();
+            }
+        }
+    };
+
+}
+#endif
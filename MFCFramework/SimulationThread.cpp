@@ -0,0 +1,192 @@
+#include "stdafx.h"
+
+#include "SimulationThread.h"
+#include "Globals.h"
+#include <PlaneCDP.h>
+
+/**
+	Constructor - the application must be initialized already. The thread is not started until start is called.
+*/
+SimulationThread::SimulationThread(Application* app) : stopping(false), realTime(true){
+	this->app = app;
+	worker = NULL;
+	bodiesVersion = -1;
+	layoutVersion = -1;
+	groundHeight = 0;
+	startTime = chrono::steady_clock::now();
+}
+
+/**
+	Destructor - stops the thread.
+*/
+SimulationThread::~SimulationThread(void){
+	stop();
+}
+
+/**
+	This method starts the simulation thread. The first snapshot is published before it returns, so the character can be drawn right away.
+*/
+void SimulationThread::start(){
+	if (worker != NULL)
+		return;
+	stopping = false;
+	startTime = chrono::steady_clock::now();
+	publishSnapshot();
+	worker = new thread(&SimulationThread::run, this);
+}
+
+/**
+	This method stops the simulation thread and waits for it to finish its tick.
+*/
+void SimulationThread::stop(){
+	if (worker == NULL)
+		return;
+	stopping = true;
+	worker->join();
+	delete worker;
+	worker = NULL;
+}
+
+/**
+	returns the number of seconds since the thread was started
+*/
+double SimulationThread::getTime(){
+	return chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+}
+
+/**
+	This is the main loop of the simulation thread.
+*/
+void SimulationThread::run(){
+	chrono::steady_clock::time_point nextTick = chrono::steady_clock::now();
+
+	while (!stopping){
+		app->processTask();
+		publishSnapshot();
+
+		chrono::steady_clock::time_point now = chrono::steady_clock::now();
+		if (!realTime){
+			nextTick = now;
+			continue;
+		}
+
+		nextTick += chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(1.0 / Globals::desiredFrameRate));
+		//if a tick took too long, we do not try to catch up with a burst of ticks, we just carry on from now
+		if (nextTick < now)
+			nextTick = now;
+		else
+			this_thread::sleep_until(nextTick);
+	}
+}
+
+/**
+	This method collects the bodies of the character again, after the framework was reloaded.
+*/
+void SimulationThread::collectBodies(){
+	bodies.clear();
+	bodiesVersion = app->frameworkVersion;
+
+	vector<BodyLayout> newLayout;
+	double newGroundHeight = 0;
+	if (app->conF != NULL){
+		Character* character = app->conF->getCharacter();
+		//the root, and then the child of every joint, visits each body of the character once
+		for (int i=-1;i<character->getJointCount();i++){
+			ArticulatedRigidBody* body = (i < 0) ? character->getRoot() : character->getJoint(i)->getChild();
+			bodies.push_back(body);
+
+			BodyLayout bodyLayout;
+			bodyLayout.name = body->getName();
+			for (int j=0;j<body->getMeshCount();j++)
+				bodyLayout.meshes.push_back(body->getMesh(j));
+			newLayout.push_back(bodyLayout);
+		}
+
+		//the ground is drawn at the height of the first plane of the body the ground files name "ground"
+		char groundName[] = "ground";
+		RigidBody* ground = app->conF->getWorld()->getRBByName(groundName);
+		if (ground != NULL){
+			for (int i=0;i<ground->getCDPCount();i++)
+				if (ground->getCDP(i)->getType() == PLANE_CDP){
+					newGroundHeight = ((PlaneCDP*)ground->getCDP(i))->getOrigin().y;
+					break;
+				}
+		}
+	}
+
+	lock_guard<mutex> lock(layoutLock);
+	layout.swap(newLayout);
+	groundHeight = newGroundHeight;
+	layoutVersion = bodiesVersion;
+}
+
+/**
+	This method writes the poses of the bodies to a snapshot and publishes it.
+*/
+void SimulationThread::publishSnapshot(){
+	if (bodiesVersion != app->frameworkVersion)
+		collectBodies();
+
+	BodySnapshot& snapshot = snapshots.getBack();
+	snapshot.frameworkVersion = bodiesVersion;
+	snapshot.time = getTime();
+	snapshot.poses.resize(bodies.size());
+	for (uint i=0;i<bodies.size();i++){
+		snapshot.poses[i].position = bodies[i]->getCMPosition();
+		snapshot.poses[i].orientation = bodies[i]->getOrientation();
+	}
+	snapshots.publish();
+}
+
+/**
+	This method copies the description of the bodies of the character and the height of the ground they stand on, and returns
+	the framework version they belong to.
+*/
+int SimulationThread::getLayout(vector<BodyLayout>& layout, double* groundHeight){
+	lock_guard<mutex> lock(layoutLock);
+	layout = this->layout;
+	*groundHeight = this->groundHeight;
+	return layoutVersion;
+}
+
+/**
+	This method is called by the render thread. It writes the poses of the bodies, interpolated between the last two snapshots, to
+	the array passed in as a parameter. It returns the framework version the poses belong to, or -1 if nothing was published yet.
+*/
+int SimulationThread::getPoses(vector<BodyPose>& poses){
+	if (snapshots.acquire()){
+		previous.frameworkVersion = current.frameworkVersion;
+		previous.time = current.time;
+		previous.poses.swap(current.poses);
+
+		const BodySnapshot& latest = snapshots.getFront();
+		current.frameworkVersion = latest.frameworkVersion;
+		current.time = latest.time;
+		current.poses.assign(latest.poses.begin(), latest.poses.end());
+	}
+
+	poses.resize(current.poses.size());
+	if (current.frameworkVersion < 0)
+		return -1;
+
+	//the bodies are drawn one snapshot interval behind the simulation, so that there are always two snapshots to interpolate between.
+	//Snapshots of different frameworks have different bodies, so the latest one is drawn as it is
+	double t = 1;
+	if (previous.frameworkVersion == current.frameworkVersion && current.time > previous.time)
+		t = (getTime() - current.time) / (current.time - previous.time);
+	if (t > 1) t = 1;
+	if (t < 0) t = 0;
+
+	for (uint i=0;i<poses.size();i++){
+		if (t == 1){
+			poses[i] = current.poses[i];
+			continue;
+		}
+		const BodyPose& a = previous.poses[i];
+		const BodyPose& b = current.poses[i];
+		poses[i].position = a.position + Vector3d(a.position, b.position) * t;
+		poses[i].orientation = a.orientation.sphericallyInterpolateWith(b.orientation, t);
+	}
+
+	return current.frameworkVersion;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "Application.h"
+#include "BodySnapshot.h"
+
+#include <thread>
+#include <mutex>
+#include <chrono>
+
+/**
+	This class runs the simulation of an application on its own thread, so that drawing never slows it down. The simulation advances
+	one tick (Application::processTask) every 1/Globals::desiredFrameRate seconds, or as fast as it can when it does not run in real
+	time, and after every tick the poses of the bodies of the character are published in a BodySnapshotBuffer.
+
+	The render thread never touches the simulation: it only reads the snapshots, and it draws the bodies interpolated between the last
+	two of them, so the motion is smooth even though the two threads do not run at the same rate.
+*/
+class SimulationThread{
+private:
+	Application* app;
+	thread* worker;
+	atomic<bool> stopping;
+	atomic<bool> realTime;
+
+	BodySnapshotBuffer snapshots;
+	//the time the thread was started, the times of the snapshots are measured from it
+	chrono::steady_clock::time_point startTime;
+
+	//the bodies of the character, in the order of the poses of the snapshots, and the framework version they belong to - only used by the simulation thread
+	vector<ArticulatedRigidBody*> bodies;
+	int bodiesVersion;
+
+	//the layout only changes when the framework is reloaded, so it is simply protected by a lock
+	mutex layoutLock;
+	vector<BodyLayout> layout;
+	//the height of the ground plane of the world the character is in
+	double groundHeight;
+	int layoutVersion;
+
+	//the last two snapshots the render thread took, the poses it draws are interpolated between them - only used by the render thread
+	BodySnapshot previous;
+	BodySnapshot current;
+
+	/**
+		This is the main loop of the simulation thread.
+	*/
+	void run();
+
+	/**
+		This method collects the bodies of the character again, after the framework was reloaded.
+	*/
+	void collectBodies();
+
+	/**
+		This method writes the poses of the bodies to a snapshot and publishes it.
+	*/
+	void publishSnapshot();
+
+	/**
+		returns the number of seconds since the thread was started
+	*/
+	double getTime();
+
+public:
+	/**
+		Constructor - the application must be initialized already. The thread is not started until start is called.
+	*/
+	SimulationThread(Application* app);
+
+	/**
+		Destructor - stops the thread.
+	*/
+	~SimulationThread(void);
+
+	/**
+		This method starts the simulation thread. The first snapshot is published before it returns, so the character can be drawn right away.
+	*/
+	void start();
+
+	/**
+		This method stops the simulation thread and waits for it to finish its tick.
+	*/
+	void stop();
+
+	/**
+		When realTime is false, the simulation does not wait between ticks and runs as fast as it can.
+	*/
+	inline void setRealTime(bool realTime){
+		this->realTime = realTime;
+	}
+
+	/**
+		This method copies the description of the bodies of the character and the height of the ground they stand on, and returns
+		the framework version they belong to.
+	*/
+	int getLayout(vector<BodyLayout>& layout, double* groundHeight);
+
+	/**
+		This method is called by the render thread. It writes the poses of the bodies, interpolated between the last two snapshots, to
+		the array passed in as a parameter. It returns the framework version the poses belong to, or -1 if nothing was published yet.
+	*/
+	int getPoses(vector<BodyPose>& poses);
+};
@@ -0,0 +1,241 @@
+/*
+
+	Copyright 2014 Rudy Snow
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stdafx.h"
+
+#include "SkeletonRenderer.h"
+#include "GLUtil.h"
+#include "EngineCommon.h"
+
+using namespace std;
+
+SkeletonRenderer::SkeletonRenderer()
+{
+    m_pLightingTechnique = NULL;
+    m_pWireFrameTechnique = NULL;
+    m_pTransforms = NULL;
+    m_NumBodies = 0;
+}
+
+
+SkeletonRenderer::~SkeletonRenderer()
+{
+    SAFE_DELETE(m_pLightingTechnique);
+    SAFE_DELETE(m_pWireFrameTechnique);
+    SAFE_DELETE(m_pTransforms);
+
+    for (map<string, Mesh*>::iterator it = m_Meshes.begin() ; it != m_Meshes.end() ; ++it)
+    {
+        SAFE_DELETE(it->second);
+    }
+}
+
+
+bool SkeletonRenderer::Init(const DirectionalLight& Light)
+{
+    m_pLightingTechnique = new LightingTechnique(true);
+
+    if (!m_pLightingTechnique->Init()) 
+    {
+        printf("Error initializing the Lighting Technique\n");
+        return false;
+    }
+
+    m_pLightingTechnique->Enable();
+    m_pLightingTechnique->SetDirectionalLight(Light);
+    m_pLightingTechnique->SetTextureUnit(0);
+    m_pLightingTechnique->SetTransformTextureUnit(TRANSFORM_TEXTURE_UNIT_INDEX);
+
+    m_pWireFrameTechnique = new WireFrameTechnique(true);
+
+    if (!m_pWireFrameTechnique->Init()) 
+    {
+        printf("Error initializing the WireFrame Technique\n");
+        return false;
+    }
+
+    m_pWireFrameTechnique->Enable();
+    m_pWireFrameTechnique->SetTransformTextureUnit(TRANSFORM_TEXTURE_UNIT_INDEX);
+
+    m_pTransforms = new TransformBuffer();
+
+    if (!m_pTransforms->Init())
+    {
+        printf("Error initializing the transform buffer\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+Mesh* SkeletonRenderer::GetMesh(const string& Filename)
+{
+    map<string, Mesh*>::iterator it = m_Meshes.find(Filename);
+
+    if (it != m_Meshes.end())
+    {
+        return it->second;
+    }
+
+    Mesh* pMesh = new Mesh();
+
+    if (!pMesh->LoadMesh(Filename))
+    {
+        printf("Error loading the mesh '%s', the bodies that use it are not drawn\n", Filename.c_str());
+        SAFE_DELETE(pMesh);
+    }
+
+    m_Meshes[Filename] = pMesh;
+
+    return pMesh;
+}
+
+
+void SkeletonRenderer::AddBinding(unsigned int Body, Mesh* pMesh, const Vector3d& Offset, const Vector3d& Scale)
+{
+    RenderBinding Binding;
+    Binding.Body = Body;
+    Binding.Offset = Point3d(Offset.x, Offset.y, Offset.z);
+    Binding.Scale = Vector3f((float)Scale.x, (float)Scale.y, (float)Scale.z);
+
+    for (unsigned int i = 0 ; i < m_Batches.size() ; i++)
+    {
+        if (m_Batches[i].pMesh == pMesh)
+        {
+            m_Batches[i].Bindings.push_back(Binding);
+            return;
+        }
+    }
+
+    RenderBatch Batch;
+    Batch.pMesh = pMesh;
+    Batch.BaseInstance = 0;
+    Batch.Bindings.push_back(Binding);
+    m_Batches.push_back(Batch);
+}
+
+
+bool SkeletonRenderer::SetLayout(const vector<BodyLayout>& Layout)
+{
+    ClearLayout();
+
+    unsigned int NumBound = 0;
+    m_NumBodies = (unsigned int)Layout.size();
+
+    for (unsigned int i = 0 ; i < Layout.size() ; i++)
+    {
+        for (unsigned int j = 0 ; j < Layout[i].meshes.size() ; j++)
+        {
+            const RBMesh& BodyMesh = Layout[i].meshes[j];
+            Mesh* pMesh = GetMesh(BodyMesh.fileName);
+
+            if (pMesh)
+            {
+                AddBinding(i, pMesh, BodyMesh.offset, BodyMesh.scale);
+                NumBound++;
+            }
+        }
+    }
+
+    // The transforms of a batch are next to each other, so that each instance finds its own
+    // at the base instance of the batch plus its instance ID
+    unsigned int BaseInstance = 0;
+
+    for (unsigned int i = 0 ; i < m_Batches.size() ; i++)
+    {
+        m_Batches[i].BaseInstance = BaseInstance;
+        BaseInstance += (unsigned int)m_Batches[i].Bindings.size();
+    }
+
+    m_pTransforms->Resize(NumBound);
+
+    return NumBound > 0;
+}
+
+
+void SkeletonRenderer::ClearLayout()
+{
+    m_Batches.clear();
+    m_NumBodies = 0;
+}
+
+
+void SkeletonRenderer::Render(const Matrix4f& VP, const vector<BodyPose>& Poses)
+{
+    // Poses of another character than the one that is bound are not drawn
+    if (Poses.size() != m_NumBodies)
+    {
+        return;
+    }
+
+    // One pass packs the transforms of all the bodies, and one call uploads them for both passes
+    for (unsigned int i = 0 ; i < m_Batches.size() ; i++)
+    {
+        const RenderBatch& Batch = m_Batches[i];
+
+        for (unsigned int j = 0 ; j < Batch.Bindings.size() ; j++)
+        {
+            const RenderBinding& Binding = Batch.Bindings[j];
+            const BodyPose& Pose = Poses[Binding.Body];
+            Point3d Position = Pose.position + Pose.orientation.rotate(Vector3d(Binding.Offset));
+            Quaternion q = Pose.orientation.getComplexConjugate();
+            Quaternions Rotation(q.v.x, q.v.y, q.v.z, q.s);
+
+            m_pTransforms->SetTransform(Batch.BaseInstance + j,
+                                        Vector3f((float)Position.getX(), (float)Position.getY(), (float)Position.getZ()),
+                                        Rotation, Binding.Scale);
+        }
+    }
+
+    m_pTransforms->Upload();
+    m_pTransforms->Bind(TRANSFORM_TEXTURE_UNIT);
+
+    m_pLightingTechnique->Enable();
+    m_pLightingTechnique->SetVP(VP);
+
+    for (unsigned int i = 0 ; i < m_Batches.size() ; i++)
+    {
+        m_pLightingTechnique->SetBaseInstance(m_Batches[i].BaseInstance);
+        m_Batches[i].pMesh->RenderInstanced((unsigned int)m_Batches[i].Bindings.size());
+    }
+
+    glPolygonOffset(-1.0f, -1.0f);
+    glEnable(GL_POLYGON_OFFSET_LINE);
+    glEnable(GL_LINE_SMOOTH);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    glLineWidth(0.5f);
+
+    Vector3f vBlack = COLOR_BLACK;
+    m_pWireFrameTechnique->Enable();
+    m_pWireFrameTechnique->SetColor(vBlack);
+    m_pWireFrameTechnique->SetVP(VP);
+
+    for (unsigned int i = 0 ; i < m_Batches.size() ; i++)
+    {
+        m_pWireFrameTechnique->SetBaseInstance(m_Batches[i].BaseInstance);
+        m_Batches[i].pMesh->RenderInstanced((unsigned int)m_Batches[i].Bindings.size());
+    }
+
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glDisable(GL_POLYGON_OFFSET_LINE);
+    glLineWidth(1.0f);
+    glDisable(GL_BLEND);
+}
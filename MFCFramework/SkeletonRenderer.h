@@ -0,0 +1,89 @@
+/*
+
+	Copyright 2014 Rudy Snow
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SKELETON_RENDERER_H
+#define	SKELETON_RENDERER_H
+
+#include <map>
+#include <vector>
+
+#include "LightingTechnique.h"
+#include "WireFrameTechnique.h"
+#include "MeshLoader.h"
+#include "TransformBuffer.h"
+
+#include "BodySnapshot.h"
+
+// Draws the bodies of a simulated character. The bodies are bound to their meshes once, when the layout of
+// the character is set, and every frame they are drawn from a list of poses in the order of that layout,
+// so the renderer never touches the simulation itself. The transforms of all the bodies are packed into
+// one TransformBuffer and uploaded once per frame, and the bodies that share a mesh are drawn together
+// with one instanced call, so the cost of a frame on the CPU grows with the number of meshes and not
+// with the number of bodies.
+class SkeletonRenderer
+{
+public:
+    SkeletonRenderer();
+
+    ~SkeletonRenderer();
+
+    bool Init(const DirectionalLight& Light);
+
+    // Binds every body of the layout to the meshes that are listed for it in the .rbs file, placed and
+    // scaled as the file says, so bodies without a mesh entry are not drawn. Returns false if nothing
+    // could be bound.
+    bool SetLayout(const std::vector<BodyLayout>& Layout);
+
+    // Forgets the bodies of the character, but keeps their meshes loaded
+    void ClearLayout();
+
+    // Draws the bodies at the given poses, which are in the order of the layout
+    void Render(const Matrix4f& VP, const std::vector<BodyPose>& Poses);
+
+private:
+    Mesh* GetMesh(const std::string& Filename);
+    void AddBinding(unsigned int Body, Mesh* pMesh, const Vector3d& Offset, const Vector3d& Scale);
+
+    struct RenderBinding
+    {
+        unsigned int Body;
+        Point3d Offset;
+        Vector3f Scale;
+    };
+
+    // All the bodies that are drawn with the same mesh
+    struct RenderBatch
+    {
+        Mesh* pMesh;
+        // The index of the transform of the first binding in the transform buffer
+        unsigned int BaseInstance;
+        std::vector<RenderBinding> Bindings;
+    };
+
+    LightingTechnique* m_pLightingTechnique;
+    WireFrameTechnique* m_pWireFrameTechnique;
+    TransformBuffer* m_pTransforms;
+
+    // The meshes, by the name of their file. Files that could not be loaded map to NULL, so they are tried only once
+    std::map<std::string, Mesh*> m_Meshes;
+    std::vector<RenderBatch> m_Batches;
+    // The number of bodies of the layout, which is also the number of poses Render expects
+    unsigned int m_NumBodies;
+};
+
+#endif	/* SKELETON_RENDERER_H */
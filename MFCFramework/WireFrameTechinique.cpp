@@ -27,8 +27,9 @@
 
 //#define CHECK_BVH_UNIFORM_STATUS
 
-WireFrameTechnique::WireFrameTechnique()
+WireFrameTechnique::WireFrameTechnique(bool Instanced)
 {   
+    m_Instanced = Instanced;
 }
 
 bool WireFrameTechnique::Init()
@@ -37,7 +38,7 @@ bool WireFrameTechnique::Init()
         return false;
     }
 
-    if (!AddShader(GL_VERTEX_SHADER, "../Data/GLEffects/WireFrame.vp")) 
+    if (!AddShader(GL_VERTEX_SHADER, m_Instanced ? "../Data/GLEffects/Instanced.vp" : "../Data/GLEffects/WireFrame.vp")) 
     {
         return false;
     }
@@ -55,6 +56,9 @@ bool WireFrameTechnique::Init()
     m_Color = GetUniformLocation("gColor");
     m_WVPLocation = GetUniformLocation("gWVP");
     m_WorldMatrixLocation = GetUniformLocation("gWorld");
+    m_VPLocation = GetUniformLocation("gVP");
+    m_transformsLocation = GetUniformLocation("gTransforms");
+    m_baseInstanceLocation = GetUniformLocation("gBaseInstance");
 
     return true;
 }
@@ -73,4 +77,19 @@ void WireFrameTechnique::SetWVP(const Matrix4f& WVP)
 void WireFrameTechnique::SetWorldMatrix(const Matrix4f& WorldInverse)
 {
     glUniformMatrix4fv(m_WorldMatrixLocation, 1, GL_TRUE, (const GLfloat*)WorldInverse.m);
+}
+
+void WireFrameTechnique::SetVP(const Matrix4f& VP)
+{
+    glUniformMatrix4fv(m_VPLocation, 1, GL_TRUE, (const GLfloat*)VP.m);
+}
+
+void WireFrameTechnique::SetTransformTextureUnit(unsigned int TextureUnit)
+{
+    glUniform1i(m_transformsLocation, TextureUnit);
+}
+
+void WireFrameTechnique::SetBaseInstance(unsigned int BaseInstance)
+{
+    glUniform1i(m_baseInstanceLocation, BaseInstance);
 }
\ No newline at end of file
@@ -26,7 +26,9 @@ class WireFrameTechnique : public Technique
 {
 public:
 
-    WireFrameTechnique();
+    // An instanced technique fetches the world matrices from a TransformBuffer (see
+    // Mesh::RenderInstanced), and only takes the view-projection as a uniform
+    WireFrameTechnique(bool Instanced = false);
 
     virtual ~WireFrameTechnique() {}
     
@@ -35,10 +37,18 @@ public:
     void SetColor(const Vector3f& wireColor);
     void SetWVP(const Matrix4f& WVP);
     void SetWorldMatrix(const Matrix4f& WVP);
+    void SetVP(const Matrix4f& VP);
+    void SetTransformTextureUnit(unsigned int TextureUnit);
+    void SetBaseInstance(unsigned int BaseInstance);
 
 private:
 
+    bool m_Instanced;
+
     GLuint m_Color;
+    GLuint m_VPLocation;
+    GLuint m_transformsLocation;
+    GLuint m_baseInstanceLocation;
     GLuint m_WVPLocation;
     GLuint m_WorldMatrixLocation;
 };
@@ -11,6 +11,10 @@
 */
 #define EPSILON 0.0000000001
 
+//math.h may already define INFINITY as the floating point infinity, but here it is meant to be the largest double
+#ifdef INFINITY
+#undef INFINITY
+#endif
 #define INFINITY DBL_MAX
 
 #define TINY_NUMBER 0.000000001
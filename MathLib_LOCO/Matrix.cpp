@@ -1,6 +1,6 @@
 #include "stdafx.h"
 
-#include "matrix.h"
+#include "Matrix.h"
 #include "gsl/blas/gsl_blas.h"
 #include "Vector3d.h"
 
@@ -12,5 +12,5 @@ public:
 public:
     Plane(void);
     Plane(const Point3d& p, const Vector3d& n);
-    Plane::~Plane(void);
+    ~Plane(void);
 };
@@ -28,7 +28,7 @@ public:
 	Point3d(double x, double y) : ThreeTuple(x, y){
 	}
 
-	Point3d(ThreeTuple &p) : ThreeTuple(p){
+	Point3d(const ThreeTuple &p) : ThreeTuple(p){
 	}
 
 	Point3d(const Point3d& other){
@@ -1,6 +1,6 @@
 #include "stdafx.h"
 
-#include "quaternion.h"
+#include "Quaternion.h"
 
 /**
 	Returns the complex conjugate of the current quaternion.
@@ -270,7 +270,7 @@ public:
 		In the T coordinate frame, v is the same as in C, and qA is a rotation that aligns v from P to that
 		from T.
 	*/
-	void Quaternion::decomposeRotation(Quaternion* qA, Quaternion* qB, const Vector3d& vC) const;
+	void decomposeRotation(Quaternion* qA, Quaternion* qB, const Vector3d& vC) const;
 
 	/**
 		Assume that the current quaternion represents the relative orientation between two coordinate frames A and B.
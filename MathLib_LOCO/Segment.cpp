@@ -1,6 +1,6 @@
 #include "stdafx.h"
 
-#include "segment.h"
+#include "Segment.h"
 
 //#include <Include/glHeaders.h>
 
@@ -15,7 +15,7 @@ ThreeTuple::ThreeTuple(double x,double y){
 	this->z = 0;
 }
 
-ThreeTuple::ThreeTuple(ThreeTuple& p){
+ThreeTuple::ThreeTuple(const ThreeTuple& p){
 	this->x = p.x;
 	this->y = p.y;
 	this->z = p.z;
@@ -20,7 +20,7 @@ public:
 		some useful constructors 
 	*/
 	ThreeTuple();
-	ThreeTuple(ThreeTuple&);
+	ThreeTuple(const ThreeTuple&);
 	ThreeTuple(double x, double y, double z);
 	ThreeTuple(double x, double y);
 	ThreeTuple(double*);
@@ -1,12 +1,10 @@
 #include "stdafx.h"
 #include <iostream>
+#include <cstring>
 
-#include "transformationmatrix.h"
+#include "TransformationMatrix.h"
 #include <gsl/blas/gsl_blas.h>
 
-
-#pragma once
-
 #include "Matrix.h"
 #include "Point3d.h"
 #include "Vector3d.h"
@@ -1,6 +1,6 @@
 #include "stdafx.h"
 
-#include "vector.h"
+#include "Vector.h"
 
 #include <gsl/blas/gsl_blas.h>
 
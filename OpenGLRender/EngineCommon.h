@@ -21,6 +21,8 @@
 #define RANDOM_TEXTURE_UNIT_INDEX       3
 #define DISPLACEMENT_TEXTURE_UNIT       GL_TEXTURE4
 #define DISPLACEMENT_TEXTURE_UNIT_INDEX 4
+#define TRANSFORM_TEXTURE_UNIT          GL_TEXTURE5
+#define TRANSFORM_TEXTURE_UNIT_INDEX    5
 
 #define COLOR_RED                   Vector3f(1.0f,  0.267f, 0.267f)
 #define COLOR_GREEN                 Vector3f(0.6f,  0.8f,   1.0f)
@@ -24,6 +24,7 @@ using namespace std;
 
 Mesh::MeshEntry::MeshEntry()
 {
+    VAO = INVALID_OGL_VALUE;
     VB = INVALID_OGL_VALUE;
     IB = INVALID_OGL_VALUE;
     NumIndices  = 0;
@@ -32,6 +33,11 @@ Mesh::MeshEntry::MeshEntry()
 
 Mesh::MeshEntry::~MeshEntry()
 {
+    if (VAO != INVALID_OGL_VALUE)
+    {
+        glDeleteVertexArrays(1, &VAO);
+    }
+
     if (VB != INVALID_OGL_VALUE)
     {
         glDeleteBuffers(1, &VB);
@@ -48,15 +54,29 @@ bool Mesh::MeshEntry::Init(const vector<Vertex>& Vertices,
 {
     NumIndices = Indices.size();
 
+    // The VAO records the buffers and the attribute layout once, so that rendering only has to bind it
+    glGenVertexArrays(1, &VAO);
+    glBindVertexArray(VAO);
+
     glGenBuffers(1, &VB);
   	glBindBuffer(GL_ARRAY_BUFFER, VB);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * Vertices.size(), &Vertices[0], GL_STATIC_DRAW);
 
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid*)12);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid*)20);
+
     glGenBuffers(1, &IB);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IB);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * NumIndices, &Indices[0], GL_STATIC_DRAW);
-    
-    return true;
+
+    // Make sure the VAO is not changed from the outside
+    glBindVertexArray(0);
+
+    return GLCheckError();
 }
 
 Mesh::Mesh()
@@ -76,6 +96,8 @@ void Mesh::Clear()
     {
         SAFE_DELETE(m_Textures[i]);
     }
+
+    m_Entries.clear();
 }
 
 
@@ -198,28 +220,28 @@ bool Mesh::InitMaterials(const aiScene* pScene, const string& Filename)
 
 void Mesh::Render()
 {
-    GLuint vao;
-    glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
+    for (unsigned int i = 0 ; i < m_Entries.size() ; i++) 
+    {
+        glBindVertexArray(m_Entries[i].VAO);
 
-    glEnableVertexAttribArray(0);
-    glEnableVertexAttribArray(1);
-    glEnableVertexAttribArray(2);
-    
-    //int num = m_Entries.size();
+        const unsigned int MaterialIndex = m_Entries[i].MaterialIndex;
 
-    int flag = GLCheckError();
+        if (MaterialIndex < m_Textures.size() && m_Textures[MaterialIndex]) 
+        {
+            m_Textures[MaterialIndex]->Bind(GL_TEXTURE0);
+        }
 
-    for (unsigned int i = 0 ; i < m_Entries.size() ; i++) 
-    {
-        glBindBuffer(GL_ARRAY_BUFFER, m_Entries[i].VB);
+        glDrawElements(GL_TRIANGLES, m_Entries[i].NumIndices, GL_UNSIGNED_INT, 0);
+    }
 
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-        int res = glGetError();
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid*)12);
-        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid*)20);
+    glBindVertexArray(0);
+}
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_Entries[i].IB);
+void Mesh::RenderInstanced(unsigned int NumInstances)
+{
+    for (unsigned int i = 0 ; i < m_Entries.size() ; i++) 
+    {
+        glBindVertexArray(m_Entries[i].VAO);
 
         const unsigned int MaterialIndex = m_Entries[i].MaterialIndex;
 
@@ -228,17 +250,8 @@ void Mesh::Render()
             m_Textures[MaterialIndex]->Bind(GL_TEXTURE0);
         }
 
-        glDrawElements(GL_TRIANGLES, m_Entries[i].NumIndices, GL_UNSIGNED_INT, 0);
-    
-        int flag2 = GLCheckError();
-        int flag3 = 0;
-
+        glDrawElementsInstanced(GL_TRIANGLES, m_Entries[i].NumIndices, GL_UNSIGNED_INT, 0, NumInstances);
     }
 
-    glDisableVertexAttribArray(0);
-    glDisableVertexAttribArray(1);
-    glDisableVertexAttribArray(2);
-
     glBindVertexArray(0);
-    glDeleteVertexArrays(1, &vao);
 }
@@ -60,6 +60,10 @@ public:
 
     void Render();
 
+    // Draws the mesh NumInstances times in one call per entry. The shader must fetch the world
+    // matrix of each instance itself, by gl_InstanceID (see TransformBuffer).
+    void RenderInstanced(unsigned int NumInstances);
+
 private:
     bool InitFromScene(const aiScene* pScene, const std::string& Filename);
     void InitMesh(unsigned int Index, const aiMesh* paiMesh);
@@ -76,6 +80,7 @@ private:
         bool Init(const std::vector<Vertex>& Vertices,
                   const std::vector<unsigned int>& Indices);
 
+        GLuint VAO;
         GLuint VB;
         GLuint IB;
         unsigned int NumIndices;
@@ -0,0 +1,106 @@
+/*
+
+	Copyright 2014 Rudy Snow
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "TransformBuffer.h"
+#include "GLUtil.h"
+
+TransformBuffer::TransformBuffer()
+{
+    m_Buffer = INVALID_OGL_VALUE;
+    m_Texture = INVALID_OGL_VALUE;
+}
+
+
+TransformBuffer::~TransformBuffer()
+{
+    if (m_Texture != INVALID_OGL_VALUE)
+    {
+        glDeleteTextures(1, &m_Texture);
+    }
+
+    if (m_Buffer != INVALID_OGL_VALUE)
+    {
+        glDeleteBuffers(1, &m_Buffer);
+    }
+}
+
+
+bool TransformBuffer::Init()
+{
+    glGenBuffers(1, &m_Buffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, m_Buffer);
+    glBufferData(GL_TEXTURE_BUFFER, sizeof(PackedTransform), NULL, GL_STREAM_DRAW);
+
+    glGenTextures(1, &m_Texture);
+    glBindTexture(GL_TEXTURE_BUFFER, m_Texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_Buffer);
+
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    return GLCheckError();
+}
+
+
+void TransformBuffer::Resize(unsigned int NumTransforms)
+{
+    m_Transforms.resize(NumTransforms);
+}
+
+
+void TransformBuffer::SetTransform(unsigned int Index, const Vector3f& Pos, Quaternions& Rotation, const Vector3f& Scale)
+{
+    Matrix4f RotateTrans;
+    Quat2Matrix(Rotation, RotateTrans);
+
+    PackedTransform& Transform = m_Transforms[Index];
+
+    for (unsigned int i = 0 ; i < 3 ; i++)
+    {
+        Transform.Rows[i][0] = RotateTrans.m[i][0] * Scale.x;
+        Transform.Rows[i][1] = RotateTrans.m[i][1] * Scale.y;
+        Transform.Rows[i][2] = RotateTrans.m[i][2] * Scale.z;
+    }
+
+    Transform.Rows[0][3] = Pos.x;
+    Transform.Rows[1][3] = Pos.y;
+    Transform.Rows[2][3] = Pos.z;
+}
+
+
+void TransformBuffer::Upload()
+{
+    if (m_Transforms.empty())
+    {
+        return;
+    }
+
+    // Respecifying the whole buffer lets the driver hand out new memory instead of waiting
+    // for the draws of the previous frame that still read the old transforms
+    glBindBuffer(GL_TEXTURE_BUFFER, m_Buffer);
+    glBufferData(GL_TEXTURE_BUFFER, sizeof(PackedTransform) * m_Transforms.size(), &m_Transforms[0], GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+
+void TransformBuffer::Bind(GLenum TextureUnit)
+{
+    glActiveTexture(TextureUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, m_Texture);
+}
@@ -0,0 +1,76 @@
+/*
+
+	Copyright 2014 Rudy Snow
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef TRANSFORM_BUFFER_H
+#define	TRANSFORM_BUFFER_H
+
+#include <vector>
+#include <GL/glew.h>
+
+#include "math_3d.h"
+
+using namespace Math3D;
+
+// The top three rows of a world matrix, the translation is in the last column. The bottom row
+// of a rigid transform is always (0, 0, 0, 1), so it is not stored.
+struct PackedTransform
+{
+    float Rows[3][4];
+};
+
+// Holds the world matrices of many instances in a texture buffer, one PackedTransform (three
+// RGBA32F texels) each. The transforms are written on the CPU without any matrix products and
+// uploaded with a single call per frame, and the instanced shaders fetch the transform of an
+// instance with texelFetch, so the cost of a draw call does not grow with the instances it draws.
+class TransformBuffer
+{
+public:
+    TransformBuffer();
+
+    ~TransformBuffer();
+
+    bool Init();
+
+    // Makes room for NumTransforms transforms. The memory is kept, so this does not allocate
+    // unless the buffer grows.
+    void Resize(unsigned int NumTransforms);
+
+    unsigned int GetSize() const
+    {
+        return (unsigned int)m_Transforms.size();
+    }
+
+    // Writes the transform that scales, then rotates, then translates, i.e. the one that
+    // Pipeline::GetWorldTrans() builds from the same WorldPos, Rotate and Scale
+    void SetTransform(unsigned int Index, const Vector3f& Pos, Quaternions& Rotation, const Vector3f& Scale);
+
+    // Sends all the transforms to the GPU
+    void Upload();
+
+    void Bind(GLenum TextureUnit);
+
+private:
+    std::vector<PackedTransform> m_Transforms;
+
+    GLuint m_Buffer;
+    GLuint m_Texture;
+};
+
+
+#endif	/* TRANSFORM_BUFFER_H */
@@ -0,0 +1,523 @@
+#include "stdafx.h"
+
+#include "ABAFigure.h"
+#include "HingeJoint.h"
+#include "UniversalJoint.h"
+#include "BallInSocketJoint.h"
+#include <math.h>
+
+/**
+	out = a * b, where a and b are 6x6 matrices, stored row major.
+*/
+static void mul6x6(const double* a, const double* b, double* out){
+	for (int i=0;i<6;i++)
+		for (int j=0;j<6;j++){
+			double sum = 0;
+			for (int k=0;k<6;k++)
+				sum += a[i*6+k] * b[k*6+j];
+			out[i*6+j] = sum;
+		}
+}
+
+/**
+	out = m * v, where m is a 6x6 matrix, stored row major.
+*/
+static void mul6(const double* m, const double* v, double* out){
+	for (int i=0;i<6;i++){
+		out[i] = 0;
+		for (int k=0;k<6;k++)
+			out[i] += m[i*6+k] * v[k];
+	}
+}
+
+static double dot6(const double* a, const double* b){
+	return a[0]*b[0] + a[1]*b[1] + a[2]*b[2] + a[3]*b[3] + a[4]*b[4] + a[5]*b[5];
+}
+
+/**
+	This method writes the 6x6 matrix X that takes the spatial acceleration of a link to that of another link whose center of mass is at
+	r with respect to the first one: the angular acceleration is unchanged, and the linear acceleration becomes a + alpha x r.
+*/
+static void getMotionTransform(const Vector3d& r, double* X){
+	for (int i=0;i<36;i++)
+		X[i] = 0;
+	for (int i=0;i<6;i++)
+		X[i*6+i] = 1;
+	//the lower left block is -[r]x
+	X[3*6+1] = r.z;		X[3*6+2] = -r.y;
+	X[4*6+0] = -r.z;	X[4*6+2] = r.x;
+	X[5*6+0] = r.y;		X[5*6+1] = -r.x;
+}
+
+/**
+	out = X * v, for the motion transform X of getMotionTransform, without building the matrix.
+*/
+static void applyMotionTransform(const Vector3d& r, const double* v, double* out){
+	out[0] = v[0]; out[1] = v[1]; out[2] = v[2];
+	out[3] = v[3] + v[1] * r.z - v[2] * r.y;
+	out[4] = v[4] + v[2] * r.x - v[0] * r.z;
+	out[5] = v[5] + v[0] * r.y - v[1] * r.x;
+}
+
+/**
+	out = X' * f, for the motion transform X of getMotionTransform: the force is moved back to the first center of mass, which adds r x f to the torque.
+*/
+static void applyForceTransform(const Vector3d& r, const double* f, double* out){
+	out[0] = f[0] + r.y * f[5] - r.z * f[4];
+	out[1] = f[1] + r.z * f[3] - r.x * f[5];
+	out[2] = f[2] + r.x * f[4] - r.y * f[3];
+	out[3] = f[3]; out[4] = f[4]; out[5] = f[5];
+}
+
+/**
+	This method solves m * x = b, where m is an n x n matrix stored row major (it gets overwritten). Returns false if the matrix is singular.
+*/
+static bool solveLinearSystem(double* m, double* b, int n){
+	for (int col=0;col<n;col++){
+		int pivot = col;
+		for (int i=col+1;i<n;i++)
+			if (fabs(m[i*n+col]) > fabs(m[pivot*n+col]))
+				pivot = i;
+		if (fabs(m[pivot*n+col]) < 1e-12)
+			return false;
+		if (pivot != col){
+			for (int k=0;k<n;k++){
+				double tmp = m[col*n+k]; m[col*n+k] = m[pivot*n+k]; m[pivot*n+k] = tmp;
+			}
+			double tmp = b[col]; b[col] = b[pivot]; b[pivot] = tmp;
+		}
+		for (int i=0;i<n;i++){
+			if (i == col)
+				continue;
+			double f = m[i*n+col] / m[col*n+col];
+			for (int k=col;k<n;k++)
+				m[i*n+k] -= f * m[col*n+k];
+			b[i] -= f * b[col];
+		}
+	}
+	for (int i=0;i<n;i++)
+		b[i] /= m[i*n+i];
+	return true;
+}
+
+/**
+	Constructor. The links are collected from the joint tree of the figure that is passed in.
+*/
+ABAFigure::ABAFigure(ArticulatedFigure* figure){
+	this->af = figure;
+
+	ABALink root;
+	root.rb = af->getRoot();
+	root.joint = NULL;
+	root.parent = -1;
+	root.nDofs = 0;
+	links.push_back(root);
+
+	//breadth first, so that each parent is always processed before its children
+	for (uint i=0;i<links.size();i++){
+		ArticulatedRigidBody* arb = links[i].rb;
+		for (int k=0;k<arb->getChildJointCount();k++){
+			ABALink l;
+			l.joint = arb->getChildJoint(k);
+			l.rb = l.joint->getChild();
+			l.parent = i;
+			l.nDofs = 0;
+			for (int d=0;d<ABA_MAX_JOINT_DOFS;d++)
+				l.qd[d] = l.qdd[d] = 0;
+			links.push_back(l);
+		}
+	}
+	oldOrientations.resize(links.size());
+}
+
+ABAFigure::~ABAFigure(void){
+
+}
+
+/**
+	This method reads the joint velocities and the axes of the link's joint from the state of the rigid bodies.
+*/
+void ABAFigure::setUpJoint(ABALink* l){
+	RigidBody* p = links[l->parent].rb;
+	RigidBody* c = l->rb;
+	Joint* j = l->joint;
+
+	l->d1 = Vector3d(p->state.position, p->getWorldCoordinates(j->pJPos));
+	l->d2 = Vector3d(c->getWorldCoordinates(j->cJPos), c->state.position);
+	Vector3d wP = p->state.angularVelocity;
+	Vector3d wC = c->state.angularVelocity;
+	Vector3d wRel = wC - wP;
+	//the rate of change of the joint axes gives the velocity dependent part of the relative angular acceleration
+	Vector3d bW(0,0,0);
+
+	switch (j->getJointType()){
+		case HINGE_JOINT:
+			l->nDofs = 1;
+			l->axes[0] = p->state.orientation.rotate(((HingeJoint*)j)->a);
+			l->qd[0] = wRel.dotProductWith(l->axes[0]);
+			//the axis is fixed in the parent
+			bW = wP.crossProductWith(l->axes[0]) * l->qd[0];
+			break;
+		case UNIVERSAL_JOINT:{
+			l->nDofs = 2;
+			l->axes[0] = p->state.orientation.rotate(((UniversalJoint*)j)->a);
+			l->axes[1] = c->state.orientation.rotate(((UniversalJoint*)j)->b);
+			//the two axes are not orthogonal in general, so find the rates that best explain the relative angular velocity
+			double aa = l->axes[0].dotProductWith(l->axes[0]), ab = l->axes[0].dotProductWith(l->axes[1]), bb = l->axes[1].dotProductWith(l->axes[1]);
+			double det = aa * bb - ab * ab;
+			double ra = wRel.dotProductWith(l->axes[0]), rb = wRel.dotProductWith(l->axes[1]);
+			l->qd[0] = (fabs(det) > 1e-10) ? (bb * ra - ab * rb) / det : 0;
+			l->qd[1] = (fabs(det) > 1e-10) ? (aa * rb - ab * ra) / det : 0;
+			//a is fixed in the parent, b is fixed in the child
+			bW = wP.crossProductWith(l->axes[0]) * l->qd[0] + wC.crossProductWith(l->axes[1]) * l->qd[1];
+			break;
+		}
+		case BALL_IN_SOCKET_JOINT:
+			//the rates are the world coordinates of the relative angular velocity, so the axes never change
+			l->nDofs = 3;
+			l->axes[0] = Vector3d(1,0,0);
+			l->axes[1] = Vector3d(0,1,0);
+			l->axes[2] = Vector3d(0,0,1);
+			l->qd[0] = wRel.x;
+			l->qd[1] = wRel.y;
+			l->qd[2] = wRel.z;
+			break;
+		default:
+			l->nDofs = 0;
+			break;
+	}
+
+	for (int k=0;k<l->nDofs;k++){
+		Vector3d lin = l->axes[k].crossProductWith(l->d2);
+		l->S[k][0] = l->axes[k].x; l->S[k][1] = l->axes[k].y; l->S[k][2] = l->axes[k].z;
+		l->S[k][3] = lin.x; l->S[k][4] = lin.y; l->S[k][5] = lin.z;
+	}
+
+	Vector3d cLin = bW.crossProductWith(l->d2) + wP.crossProductWith(wP.crossProductWith(l->d1)) + wC.crossProductWith(wC.crossProductWith(l->d2));
+	l->c[0] = bW.x; l->c[1] = bW.y; l->c[2] = bW.z;
+	l->c[3] = cLin.x; l->c[4] = cLin.y; l->c[5] = cLin.z;
+}
+
+/**
+	This method integrates the relative orientation of the link's joint, and places the rigid body so that it satisfies the joint exactly.
+*/
+void ABAFigure::integrateLink(ABALink* l, const Quaternion& qPOld, double dt){
+	RigidBody* p = links[l->parent].rb;
+	RigidBody* c = l->rb;
+	Joint* j = l->joint;
+
+	for (int k=0;k<l->nDofs;k++)
+		l->qd[k] += l->qdd[k] * dt;
+
+	//the relative orientation at the start of the step (the child has not been moved yet)
+	Quaternion qRel = qPOld.getComplexConjugate() * c->state.orientation;
+
+	switch (j->getJointType()){
+		case HINGE_JOINT:{
+			Vector3d a = ((HingeJoint*)j)->a;
+			double angle = qRel.getRotationAngle(a) + l->qd[0] * dt;
+			qRel = Quaternion::getRotationQuaternion(angle, a);
+			break;
+		}
+		case UNIVERSAL_JOINT:{
+			Vector3d a = ((UniversalJoint*)j)->a;
+			Vector3d b = ((UniversalJoint*)j)->b;
+			Quaternion qA, qB;
+			qRel.decomposeRotation(&qA, &qB, b);
+			double angleA = qA.getRotationAngle(a) + l->qd[0] * dt;
+			double angleB = qB.getRotationAngle(b) + l->qd[1] * dt;
+			qRel = Quaternion::getRotationQuaternion(angleA, a) * Quaternion::getRotationQuaternion(angleB, b);
+			break;
+		}
+		case BALL_IN_SOCKET_JOINT:{
+			//the relative angular velocity, expressed in the parent's frame
+			Vector3d wRel = qPOld.inverseRotate(Vector3d(l->qd[0], l->qd[1], l->qd[2]));
+			Quaternion dq = Quaternion(0, wRel) * qRel;
+			dq *= 0.5 * dt;
+			qRel += dq;
+			qRel.toUnit();
+			break;
+		}
+		default:
+			//stiff joints keep the relative orientation they have
+			break;
+	}
+
+	//now rebuild the state of the child from that of the parent
+	c->state.orientation = p->state.orientation * qRel;
+	c->state.orientation.toUnit();
+	Point3d anchor = p->getWorldCoordinates(j->pJPos);
+	c->state.position = anchor + c->getWorldCoordinates(Vector3d(j->cJPos, Point3d(0,0,0)));
+
+	Vector3d wJ(0,0,0);
+	switch (j->getJointType()){
+		case HINGE_JOINT:
+			wJ = p->state.orientation.rotate(((HingeJoint*)j)->a) * l->qd[0];
+			break;
+		case UNIVERSAL_JOINT:
+			wJ = p->state.orientation.rotate(((UniversalJoint*)j)->a) * l->qd[0] + c->state.orientation.rotate(((UniversalJoint*)j)->b) * l->qd[1];
+			break;
+		case BALL_IN_SOCKET_JOINT:
+			wJ = Vector3d(l->qd[0], l->qd[1], l->qd[2]);
+			break;
+		default:
+			break;
+	}
+	c->state.angularVelocity = p->state.angularVelocity + wJ;
+	Vector3d d1 = Vector3d(p->state.position, anchor);
+	Vector3d d2 = Vector3d(anchor, c->state.position);
+	c->state.velocity = p->state.velocity + p->state.angularVelocity.crossProductWith(d1) + c->state.angularVelocity.crossProductWith(d2);
+}
+
+/**
+	This method computes the accelerations of all the links, without moving anything. The forces and torques acting on the ith object of
+	the world are in forces[i], and the ids of the rigid bodies are their indices in that list.
+*/
+void ABAFigure::computeAccelerations(DynamicArray<RBForceAccumulator>* forces){
+	int n = links.size();
+
+	//first pass: the velocity dependent terms, the rigid body inertias and the bias forces
+	for (int i=0;i<n;i++){
+		ABALink* l = &links[i];
+		RigidBody* rb = l->rb;
+		for (int k=0;k<36;k++)
+			l->IA[k] = 0;
+		for (int k=0;k<3;k++){
+			Vector3d e((k==0)?1:0, (k==1)?1:0, (k==2)?1:0);
+			Vector3d col = rb->state.orientation.inverseRotate(e);
+			col.x *= rb->props.MOI_local.x;
+			col.y *= rb->props.MOI_local.y;
+			col.z *= rb->props.MOI_local.z;
+			col = rb->state.orientation.rotate(col);
+			l->IA[0*6+k] = col.x;
+			l->IA[1*6+k] = col.y;
+			l->IA[2*6+k] = col.z;
+			l->IA[(3+k)*6+(3+k)] = rb->props.mass;
+		}
+		Vector3d w = rb->state.angularVelocity;
+		Vector3d Iw(l->IA[0]*w.x + l->IA[1]*w.y + l->IA[2]*w.z, l->IA[6]*w.x + l->IA[7]*w.y + l->IA[8]*w.z, l->IA[12]*w.x + l->IA[13]*w.y + l->IA[14]*w.z);
+		Vector3d t = w.crossProductWith(Iw) - (*forces)[rb->id].netTorque;
+		Vector3d f = (*forces)[rb->id].netForce * -1;
+		l->pA[0] = t.x; l->pA[1] = t.y; l->pA[2] = t.z;
+		l->pA[3] = f.x; l->pA[4] = f.y; l->pA[5] = f.z;
+
+		if (l->parent >= 0)
+			setUpJoint(l);
+	}
+
+	//second pass, from the leaves in: the articulated inertias and bias forces
+	double X[36], tmp[36], XT[36], Ia[36], pa[6], tmpV[6];
+	for (int i=n-1;i>0;i--){
+		ABALink* l = &links[i];
+		int nd = l->nDofs;
+		double D[ABA_MAX_JOINT_DOFS * ABA_MAX_JOINT_DOFS];
+		for (int k=0;k<nd;k++){
+			mul6(l->IA, l->S[k], l->U[k]);
+			l->u[k] = -dot6(l->S[k], l->pA);
+		}
+		for (int k=0;k<nd;k++)
+			for (int m=0;m<nd;m++)
+				D[k*nd+m] = dot6(l->S[k], l->U[m]);
+		//invert D one column at a time
+		for (int m=0;m<nd;m++){
+			double Dc[ABA_MAX_JOINT_DOFS * ABA_MAX_JOINT_DOFS], col[ABA_MAX_JOINT_DOFS];
+			for (int k=0;k<nd*nd;k++)
+				Dc[k] = D[k];
+			for (int k=0;k<nd;k++)
+				col[k] = (k==m)?1:0;
+			if (!solveLinearSystem(Dc, col, nd))
+				for (int k=0;k<nd;k++)
+					col[k] = 0;
+			for (int k=0;k<nd;k++)
+				l->Dinv[k*nd+m] = col[k];
+		}
+
+		//Ia = IA - U Dinv U', pa = pA + Ia c + U Dinv u
+		for (int k=0;k<36;k++)
+			Ia[k] = l->IA[k];
+		for (int r=0;r<6;r++)
+			pa[r] = l->pA[r];
+		for (int k=0;k<nd;k++){
+			for (int m=0;m<nd;m++){
+				double dkm = l->Dinv[k*nd+m];
+				for (int r=0;r<6;r++){
+					for (int s=0;s<6;s++)
+						Ia[r*6+s] -= l->U[k][r] * dkm * l->U[m][s];
+					pa[r] += l->U[k][r] * dkm * l->u[m];
+				}
+			}
+		}
+		mul6(Ia, l->c, tmpV);
+		for (int r=0;r<6;r++)
+			pa[r] += tmpV[r];
+
+		//and move them over to the parent: IA_p += X' Ia X, pA_p += X' pa
+		ABALink* p = &links[l->parent];
+		getMotionTransform(l->d1 + l->d2, X);
+		for (int r=0;r<6;r++)
+			for (int s=0;s<6;s++)
+				XT[r*6+s] = X[s*6+r];
+		mul6x6(Ia, X, tmp);
+		mul6x6(XT, tmp, Ia);
+		for (int k=0;k<36;k++)
+			p->IA[k] += Ia[k];
+		mul6(XT, pa, tmpV);
+		for (int r=0;r<6;r++)
+			p->pA[r] += tmpV[r];
+	}
+
+	//third pass, from the root out: the accelerations. The inverse of the root's articulated inertia is kept for the test impulses
+	ABALink* root = &links[0];
+	for (int m=0;m<6;m++){
+		for (int k=0;k<36;k++)
+			tmp[k] = root->IA[k];
+		double col[6];
+		for (int k=0;k<6;k++)
+			col[k] = (k==m)?1:0;
+		if (root->rb->isLocked() || !solveLinearSystem(tmp, col, 6))
+			for (int k=0;k<6;k++)
+				col[k] = 0;
+		for (int k=0;k<6;k++)
+			rootIAinv[k*6+m] = col[k];
+	}
+	mul6(rootIAinv, root->pA, root->A);
+	for (int r=0;r<6;r++)
+		root->A[r] = -root->A[r];
+
+	for (int i=1;i<n;i++){
+		ABALink* l = &links[i];
+		int nd = l->nDofs;
+		double Ap[6];
+		applyMotionTransform(l->d1 + l->d2, links[l->parent].A, Ap);
+		for (int r=0;r<6;r++)
+			Ap[r] += l->c[r];
+		double rhs[ABA_MAX_JOINT_DOFS];
+		for (int k=0;k<nd;k++)
+			rhs[k] = l->u[k] - dot6(l->U[k], Ap);
+		for (int k=0;k<nd;k++){
+			l->qdd[k] = 0;
+			for (int m=0;m<nd;m++)
+				l->qdd[k] += l->Dinv[k*nd+m] * rhs[m];
+		}
+		for (int r=0;r<6;r++){
+			l->A[r] = Ap[r];
+			for (int k=0;k<nd;k++)
+				l->A[r] += l->S[k][r] * l->qdd[k];
+		}
+	}
+
+}
+
+/**
+	This method advances the state of the figure by dt, using the accelerations of the last call to computeAccelerations.
+*/
+void ABAFigure::integrate(double dt){
+	int n = links.size();
+	ABALink* root = &links[0];
+
+	//the root is a free body, and everything else follows from the joints
+	for (int i=0;i<n;i++)
+		oldOrientations[i] = links[i].rb->state.orientation;
+
+	RigidBody* rb = root->rb;
+	if (!rb->isLocked()){
+		rb->state.angularVelocity += Vector3d(root->A[0], root->A[1], root->A[2]) * dt;
+		rb->state.velocity += Vector3d(root->A[3], root->A[4], root->A[5]) * dt;
+		rb->state.position += rb->state.velocity * dt;
+		Quaternion dq = Quaternion(0, rb->state.angularVelocity) * rb->state.orientation;
+		dq *= 0.5 * dt;
+		rb->state.orientation += dq;
+		rb->state.orientation.toUnit();
+	}
+
+	for (int i=1;i<n;i++)
+		integrateLink(&links[i], oldOrientations[links[i].parent], dt);
+}
+
+/**
+	This method advances the state of the figure by dt. The forces and torques acting on the ith object of the world are in forces[i], and the ids
+	of the rigid bodies are their indices in that list.
+*/
+void ABAFigure::advanceInTime(double dt, DynamicArray<RBForceAccumulator>* forces){
+	computeAccelerations(forces);
+	integrate(dt);
+}
+
+/**
+	This method computes the velocity changes of all the links, for the test impulses that were stored in pT. Only the ith link and the links
+	between it and the root can have a test impulse.
+*/
+void ABAFigure::propagateImpulseResponse(int i){
+	int n = links.size();
+	double pa[6], tmpV[6];
+
+	//the impulse is the only force, so the velocity dependent terms all drop out, and uT is zero for all the links that are not between the
+	//ith one and the root. From the link in: pa = pT + U Dinv uT, and the parent gets X' pa
+	for (int k=0;k<n;k++)
+		for (int m=0;m<ABA_MAX_JOINT_DOFS;m++)
+			links[k].uT[m] = 0;
+	for (int k=i;k>0;k=links[k].parent){
+		ABALink* l = &links[k];
+		int nd = l->nDofs;
+		for (int m=0;m<nd;m++)
+			l->uT[m] = -dot6(l->S[m], l->pT);
+		for (int r=0;r<6;r++)
+			pa[r] = l->pT[r];
+		for (int m=0;m<nd;m++)
+			for (int q=0;q<nd;q++)
+				for (int r=0;r<6;r++)
+					pa[r] += l->U[m][r] * l->Dinv[m*nd+q] * l->uT[q];
+		applyForceTransform(l->d1 + l->d2, pa, tmpV);
+		for (int r=0;r<6;r++)
+			links[l->parent].pT[r] += tmpV[r];
+	}
+
+	//and from the root out, the velocity changes
+	mul6(rootIAinv, links[0].pT, links[0].dV);
+	for (int r=0;r<6;r++)
+		links[0].dV[r] = -links[0].dV[r];
+	for (int k=1;k<n;k++){
+		ABALink* l = &links[k];
+		int nd = l->nDofs;
+		applyMotionTransform(l->d1 + l->d2, links[l->parent].dV, l->dV);
+		double rhs[ABA_MAX_JOINT_DOFS];
+		for (int m=0;m<nd;m++)
+			rhs[m] = l->uT[m] - dot6(l->U[m], l->dV);
+		for (int m=0;m<nd;m++){
+			double qddT = 0;
+			for (int q=0;q<nd;q++)
+				qddT += l->Dinv[m*nd+q] * rhs[q];
+			for (int r=0;r<6;r++)
+				l->dV[r] += l->S[m][r] * qddT;
+		}
+	}
+}
+
+/**
+	This method computes how the velocities of all the links change when the impulse is applied to the ith link, at the point that is r away
+	from its center of mass (in world coordinates). The articulated inertias of the last call to computeAccelerations are used, so this only
+	takes one pass in and one pass out. The changes are read with getVelocityChange.
+*/
+void ABAFigure::computeImpulseResponse(int i, const Vector3d& impulse, const Vector3d& r){
+	for (uint k=0;k<links.size();k++)
+		for (int m=0;m<6;m++)
+			links[k].pT[m] = 0;
+	Vector3d t = r.crossProductWith(impulse);
+	links[i].pT[0] = -t.x; links[i].pT[1] = -t.y; links[i].pT[2] = -t.z;
+	links[i].pT[3] = -impulse.x; links[i].pT[4] = -impulse.y; links[i].pT[5] = -impulse.z;
+	propagateImpulseResponse(i);
+}
+
+/**
+	This method computes how the velocities of all the links change when the angular impulse is applied to the ith link, and the opposite one to
+	its parent, the way a joint would. The changes are read with getVelocityChange.
+*/
+void ABAFigure::computeJointImpulseResponse(int i, const Vector3d& angularImpulse){
+	for (uint k=0;k<links.size();k++)
+		for (int m=0;m<6;m++)
+			links[k].pT[m] = 0;
+	ABALink* l = &links[i];
+	l->pT[0] = -angularImpulse.x; l->pT[1] = -angularImpulse.y; l->pT[2] = -angularImpulse.z;
+	links[l->parent].pT[0] = angularImpulse.x; links[l->parent].pT[1] = angularImpulse.y; links[l->parent].pT[2] = angularImpulse.z;
+	propagateImpulseResponse(i);
+}
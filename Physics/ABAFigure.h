@@ -0,0 +1,164 @@
+#pragma once
+
+#include <Vector3d.h>
+#include <Quaternion.h>
+#include "ArticulatedFigure.h"
+#include "RBForceAccumulator.h"
+
+//the largest number of degrees of freedom a joint can have (ball in socket joints)
+#define ABA_MAX_JOINT_DOFS 3
+
+/**
+	This structure holds the data that the articulated body algorithm needs for one link of an articulated figure. All the spatial quantities are
+	expressed in world-aligned coordinates, about the center of mass of the link, and are stored with the angular part first.
+*/
+typedef struct ABALink_struct{
+	ArticulatedRigidBody* rb;
+	//the joint that connects the link to its parent (NULL for the root), and the index of the parent link
+	Joint* joint;
+	int parent;
+	//the number of degrees of freedom of the joint
+	int nDofs;
+	//the world coordinates of the joint axes
+	Vector3d axes[ABA_MAX_JOINT_DOFS];
+	//the joint velocities and accelerations (the rate of rotation about each one of the axes)
+	double qd[ABA_MAX_JOINT_DOFS], qdd[ABA_MAX_JOINT_DOFS];
+	//the vector from the parent's center of mass to the joint, and from the joint to the center of mass of the link
+	Vector3d d1, d2;
+	//the motion subspace of the joint, one column at a time
+	double S[ABA_MAX_JOINT_DOFS][6];
+	//the velocity-dependent part of the acceleration of the link
+	double c[6];
+	//the articulated inertia and the articulated bias force of the link
+	double IA[36], pA[6];
+	//U = IA * S, and the inverse of D = S' * U
+	double U[ABA_MAX_JOINT_DOFS][6], Dinv[ABA_MAX_JOINT_DOFS * ABA_MAX_JOINT_DOFS];
+	double u[ABA_MAX_JOINT_DOFS];
+	//the spatial acceleration of the link
+	double A[6];
+	//the same quantities, for the response of the figure to a test impulse: the bias force, u and the change in the spatial velocity
+	double pT[6], uT[ABA_MAX_JOINT_DOFS], dV[6];
+} ABALink;
+
+/*-----------------------------------------------------------------------------------------------------------------------------------------------------*
+ * This class implements Featherstone's articulated body algorithm for one articulated figure. The figure is simulated in reduced coordinates: the  *
+ * root has six degrees of freedom, and every other link only moves the way its parent joint allows. After every step the state of the rigid bodies *
+ * is rebuilt from the root outwards, so the joint constraints are always satisfied exactly and never drift. The joint limits are left to the world, *
+ * which solves them together with the contacts, using the impulse responses of the figure.                                                         *
+ *-----------------------------------------------------------------------------------------------------------------------------------------------------*/
+class ABAFigure{
+private:
+	//the figure that is being simulated
+	ArticulatedFigure* af;
+	//all the links of the figure, ordered so that each parent comes before its children
+	DynamicArray<ABALink> links;
+	//the orientations of the links at the start of the step
+	DynamicArray<Quaternion> oldOrientations;
+	//the inverse of the articulated inertia of the root, which every test impulse needs
+	double rootIAinv[36];
+
+	/**
+		This method reads the joint velocities and the axes of the link's joint from the state of the rigid bodies.
+	*/
+	void setUpJoint(ABALink* l);
+
+	/**
+		This method integrates the relative orientation of the link's joint, and places the rigid body so that it satisfies the joint exactly.
+	*/
+	void integrateLink(ABALink* l, const Quaternion& qPOld, double dt);
+
+	/**
+		This method computes the velocity changes of all the links, for the test impulses that were stored in pT. Only the ith link and the links
+		between it and the root can have a test impulse.
+	*/
+	void propagateImpulseResponse(int i);
+
+public:
+	/**
+		Constructor. The links are collected from the joint tree of the figure that is passed in.
+	*/
+	ABAFigure(ArticulatedFigure* figure);
+	~ABAFigure(void);
+
+	/**
+		returns the figure that is being simulated
+	*/
+	inline ArticulatedFigure* getFigure(){
+		return af;
+	}
+
+	/**
+		returns the number of links of the figure. The root is link 0
+	*/
+	inline int getLinkCount(){
+		return (int)links.size();
+	}
+
+	/**
+		returns the rigid body of the ith link
+	*/
+	inline ArticulatedRigidBody* getLinkBody(int i){
+		return links[i].rb;
+	}
+
+	/**
+		returns the joint that connects the ith link to its parent, or NULL for the root
+	*/
+	inline Joint* getLinkJoint(int i){
+		return links[i].joint;
+	}
+
+	/**
+		returns the index of the parent of the ith link, or -1 for the root
+	*/
+	inline int getLinkParent(int i){
+		return links[i].parent;
+	}
+
+	/**
+		This method computes the accelerations of all the links, without moving anything. The forces and torques acting on the ith object of
+		the world are in forces[i], and the ids of the rigid bodies are their indices in that list.
+	*/
+	void computeAccelerations(DynamicArray<RBForceAccumulator>* forces);
+
+	/**
+		This method advances the state of the figure by dt, using the accelerations of the last call to computeAccelerations.
+	*/
+	void integrate(double dt);
+
+	/**
+		This method advances the state of the figure by dt. The forces and torques acting on the ith object of the world are in forces[i], and the ids
+		of the rigid bodies are their indices in that list.
+	*/
+	void advanceInTime(double dt, DynamicArray<RBForceAccumulator>* forces);
+
+	/**
+		returns the linear and the angular acceleration of the center of mass of the ith link, as computed by the last call to computeAccelerations
+	*/
+	inline void getAcceleration(int i, Vector3d* a, Vector3d* alpha){
+		*alpha = Vector3d(links[i].A[0], links[i].A[1], links[i].A[2]);
+		*a = Vector3d(links[i].A[3], links[i].A[4], links[i].A[5]);
+	}
+
+	/**
+		This method computes how the velocities of all the links change when the impulse is applied to the ith link, at the point that is r away
+		from its center of mass (in world coordinates). The articulated inertias of the last call to computeAccelerations are used, so this only
+		takes one pass in and one pass out. The changes are read with getVelocityChange.
+	*/
+	void computeImpulseResponse(int i, const Vector3d& impulse, const Vector3d& r);
+
+	/**
+		This method computes how the velocities of all the links change when the angular impulse is applied to the ith link, and the opposite one to
+		its parent, the way a joint would. The changes are read with getVelocityChange.
+	*/
+	void computeJointImpulseResponse(int i, const Vector3d& angularImpulse);
+
+	/**
+		returns the change in the linear and the angular velocity of the ith link, as computed by the last call to computeImpulseResponse or
+		computeJointImpulseResponse
+	*/
+	inline void getVelocityChange(int i, Vector3d* dv, Vector3d* dw){
+		*dw = Vector3d(links[i].dV[0], links[i].dV[1], links[i].dV[2]);
+		*dv = Vector3d(links[i].dV[3], links[i].dV[4], links[i].dV[5]);
+	}
+};
@@ -25,13 +25,11 @@ ArticulatedFigure::~ArticulatedFigure(void){
 	joints.clear();
 }
 
-void ArticulatedFigure::loadIntoWorld() {
-	World& world = World::instance();
-
+void ArticulatedFigure::loadIntoWorld(World* world) {
 	if( root == NULL ) return;
-	world.addRigidBody(root);
+	world->addRigidBody(root);
 	for (uint i=0;i<arbs.size();i++)
-		world.addRigidBody(arbs[i]);
+		world->addRigidBody(arbs[i]);
 }
 
 /**
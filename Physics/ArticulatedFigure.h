@@ -41,7 +41,10 @@ public:
 	*/
 	virtual ~ArticulatedFigure(void);
 
-	void loadIntoWorld();
+	/**
+		This method adds all the articulated rigid bodies of this figure to the world passed in as a parameter
+	*/
+	void loadIntoWorld(World* world);
 
 	/**
 		Sets the root
@@ -64,7 +67,8 @@ public:
 	int getArticulatedRigidBodyCount() const { return arbs.size(); }
 
 	void setName( const char* name ) {
-		strncpy_s( this->name, name, 100 );
+		strncpy( this->name, name, 99 );
+		this->name[99] = '\0';
 	}
 
 	const char* getName() const {
@@ -74,14 +78,14 @@ public:
 	/**
 		This method returns an ARB that is a child of this articulated figure
 	*/
-	ArticulatedRigidBody* getARBByName(char* name) const {
+	ArticulatedRigidBody* getARBByName(const char* name) const {
 		if( root != NULL ) {
-			if (strcmp(root->name, name) == NULL)
+			if (strcmp(root->name, name) == 0)
 				return root;
 		}
 
 		for (uint i=0;i<arbs.size();i++)
-			if (strcmp(arbs[i]->name, name) == NULL)
+			if (strcmp(arbs[i]->name, name) == 0)
 				return arbs[i];
 		return NULL;
 	}
@@ -147,9 +151,9 @@ public:
 		this method is used to return a reference to the joint whose name is passed as a parameter, or NULL
 		if it is not found.
 	*/
-	inline Joint* getJointByName(char* jName){
+	inline Joint* getJointByName(const char* jName){
 		for (uint i=0;i<joints.size();i++)
-			if (strcmp(joints[i]->name, jName) == NULL)
+			if (strcmp(joints[i]->name, jName) == 0)
 				return joints[i];
 		return NULL;
 	}
@@ -159,7 +163,7 @@ public:
 	*/
 	inline int getJointIndex(const char* jName){
 		for (uint i=0;i<joints.size();i++)
-			if (strcmp(joints[i]->name, jName) == NULL)
+			if (strcmp(joints[i]->name, jName) == 0)
 				return i;
 		return -1;
 	}
@@ -7,6 +7,7 @@
  *==============================================================================================================================================================*/
 class BallInSocketJoint : public Joint{
 friend class PhysX3World;
+friend class RBDynJoint;
 private:
 /**
 	Quantities that do not change
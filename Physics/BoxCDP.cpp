@@ -1,7 +1,36 @@
 #include "stdafx.h"
 
 #include "BoxCDP.h"
+#include "PlaneCDP.h"
+#include "RigidBody.h"
 
 BoxCDP::~BoxCDP(void){
 
 }
+
+/**
+	updates the world coordinates of the corners of the box.
+*/
+void BoxCDP::updateToWorldPrimitive(){
+	for (int i=0;i<8;i++)
+		wCorners[i] = bdy->getWorldCoordinates(Point3d((i&1)?p2.x:p1.x, (i&2)?p2.y:p1.y, (i&4)?p2.z:p1.z));
+}
+
+/**
+	every corner of the box that is below the plane generates a contact point. The normals point from the plane into the box.
+*/
+int BoxCDP::computeCollisionsWithPlaneCDP(PlaneCDP* p,  DynamicArray<ContactPoint> *cps){
+	int n = 0;
+	for (int i=0;i<8;i++){
+		double dist = Vector3d(p->wP.p, wCorners[i]).dotProductWith(p->wP.n);
+		if (dist > 0)
+			continue;
+		cps->push_back(ContactPoint());
+		ContactPoint* lastPoint = &(*cps)[cps->size()-1];
+		lastPoint->d = -dist;
+		lastPoint->n = p->wP.n;
+		lastPoint->cp = wCorners[i];
+		n++;
+	}
+	return n;
+}
@@ -10,9 +10,12 @@
  * A box is represented by the position of two opposite corners.                                                                                                          *
  *========================================================================================================================================================================*/
 class BoxCDP : public CollisionDetectionPrimitive{
+	friend class HeightFieldCDP;
 private:
 	//these are the two corners of the box, expressed in local coordinates.
 	Point3d p1, p2;
+	//and these are the eight corners of the box, expressed in world coordinates
+	Point3d wCorners[8];
 
 public:
 	BoxCDP(const Point3d& point1, const Point3d& point2, RigidBody* theBody = NULL) :
@@ -23,9 +26,9 @@ public:
 		CollisionDetectionPrimitive( BOX_CDP, theBody ) {}
 	virtual ~BoxCDP(void);
 
-	virtual char* save() { return "BoxCDP"; }
+	virtual const char* save() { return "BoxCDP"; }
 
-	virtual void updateToWorldPrimitive(){}
+	virtual void updateToWorldPrimitive();
 
 
 	const Point3d& getPoint1() const { return p1; }
@@ -62,7 +65,6 @@ public:
 	}
 
 	virtual int computeCollisionsWith(CollisionDetectionPrimitive* other,  DynamicArray<ContactPoint> *cps){
-/*
 		//we don't know what the other collision detection primitive is, but we know this one is a box, so make
 		//other compute the contact points with this box
 		int oldContactCount = cps->size();
@@ -72,15 +74,11 @@ public:
 		for (uint i=oldContactCount;i<cps->size();i++)
 			((*cps)[i]).n *= -1;
 		return nContacts;
-*/
-
-		//NOT YET IMPLEMENTED!!!
-		return 0;
-
 	}
 
+	//only box-plane contacts are implemented for now - that is all the feet of the characters need
 	virtual int computeCollisionsWithSphereCDP(SphereCDP* sp,  DynamicArray<ContactPoint> *cps){return 0;}
-	virtual int computeCollisionsWithPlaneCDP(PlaneCDP* sp,  DynamicArray<ContactPoint> *cps){return 0;}
+	virtual int computeCollisionsWithPlaneCDP(PlaneCDP* p,  DynamicArray<ContactPoint> *cps);
 	virtual int computeCollisionsWithCapsuleCDP(CapsuleCDP* sp,  DynamicArray<ContactPoint> *cps){return 0;}
 	virtual int computeCollisionsWithBoxCDP(BoxCDP* sp,  DynamicArray<ContactPoint> *cps){return 0;}
 
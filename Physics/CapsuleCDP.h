@@ -18,6 +18,7 @@
 class CapsuleCDP : public CollisionDetectionPrimitive{
 friend class SphereCDP;
 friend class PlaneCDP;
+friend class HeightFieldCDP;
 
 private:
 	//a capsule is really just an infinite number of spheres that have the center along a segment. Therefore, to define the capsule we need the
@@ -35,7 +36,7 @@ public:
 		CollisionDetectionPrimitive( CAPSULE_CDP, theBody ) {}
 	~CapsuleCDP(void);
 	
-	virtual char* save() { return "CapsuleCDP"; }
+	virtual const char* save() { return "CapsuleCDP"; }
 
 	virtual void updateToWorldPrimitive();
 
@@ -1,5 +1,5 @@
 #include "stdafx.h"
-#include "Collisiondetectionprimitive.h"
+#include "CollisionDetectionPrimitive.h"
 
 
 CollisionDetectionPrimitive::~CollisionDetectionPrimitive(void){
@@ -22,6 +22,7 @@ class BoxCDP;
 #define CAPSULE_CDP 2
 #define PLANE_CDP 3
 #define BOX_CDP 4
+#define HEIGHT_FIELD_CDP 5
 
 class CollisionDetectionPrimitive{
 protected:
@@ -38,7 +39,7 @@ public:
 		return typeid(*this).name();
 	}
 
-	virtual char* save() = 0;
+	virtual const char* save() = 0;
 
 	void attachBody( RigidBody* body ) {
 		bdy = body;
@@ -0,0 +1,176 @@
+#include "stdafx.h"
+
+#include "HeightFieldCDP.h"
+#include "SphereCDP.h"
+#include "CapsuleCDP.h"
+#include "BoxCDP.h"
+#include "RigidBody.h"
+#include <mutex>
+#include <algorithm>
+
+using namespace std;
+
+DynamicArray<HeightFieldData*> HeightFieldData::loadedFields;
+
+//the worlds of the parallel evaluations may be loading their terrain at the same time
+static mutex loadedFieldsLock;
+
+HeightFieldData::HeightFieldData(void){
+	fileName[0] = '\0';
+	rows = columns = 0;
+	rowSpacing = columnSpacing = 1;
+}
+
+/**
+	This method reads the height field from a file. The file starts with the number of rows, the number of columns, the spacing
+	between the rows and the spacing between the columns. The heights follow, one row after the other. It returns false if the file
+	cannot be read.
+*/
+bool HeightFieldData::loadFromFile(const char* fName){
+	FILE* f = fopen(fName, "r");
+	if (f == NULL){
+		printf("Cannot open the height field %s\n", fName);
+		return false;
+	}
+
+	if (fscanf(f, "%d %d %lf %lf", &rows, &columns, &rowSpacing, &columnSpacing) != 4 || rows < 2 || columns < 2 ||
+		rowSpacing <= 0 || columnSpacing <= 0){
+		printf("The height field %s needs at least two rows and two columns, with positive spacings\n", fName);
+		fclose(f);
+		return false;
+	}
+
+	heights.resize(rows * columns);
+	for (uint i=0;i<heights.size();i++){
+		if (fscanf(f, "%lf", &heights[i]) != 1){
+			printf("The height field %s should have %d heights, but it only has %d\n", fName, rows * columns, i);
+			fclose(f);
+			return false;
+		}
+	}
+	fclose(f);
+
+	strncpy(fileName, fName, 199);
+	fileName[199] = '\0';
+	return true;
+}
+
+/**
+	This method returns the height field that is stored in the file passed in as a parameter, loading it the first time it is
+	asked for. It returns NULL if the file cannot be read.
+*/
+HeightFieldData* HeightFieldData::getHeightField(const char* fName){
+	lock_guard<mutex> lock(loadedFieldsLock);
+	for (uint i=0;i<loadedFields.size();i++)
+		if (strcmp(loadedFields[i]->fileName, fName) == 0)
+			return loadedFields[i];
+
+	HeightFieldData* field = new HeightFieldData();
+	if (!field->loadFromFile(fName)){
+		delete field;
+		return NULL;
+	}
+	loadedFields.push_back(field);
+	return field;
+}
+
+/**
+	This method computes the height and the (unit) normal of the terrain above the point (x, z) of the grid. It returns false if the
+	point is not over the grid.
+*/
+bool HeightFieldData::getSurface(double x, double z, double* height, Vector3d* normal) const{
+	double u = x / rowSpacing;
+	double v = z / columnSpacing;
+	if (!(u >= 0 && v >= 0 && u <= rows - 1 && v <= columns - 1))
+		return false;
+
+	//find the cell the point is in - the points on the far edges belong to the last cell
+	int i = min((int)u, rows - 2);
+	int j = min((int)v, columns - 2);
+	u -= i;
+	v -= j;
+
+	double h00 = getHeight(i, j);
+	double h10 = getHeight(i+1, j);
+	double h01 = getHeight(i, j+1);
+	double h11 = getHeight(i+1, j+1);
+
+	//and then the triangle of the cell, on one side or the other of the diagonal from (i, j) to (i+1, j+1)
+	double slopeX, slopeZ;
+	if (u >= v){
+		slopeX = h10 - h00;
+		slopeZ = h11 - h10;
+	}else{
+		slopeX = h11 - h01;
+		slopeZ = h01 - h00;
+	}
+	*height = h00 + u * slopeX + v * slopeZ;
+	*normal = Vector3d(-slopeX / rowSpacing, 1, -slopeZ / columnSpacing);
+	normal->toUnit();
+	return true;
+}
+
+HeightFieldCDP::~HeightFieldCDP(void){
+}
+
+/**
+	This method adds a contact point if the sphere of the given radius, centered at the point p (in world coordinates), touches
+	the terrain. The normal points from the sphere into the height field.
+*/
+int HeightFieldCDP::computeCollisionsWithPoint(const Point3d& p, double radius, DynamicArray<ContactPoint> *cps){
+	Point3d lp = bdy->getLocalCoordinates(p);
+	double height;
+	Vector3d n;
+	if (!field->getSurface(lp.x - origin.x, lp.z - origin.z, &height, &n))
+		return 0;
+
+	//this is the distance from the point to the plane of the triangle it is over
+	double dist = (lp.y - origin.y - height) * n.y;
+	if (dist > radius)
+		return 0;
+
+	Vector3d wn = bdy->getWorldCoordinates(n);
+	cps->push_back(ContactPoint());
+	ContactPoint* lastPoint = &(*cps)[cps->size()-1];
+	lastPoint->d = radius - dist;
+	lastPoint->n = wn * -1;
+	lastPoint->cp.setToOffsetFromPoint(p, wn, -radius);
+	return 1;
+}
+
+int HeightFieldCDP::computeCollisionsWith(CollisionDetectionPrimitive* other,  DynamicArray<ContactPoint> *cps){
+	//the normals that the methods below compute already point from other into this height field
+	switch (other->getType()){
+		case SPHERE_CDP:
+			return computeCollisionsWithSphereCDP((SphereCDP*)other, cps);
+		case CAPSULE_CDP:
+			return computeCollisionsWithCapsuleCDP((CapsuleCDP*)other, cps);
+		case BOX_CDP:
+			return computeCollisionsWithBoxCDP((BoxCDP*)other, cps);
+		default:
+			return 0;
+	}
+}
+
+int HeightFieldCDP::computeCollisionsWithSphereCDP(SphereCDP* sp,  DynamicArray<ContactPoint> *cps){
+	return computeCollisionsWithPoint(sp->wS.pos, sp->wS.radius, cps);
+}
+
+/**
+	just like for the planes, we look at the spheres that are at the end points of the capsule
+*/
+int HeightFieldCDP::computeCollisionsWithCapsuleCDP(CapsuleCDP* c,  DynamicArray<ContactPoint> *cps){
+	int n = computeCollisionsWithPoint(c->wC.p1, c->wC.radius, cps);
+	n += computeCollisionsWithPoint(c->wC.p2, c->wC.radius, cps);
+	return n;
+}
+
+/**
+	every corner of the box that is below the terrain generates a contact point
+*/
+int HeightFieldCDP::computeCollisionsWithBoxCDP(BoxCDP* b,  DynamicArray<ContactPoint> *cps){
+	int n = 0;
+	for (int i=0;i<8;i++)
+		n += computeCollisionsWithPoint(b->wCorners[i], 0, cps);
+	return n;
+}
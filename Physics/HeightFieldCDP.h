@@ -0,0 +1,102 @@
+#pragma once
+
+#include <PUtils.h>
+
+#include <Point3d.h>
+#include <Vector3d.h>
+
+#include "CollisionDetectionPrimitive.h"
+
+/**
+	This class holds a grid of terrain heights, as it was read from a file. The grid has rows along the x axis and columns along
+	the z axis: sample (row, column) is at (row * rowSpacing, height, column * columnSpacing). The cell between two rows and two
+	columns is split into two triangles along the diagonal that starts at its (row, column) corner, which is also how PhysX splits
+	the cells of its height fields when their tessellation flag is set.
+
+	A height field is only loaded once, no matter how many bodies (or worlds) use it - see getHeightField.
+*/
+class HeightFieldData{
+private:
+	char fileName[200];
+	int rows, columns;
+	double rowSpacing, columnSpacing;
+	//the heights, one row after the other
+	DynamicArray<double> heights;
+
+	//all the height fields that have been loaded so far. They stay around until the program ends
+	static DynamicArray<HeightFieldData*> loadedFields;
+
+	HeightFieldData(void);
+
+	/**
+		This method reads the height field from a file. It returns false if the file cannot be read.
+	*/
+	bool loadFromFile(const char* fName);
+
+public:
+	/**
+		This method returns the height field that is stored in the file passed in as a parameter, loading it the first time it is
+		asked for. It returns NULL if the file cannot be read.
+	*/
+	static HeightFieldData* getHeightField(const char* fName);
+
+	inline int getRowCount() const {return rows;}
+	inline int getColumnCount() const {return columns;}
+	inline double getRowSpacing() const {return rowSpacing;}
+	inline double getColumnSpacing() const {return columnSpacing;}
+	inline const char* getFileName() const {return fileName;}
+
+	/**
+		returns the height of the sample at the given row and column
+	*/
+	inline double getHeight(int row, int column) const {
+		return heights[row * columns + column];
+	}
+
+	/**
+		This method computes the height and the (unit) normal of the terrain above the point (x, z) of the grid. It returns false if the
+		point is not over the grid.
+	*/
+	bool getSurface(double x, double z, double* height, Vector3d* normal) const;
+};
+
+/*========================================================================================================================================================================*
+ * This class implements a height field that will be used as a collision detection primitive. It is meant for the terrain the characters walk on: finding the contacts   *
+ * of a point only looks at the one cell of the grid that is under it, so a large and detailed terrain costs no more than a flat plane. Like the planes, height fields    *
+ * are only expected on fixed objects, and they only collide with spheres, capsules and boxes.                                                                           *
+ *========================================================================================================================================================================*/
+class HeightFieldCDP : public CollisionDetectionPrimitive{
+private:
+	//the heights - they are shared by all the primitives that load the same file
+	HeightFieldData* field;
+	//this is the position of the first sample of the grid, expressed in the local coordinates of the rigid body that owns it
+	Point3d origin;
+
+	/**
+		This method adds a contact point if the sphere of the given radius, centered at the point p (in world coordinates), touches
+		the terrain. The normal points from the sphere into the height field.
+	*/
+	int computeCollisionsWithPoint(const Point3d& p, double radius, DynamicArray<ContactPoint> *cps);
+
+public:
+	HeightFieldCDP(HeightFieldData* field, const Point3d& origin, RigidBody* theBody = NULL) :
+		CollisionDetectionPrimitive( HEIGHT_FIELD_CDP, theBody ),
+		field(field),
+		origin(origin) {}
+	virtual ~HeightFieldCDP(void);
+
+	virtual const char* save() { return "HeightFieldCDP"; }
+
+	//the contacts are computed in the local coordinates of the body, so there is nothing to update
+	virtual void updateToWorldPrimitive(){}
+
+	inline HeightFieldData* getHeightField() {return field;}
+	inline const Point3d& getOrigin() const {return origin;}
+
+	virtual int computeCollisionsWith(CollisionDetectionPrimitive* other,  DynamicArray<ContactPoint> *cps);
+
+	virtual int computeCollisionsWithSphereCDP(SphereCDP* sp,  DynamicArray<ContactPoint> *cps);
+	virtual int computeCollisionsWithPlaneCDP(PlaneCDP* p,  DynamicArray<ContactPoint> *cps){return 0;}
+	virtual int computeCollisionsWithCapsuleCDP(CapsuleCDP* c,  DynamicArray<ContactPoint> *cps);
+	virtual int computeCollisionsWithBoxCDP(BoxCDP* b,  DynamicArray<ContactPoint> *cps);
+};
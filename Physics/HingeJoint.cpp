@@ -1,6 +1,6 @@
 #include "stdafx.h"
 
-#include "Hingejoint.h"
+#include "HingeJoint.h"
 #include <PUtils.h>
 
 #include "ArticulatedRigidBody.h"
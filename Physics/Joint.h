@@ -24,6 +24,7 @@
 #pragma once
 
 #include <typeinfo>
+#include <cstring>
 
 #include <Vector3d.h>
 #include <Quaternion.h>
@@ -49,6 +50,9 @@ friend class StiffJoint;
 friend class HingeJoint;
 friend class UniversalJoint;
 friend class PhysX3World;
+friend class NativeWorld;
+friend class RBDynJoint;
+friend class ABAFigure;
 friend class Character;
 friend class SimBiController;
 friend class IKVMCController;
@@ -151,6 +155,11 @@ public:
 	*/
 	inline void setTorque(const Vector3d& t){torque = t;}
 
+	/**
+		turns the joint limits of this joint on or off
+	*/
+	inline void setUseJointLimits(bool b){useJointLimits = b;}
+
 	/**
 		retrieves the reference to the body's parent
 	*/
@@ -203,7 +212,8 @@ public:
 		sets the name
 	*/
 	inline void setName( const char* name ) {
-		strncpy_s( this->name, name, 99 );
+		strncpy( this->name, name, 99 );
+		this->name[99] = '\0';
 	}
 
 
@@ -0,0 +1,656 @@
+#include "stdafx.h"
+
+#include "NativeWorld.h"
+#include <PUtils.h>
+#include "Joint.h"
+#include "PhysicsGlobals.h"
+#include <Profiler.h>
+#include <cmath>
+
+/**
+	constructor. If reducedCoordinates is true, the articulated figures are simulated in reduced coordinates.
+*/
+NativeWorld::NativeWorld(bool reducedCoordinates, bool deterministic) : World(deterministic){
+	this->reducedCoordinates = reducedCoordinates;
+	solverIterations = 20;
+	erp = 0.2;
+	contactSlop = 0.001;
+	maxCorrectionVelocity = 1.0;
+}
+
+/**
+	destructor
+*/
+NativeWorld::~NativeWorld(void){
+	destroyWorld();
+}
+
+void NativeWorld::destroyWorld() {
+	for (uint i=0;i<rbJoints.size();i++)
+		delete rbJoints[i];
+	rbJoints.clear();
+	for (uint i=0;i<abaFigures.size();i++)
+		delete abaFigures[i];
+	abaFigures.clear();
+	bodyFigures.clear();
+	bodyLinks.clear();
+	solverVelocities.clear();
+	solverAngularVelocities.clear();
+	jointLimits.clear();
+	accumulators.clear();
+	contacts.clear();
+	World::destroyWorld();
+}
+
+void NativeWorld::destroyAllObjects() {
+	destroyWorld();
+}
+
+/**
+	This method links the rigid bodies and the joints that were added to the world since the last time it was called to the engine.
+*/
+void NativeWorld::linkNewObjects(){
+	//the id of a body is its index in the list of objects, and the index of its force accumulator
+	for (uint i=accumulators.size();i<objects.size();i++){
+		objects[i]->setBodyID(i);
+		accumulators.push_back(RBForceAccumulator());
+	}
+	//in reduced coordinates the joints are part of the figures, so they never need to be enforced
+	if (reducedCoordinates){
+		bodyFigures.resize(objects.size(), -1);
+		bodyLinks.resize(objects.size(), -1);
+		solverVelocities.resize(objects.size());
+		solverAngularVelocities.resize(objects.size());
+		for (uint i=abaFigures.size();i<AFs.size();i++){
+			abaFigures.push_back(new ABAFigure(AFs[i]));
+			for (int j=0;j<abaFigures[i]->getLinkCount();j++){
+				bodyFigures[abaFigures[i]->getLinkBody(j)->id] = i;
+				bodyLinks[abaFigures[i]->getLinkBody(j)->id] = j;
+			}
+		}
+	}else{
+		for (uint i=rbJoints.size();i<jts.size();i++)
+			rbJoints.push_back(new RBDynJoint(jts[i]));
+	}
+
+	//the contact lists are sized here, once, so that the simulation steps never have to grow them. Every articulated figure can
+	//bring up to MAX_CONTACT_POINTS contacts with it
+	uint maxContacts = MAX_CONTACT_POINTS * ((AFs.size() > 1) ? AFs.size() : 1);
+	contacts.reserve(maxContacts);
+	jointLimits.reserve(jts.size() * RBDYN_MAX_ANGULAR_ROWS);
+	contactPoints.reserve(maxContacts);
+	tmpContactPoints.reserve(MAX_CONTACT_POINTS);
+}
+
+/**
+	This method reads a list of rigid bodies from the specified file.
+*/
+void NativeWorld::loadRBsFromFile(char* fName){
+	World::loadRBsFromFile(fName);
+	linkNewObjects();
+}
+
+/**
+	This method adds one rigid body (not articulated).
+*/
+void NativeWorld::addRigidBody( RigidBody* rigidBody ) {
+	World::addRigidBody(rigidBody);
+	linkNewObjects();
+}
+
+/**
+	This method adds one articulated figure.
+*/
+void NativeWorld::addArticulatedFigure(ArticulatedFigure* articulatedFigure){
+	World::addArticulatedFigure(articulatedFigure);
+	linkNewObjects();
+	updateCharacterHeight();
+}
+
+/**
+	This method is used to add the forces and torques that act on the bodies to their accumulators: gravity, the external forces and the joint torques.
+*/
+void NativeWorld::accumulateForces(){
+	Vector3d g = PhysicsGlobals::up * PhysicsGlobals::gravity;
+	for (uint i=0;i<objects.size();i++){
+		if (objects[i]->isLocked())
+			continue;
+		accumulators[i].netForce += g * objects[i]->props.mass + objects[i]->externalForce;
+		accumulators[i].netTorque += objects[i]->externalTorque;
+	}
+
+	//the joint torques are applied to the parent, and the opposite torques to the child
+	for (uint i=0;i<jts.size();i++){
+		accumulators[jts[i]->parent->id].netTorque += jts[i]->torque;
+		accumulators[jts[i]->child->id].netTorque -= jts[i]->torque;
+	}
+}
+
+/**
+	This method returns 1/(u' * K * u), where K is the collision matrix of the contact. With reduced coordinates K is that of the figures
+	the bodies are part of, so the articulated inertias of the figures must be up to date.
+*/
+double NativeWorld::getEffectiveMass(NativeContact* c, const Vector3d& u){
+	if (reducedCoordinates){
+		//rb2 gets the opposite impulse, and the relative velocity subtracts its velocity, so both responses add up
+		double k = u.dotProductWith(getReducedResponse(c->rb1, c->r1, u) + getReducedResponse(c->rb2, c->r2, u));
+		return (k > 1e-12) ? (1 / k) : 0;
+	}
+	Vector3d r1u = c->r1.crossProductWith(u);
+	Vector3d r2u = c->r2.crossProductWith(u);
+	double k = c->rb1->props.invMass + c->rb2->props.invMass +
+		r1u.dotProductWith(RBDynJoint::applyInverseInertia(c->rb1, r1u)) + r2u.dotProductWith(RBDynJoint::applyInverseInertia(c->rb2, r2u));
+	return (k > 1e-12) ? (1 / k) : 0;
+}
+
+/**
+	This method finds all the contact points between the two bodies. b can be a locked body, but a can not.
+*/
+void NativeWorld::collidePair(RigidBody* a, RigidBody* b, double deltaT){
+	for (uint i=0;i<a->cdps.size();i++){
+		for (uint j=0;j<b->cdps.size();j++){
+			tmpContactPoints.clear();
+			//the normals point from b into a
+			a->cdps[i]->computeCollisionsWith(b->cdps[j], &tmpContactPoints);
+			for (uint k=0;k<tmpContactPoints.size();k++){
+				NativeContact c;
+				c.rb1 = a;
+				c.rb2 = b;
+				c.cdp1 = i;
+				c.cdp2 = j;
+				c.index = k;
+				c.cp = tmpContactPoints[k].cp;
+				c.n = tmpContactPoints[k].n;
+				c.d = tmpContactPoints[k].d;
+				c.n.getOrthogonalVectors(&c.t1, &c.t2);
+				c.r1 = Vector3d(a->state.position, c.cp);
+				c.r2 = Vector3d(b->state.position, c.cp);
+				c.massN = getEffectiveMass(&c, c.n);
+				c.massT1 = getEffectiveMass(&c, c.t1);
+				c.massT2 = getEffectiveMass(&c, c.t2);
+				c.bias = (c.d - contactSlop) * erp / deltaT;
+				if (c.bias < 0) c.bias = 0;
+				if (c.bias > maxCorrectionVelocity) c.bias = maxCorrectionVelocity;
+				c.mu = (a->props.mu < b->props.mu) ? a->props.mu : b->props.mu;
+				c.lambdaN = c.lambdaT1 = c.lambdaT2 = 0;
+				contacts.push_back(c);
+			}
+		}
+	}
+}
+
+/**
+	This method finds all the contact points between the bodies in the world, and sets up their solver data.
+*/
+void NativeWorld::collideBodies(double deltaT){
+	PROFILE_SCOPE(PROFILE_CONTACT_PROCESSING);
+	contacts.clear();
+	for (uint i=0;i<objects.size();i++)
+		objects[i]->updateWorldCDPs();
+
+	//the pairs are always visited in the same order, so the results do not depend on anything but the state of the world
+	for (uint i=0;i<objects.size();i++){
+		for (uint j=i+1;j<objects.size();j++){
+			RigidBody* a = objects[i];
+			RigidBody* b = objects[j];
+			if (a->isLocked() && b->isLocked())
+				continue;
+			//the bodies of one figure do not collide with each other, the joint limits take care of that. The figures of a crowd still do
+			if (a->isArticulated() && b->isArticulated() && ((ArticulatedRigidBody*)a)->getAFParent() == ((ArticulatedRigidBody*)b)->getAFParent())
+				continue;
+			if (a->isLocked())
+				collidePair(b, a, deltaT);
+			else
+				collidePair(a, b, deltaT);
+		}
+	}
+}
+
+/**
+	This method applies the impulse that is passed in to rb1 at the contact point, and the opposite impulse to rb2.
+*/
+void NativeWorld::applyContactImpulse(NativeContact* c, const Vector3d& impulse){
+	if (reducedCoordinates){
+		applyReducedImpulse(c->rb1, c->r1, impulse);
+		applyReducedImpulse(c->rb2, c->r2, impulse * -1);
+		return;
+	}
+	c->rb1->state.velocity += impulse * c->rb1->props.invMass;
+	c->rb1->state.angularVelocity += RBDynJoint::applyInverseInertia(c->rb1, c->r1.crossProductWith(impulse));
+	if (c->rb2->isLocked())
+		return;
+	c->rb2->state.velocity -= impulse * c->rb2->props.invMass;
+	c->rb2->state.angularVelocity -= RBDynJoint::applyInverseInertia(c->rb2, c->r2.crossProductWith(impulse));
+}
+
+/**
+	This method returns the velocity of the contact point on rb1, relative to the one on rb2. With reduced coordinates these are the solver velocities.
+*/
+Vector3d NativeWorld::getRelativeVelocity(NativeContact* c){
+	if (reducedCoordinates)
+		return (solverVelocities[c->rb1->id] + solverAngularVelocities[c->rb1->id].crossProductWith(c->r1)) -
+			   (solverVelocities[c->rb2->id] + solverAngularVelocities[c->rb2->id].crossProductWith(c->r2));
+	return (c->rb1->state.velocity + c->rb1->state.angularVelocity.crossProductWith(c->r1)) -
+		   (c->rb2->state.velocity + c->rb2->state.angularVelocity.crossProductWith(c->r2));
+}
+
+/**
+	This method does one sequential impulse pass over the contact passed in as a parameter.
+*/
+void NativeWorld::solveContact(NativeContact* c){
+	Vector3d vRel = getRelativeVelocity(c);
+
+	//the normal impulse can only push the bodies apart
+	double oldLambda = c->lambdaN;
+	c->lambdaN = oldLambda + c->massN * (c->bias - vRel.dotProductWith(c->n));
+	if (c->lambdaN < 0) c->lambdaN = 0;
+	applyContactImpulse(c, c->n * (c->lambdaN - oldLambda));
+
+	//and friction is bounded by the normal impulse, separately along the two directions
+	vRel = getRelativeVelocity(c);
+	double limit = c->mu * c->lambdaN;
+
+	oldLambda = c->lambdaT1;
+	c->lambdaT1 = oldLambda - c->massT1 * vRel.dotProductWith(c->t1);
+	if (c->lambdaT1 < -limit) c->lambdaT1 = -limit;
+	if (c->lambdaT1 > limit) c->lambdaT1 = limit;
+	Vector3d impulse = c->t1 * (c->lambdaT1 - oldLambda);
+
+	oldLambda = c->lambdaT2;
+	c->lambdaT2 = oldLambda - c->massT2 * vRel.dotProductWith(c->t2);
+	if (c->lambdaT2 < -limit) c->lambdaT2 = -limit;
+	if (c->lambdaT2 > limit) c->lambdaT2 = limit;
+	impulse += c->t2 * (c->lambdaT2 - oldLambda);
+
+	applyContactImpulse(c, impulse);
+}
+
+/**
+	This method is used to integrate the forward simulation in time.
+*/
+void NativeWorld::advanceInTime(double deltaT){
+	if( deltaT <= 0 )
+		return;
+	PROFILE_SCOPE(PROFILE_ENGINE_SIMULATE);
+
+	//the bodies and joints may have been added directly to the lists by someone else, so make sure we know about all of them
+	linkNewObjects();
+
+	if (reducedCoordinates){
+		advanceInTimeReduced(deltaT);
+		return;
+	}
+
+	//clear the previous list of contact forces
+	contactPoints.clear();
+
+	//integrate the velocities, using all the forces that act on the bodies
+	accumulateForces();
+	for (uint i=0;i<objects.size();i++){
+		RigidBody* rb = objects[i];
+		if (!rb->isLocked()){
+			rb->state.velocity += accumulators[i].netForce * (rb->props.invMass * deltaT);
+			rb->state.angularVelocity += RBDynJoint::applyInverseInertia(rb, accumulators[i].netTorque) * deltaT;
+		}
+		accumulators[i].netForce = Vector3d(0,0,0);
+		accumulators[i].netTorque = Vector3d(0,0,0);
+	}
+
+	//now set up all the constraints
+	collideBodies(deltaT);
+	for (uint i=0;i<rbJoints.size();i++)
+		rbJoints[i]->prepare(erp, deltaT);
+
+	//and solve them. The joints keep their impulses from the previous step, which gives the solver a good place to start from
+	for (uint i=0;i<rbJoints.size();i++)
+		rbJoints[i]->warmStart();
+	for (int k=0;k<solverIterations;k++){
+		for (uint i=0;i<rbJoints.size();i++)
+			rbJoints[i]->solve();
+		for (uint i=0;i<contacts.size();i++)
+			solveContact(&contacts[i]);
+	}
+
+	//report the contact forces, with f being applied to rb1 and -f to rb2
+	for (uint i=0;i<contacts.size();i++){
+		NativeContact* c = &contacts[i];
+		if (c->lambdaN <= 0)
+			continue;
+		contactPoints.push_back(ContactPoint());
+		ContactPoint* lastPoint = &contactPoints[contactPoints.size()-1];
+		lastPoint->cp = c->cp;
+		lastPoint->n = c->n;
+		lastPoint->d = c->d;
+		lastPoint->rb1 = c->rb1;
+		lastPoint->rb2 = c->rb2;
+		lastPoint->f = (c->n * c->lambdaN + c->t1 * c->lambdaT1 + c->t2 * c->lambdaT2) / deltaT;
+	}
+
+	//and finally integrate the positions
+	for (uint i=0;i<objects.size();i++){
+		RigidBody* rb = objects[i];
+		if (rb->isLocked())
+			continue;
+		rb->state.position += rb->state.velocity * deltaT;
+		Quaternion dq = Quaternion(0, rb->state.angularVelocity) * rb->state.orientation;
+		dq *= 0.5 * deltaT;
+		rb->state.orientation += dq;
+		rb->state.orientation.toUnit();
+	}
+
+	indexContactPoints();
+	updateStepHash();
+}
+
+/**
+	This method returns the change in the velocity of the point that is r away from the center of mass of rb, when the impulse u is applied
+	there. With reduced coordinates only.
+*/
+Vector3d NativeWorld::getReducedResponse(RigidBody* rb, const Vector3d& r, const Vector3d& u){
+	if (rb->isLocked())
+		return Vector3d(0,0,0);
+	Vector3d dv, dw;
+	int f = bodyFigures[rb->id];
+	if (f >= 0){
+		abaFigures[f]->computeImpulseResponse(bodyLinks[rb->id], u, r);
+		abaFigures[f]->getVelocityChange(bodyLinks[rb->id], &dv, &dw);
+	}else{
+		dv = u * rb->props.invMass;
+		dw = RBDynJoint::applyInverseInertia(rb, r.crossProductWith(u));
+	}
+	return dv + dw.crossProductWith(r);
+}
+
+/**
+	This method applies the impulse that is passed in to rb at the point that is r away from its center of mass, and updates the solver velocities
+	of all the bodies that it moves. With reduced coordinates only.
+*/
+void NativeWorld::applyReducedImpulse(RigidBody* rb, const Vector3d& r, const Vector3d& impulse){
+	//an impulse on one link moves the whole figure, so the ones that change nothing are skipped
+	if (rb->isLocked() || (impulse.x == 0 && impulse.y == 0 && impulse.z == 0))
+		return;
+	int f = bodyFigures[rb->id];
+	if (f < 0){
+		solverVelocities[rb->id] += impulse * rb->props.invMass;
+		solverAngularVelocities[rb->id] += RBDynJoint::applyInverseInertia(rb, r.crossProductWith(impulse));
+		return;
+	}
+	abaFigures[f]->computeImpulseResponse(bodyLinks[rb->id], impulse, r);
+	addVelocityChanges(abaFigures[f]);
+}
+
+/**
+	This method adds the velocity changes of the last impulse response of the figure to the solver velocities. With reduced coordinates only.
+*/
+void NativeWorld::addVelocityChanges(ABAFigure* af){
+	for (int i=0;i<af->getLinkCount();i++){
+		Vector3d dv, dw;
+		af->getVelocityChange(i, &dv, &dw);
+		int id = af->getLinkBody(i)->id;
+		solverVelocities[id] += dv;
+		solverAngularVelocities[id] += dw;
+	}
+}
+
+/**
+	This method adds a joint limit for the angle (whose rate of change is the relative angular velocity along axis) of the link of the figure,
+	if it is about to leave [minAngle, maxAngle]. With reduced coordinates only.
+*/
+void NativeWorld::addJointLimit(int figure, int link, const Vector3d& axis, double angle, double minAngle, double maxAngle, double deltaT){
+	ABAFigure* af = abaFigures[figure];
+	NativeJointLimit l;
+	l.figure = figure;
+	l.link = link;
+	l.child = af->getLinkBody(link);
+	l.parent = af->getLinkBody(af->getLinkParent(link));
+	l.lambda = 0;
+
+	//as with maximal coordinates, look ahead one step, so that the limit is caught before it is crossed rather than after
+	Vector3d wRel = l.child->state.angularVelocity - l.parent->state.angularVelocity;
+	double predictedAngle = angle + wRel.dotProductWith(axis) * deltaT;
+	double err;
+	if (predictedAngle < minAngle){
+		l.axis = axis;
+		err = minAngle - angle;
+	}else if (predictedAngle > maxAngle){
+		l.axis = axis * -1;
+		err = angle - maxAngle;
+	}else
+		return;
+	l.bias = (err > 0) ? (err * erp / deltaT) : (err / deltaT);
+
+	af->computeJointImpulseResponse(link, l.axis);
+	Vector3d dv, dwC, dwP;
+	af->getVelocityChange(link, &dv, &dwC);
+	af->getVelocityChange(af->getLinkParent(link), &dv, &dwP);
+	double k = (dwC - dwP).dotProductWith(l.axis);
+	l.mass = (k > 1e-12) ? (1 / k) : 0;
+	jointLimits.push_back(l);
+}
+
+/**
+	This method finds the joint limits of the figures that are about to be violated, and sets up their solver data. With reduced coordinates only.
+*/
+void NativeWorld::collectJointLimits(double deltaT){
+	jointLimits.clear();
+	RBDynLimitedAngle limits[RBDYN_MAX_ANGULAR_ROWS];
+	for (uint f=0;f<abaFigures.size();f++){
+		for (int i=1;i<abaFigures[f]->getLinkCount();i++){
+			Joint* j = abaFigures[f]->getLinkJoint(i);
+			if (!j->useJointLimits)
+				continue;
+			Quaternion qRel;
+			j->computeRelativeOrientation(qRel);
+			int n = RBDynJoint::getLimitedAngles(j, qRel, limits);
+			for (int k=0;k<n;k++)
+				addJointLimit(f, i, limits[k].axis, limits[k].angle, limits[k].minAngle, limits[k].maxAngle, deltaT);
+		}
+	}
+}
+
+/**
+	This method does one sequential impulse pass over the joint limit passed in as a parameter. With reduced coordinates only.
+*/
+void NativeWorld::solveJointLimit(NativeJointLimit* l){
+	double wRel = (solverAngularVelocities[l->child->id] - solverAngularVelocities[l->parent->id]).dotProductWith(l->axis);
+	double oldLambda = l->lambda;
+	l->lambda = oldLambda + l->mass * (l->bias - wRel);
+	if (l->lambda < 0) l->lambda = 0;
+	if (l->lambda == oldLambda)
+		return;
+	abaFigures[l->figure]->computeJointImpulseResponse(l->link, l->axis * (l->lambda - oldLambda));
+	addVelocityChanges(abaFigures[l->figure]);
+}
+
+/**
+	This method solves the contacts and the joint limits with reduced coordinates, and adds the forces they need to the force accumulators. The
+	accelerations of the figures must be up to date, since the velocities at the end of the step and the impulse responses are computed from them.
+*/
+void NativeWorld::solveReducedConstraints(double deltaT){
+	//the impulses work on the velocities the bodies would have at the end of the step without any contacts
+	for (uint i=0;i<objects.size();i++){
+		RigidBody* rb = objects[i];
+		solverVelocities[i] = Vector3d(0,0,0);
+		solverAngularVelocities[i] = Vector3d(0,0,0);
+		if (rb->isLocked())
+			continue;
+		if (bodyFigures[i] >= 0){
+			Vector3d a, alpha;
+			abaFigures[bodyFigures[i]]->getAcceleration(bodyLinks[i], &a, &alpha);
+			solverVelocities[i] = rb->state.velocity + a * deltaT;
+			solverAngularVelocities[i] = rb->state.angularVelocity + alpha * deltaT;
+		}else{
+			Vector3d w = rb->state.angularVelocity;
+			Vector3d Iw = rb->state.orientation.inverseRotate(w);
+			Iw.x *= rb->props.MOI_local.x;
+			Iw.y *= rb->props.MOI_local.y;
+			Iw.z *= rb->props.MOI_local.z;
+			Iw = rb->state.orientation.rotate(Iw);
+			solverVelocities[i] = rb->state.velocity + accumulators[i].netForce * (rb->props.invMass * deltaT);
+			solverAngularVelocities[i] = w + RBDynJoint::applyInverseInertia(rb, accumulators[i].netTorque - w.crossProductWith(Iw)) * deltaT;
+		}
+	}
+
+	for (int k=0;k<solverIterations;k++){
+		for (uint i=0;i<jointLimits.size();i++)
+			solveJointLimit(&jointLimits[i]);
+		for (uint i=0;i<contacts.size();i++)
+			solveContact(&contacts[i]);
+	}
+
+	//the limit impulses become torques, applied to the link and the opposite ones to its parent
+	for (uint i=0;i<jointLimits.size();i++){
+		Vector3d t = jointLimits[i].axis * (jointLimits[i].lambda / deltaT);
+		accumulators[jointLimits[i].child->id].netTorque += t;
+		accumulators[jointLimits[i].parent->id].netTorque -= t;
+	}
+
+	//the impulses become forces that act over the whole step, with f being applied to rb1 and -f to rb2
+	for (uint i=0;i<contacts.size();i++){
+		NativeContact* c = &contacts[i];
+		if (c->lambdaN <= 0)
+			continue;
+		Vector3d f = (c->n * c->lambdaN + c->t1 * c->lambdaT1 + c->t2 * c->lambdaT2) / deltaT;
+		accumulators[c->rb1->id].netForce += f;
+		accumulators[c->rb1->id].netTorque += c->r1.crossProductWith(f);
+		if (!c->rb2->isLocked()){
+			accumulators[c->rb2->id].netForce -= f;
+			accumulators[c->rb2->id].netTorque -= c->r2.crossProductWith(f);
+		}
+
+		contactPoints.push_back(ContactPoint());
+		ContactPoint* lastPoint = &contactPoints[contactPoints.size()-1];
+		lastPoint->cp = c->cp;
+		lastPoint->n = c->n;
+		lastPoint->d = c->d;
+		lastPoint->rb1 = c->rb1;
+		lastPoint->rb2 = c->rb2;
+		lastPoint->f = f;
+	}
+}
+
+/**
+	This method integrates the state of a rigid body that is not part of an articulated figure, using the forces in its accumulator.
+*/
+void NativeWorld::integrateFreeBody(RigidBody* rb, double deltaT){
+	Vector3d w = rb->state.angularVelocity;
+	Vector3d Iw = rb->state.orientation.inverseRotate(w);
+	Iw.x *= rb->props.MOI_local.x;
+	Iw.y *= rb->props.MOI_local.y;
+	Iw.z *= rb->props.MOI_local.z;
+	Iw = rb->state.orientation.rotate(Iw);
+	rb->state.velocity += accumulators[rb->id].netForce * (rb->props.invMass * deltaT);
+	rb->state.angularVelocity += RBDynJoint::applyInverseInertia(rb, accumulators[rb->id].netTorque - w.crossProductWith(Iw)) * deltaT;
+
+	rb->state.position += rb->state.velocity * deltaT;
+	Quaternion dq = Quaternion(0, rb->state.angularVelocity) * rb->state.orientation;
+	dq *= 0.5 * deltaT;
+	rb->state.orientation += dq;
+	rb->state.orientation.toUnit();
+}
+
+/**
+	This method is used to integrate the forward simulation in time, with the articulated figures in reduced coordinates.
+*/
+void NativeWorld::advanceInTimeReduced(double deltaT){
+	//clear the previous list of contact forces
+	contactPoints.clear();
+
+	//the accelerations without the contacts and the limits come first, which are then solved with the articulated inertias they leave behind
+	accumulateForces();
+	for (uint i=0;i<abaFigures.size();i++)
+		abaFigures[i]->computeAccelerations(&accumulators);
+	collideBodies(deltaT);
+	collectJointLimits(deltaT);
+	solveReducedConstraints(deltaT);
+
+	//and then the figures move with the contact and limit forces added in
+	for (uint i=0;i<abaFigures.size();i++){
+		if (contacts.size() > 0 || jointLimits.size() > 0)
+			abaFigures[i]->computeAccelerations(&accumulators);
+		abaFigures[i]->integrate(deltaT);
+	}
+	for (uint i=0;i<objects.size();i++)
+		if (!objects[i]->isLocked() && !objects[i]->isArticulated())
+			integrateFreeBody(objects[i], deltaT);
+
+	for (uint i=0;i<accumulators.size();i++){
+		accumulators[i].netForce = Vector3d(0,0,0);
+		accumulators[i].netTorque = Vector3d(0,0,0);
+	}
+
+	indexContactPoints();
+	updateStepHash();
+}
+
+/**
+	This method saves the state of the world in the snapshot. The impulses that warm start the joints are saved as well, since they carry
+	over from one step to the next.
+*/
+void NativeWorld::saveSnapshot(WorldSnapshot* snapshot){
+	World::saveSnapshot(snapshot);
+	//the impulses that warm start the joints come first, one block per joint
+	snapshot->engineState.resize(rbJoints.size() * RBDYN_WARM_START_SIZE);
+	for (uint i=0;i<rbJoints.size();i++)
+		rbJoints[i]->getWarmStartImpulses(&snapshot->engineState[i * RBDYN_WARM_START_SIZE]);
+}
+
+/**
+	This method puts the world back in the state that was saved in the snapshot.
+*/
+bool NativeWorld::restoreSnapshot(const WorldSnapshot& snapshot){
+	uint jointValues = rbJoints.size() * RBDYN_WARM_START_SIZE;
+	if (snapshot.engineState.size() != jointValues){
+		printf("The snapshot was not taken from this native world\n");
+		return false;
+	}
+	if (!World::restoreSnapshot(snapshot))
+		return false;
+
+	for (uint i=0;i<rbJoints.size();i++)
+		rbJoints[i]->setWarmStartImpulses(&snapshot.engineState[i * RBDYN_WARM_START_SIZE]);
+
+	//forces that were applied after the snapshot was taken should not act on the restored state
+	for (uint i=0;i<accumulators.size();i++){
+		accumulators[i].netForce = Vector3d(0,0,0);
+		accumulators[i].netTorque = Vector3d(0,0,0);
+	}
+	return true;
+}
+
+/**
+	This method is for performance analysis
+*/
+void NativeWorld::printAllCOMPosition(){
+}
+
+/**
+	this method applies a force to a rigid body, at the specified point. The point is specified in local coordinates,
+	and the force is also specified in local coordinates.
+*/
+void NativeWorld::applyRelForceTo(RigidBody* b, const Vector3d& f, const Point3d& p){
+	if (!b)
+		return;
+	applyForceTo(b, b->getWorldCoordinates(f), p);
+}
+
+/**
+	this method applies a force to a rigid body, at the specified point. The point is specified in local coordinates,
+	and the force is specified in world coordinates.
+*/
+void NativeWorld::applyForceTo(RigidBody* b, const Vector3d& f, const Point3d& p){
+	if (!b)
+		return;
+	Vector3d r = Vector3d(b->state.position, b->getWorldCoordinates(p));
+	accumulators[b->id].netForce += f;
+	accumulators[b->id].netTorque += r.crossProductWith(f);
+}
+
+/**
+	this method applies a torque to a rigid body. The torque is specified in world coordinates.
+*/
+void NativeWorld::applyTorqueTo(RigidBody* b, const Vector3d& t){
+	if (!b)
+		return;
+	accumulators[b->id].netTorque += t;
+}
@@ -0,0 +1,258 @@
+#pragma once
+
+#include "World.h"
+#include "CollisionDetectionPrimitive.h"
+#include "SphereCDP.h"
+#include "CapsuleCDP.h"
+#include "BoxCDP.h"
+#include "PlaneCDP.h"
+#include "RBForceAccumulator.h"
+#include "RBDynJoint.h"
+#include "ABAFigure.h"
+
+/**
+	This structure holds the solver data for one contact point. rb1 is never a locked body, and the normal points from rb2 into rb1.
+*/
+typedef struct NativeContact_struct{
+	RigidBody* rb1;
+	RigidBody* rb2;
+	//the indices of the two collision detection primitives that generated the contact, and the index of the contact between them
+	int cdp1, cdp2, index;
+	//the contact point and the normal, in world coordinates, and the penetration depth
+	Point3d cp;
+	Vector3d n;
+	double d;
+	//the two friction directions
+	Vector3d t1, t2;
+	//the vectors from the centers of mass of the two bodies to the contact point
+	Vector3d r1, r2;
+	//the effective masses along the normal and along the two friction directions
+	double massN, massT1, massT2;
+	//the target normal velocity, used to push the bodies apart when they penetrate
+	double bias;
+	double mu;
+	//the impulses accumulated over the solver iterations
+	double lambdaN, lambdaT1, lambdaT2;
+} NativeContact;
+
+/**
+	With reduced coordinates, the joint limits are solved together with the contacts. This structure holds the solver data for one limit that is
+	about to be violated: the angular velocity of the link relative to its parent, along axis, has to be at least bias.
+*/
+typedef struct NativeJointLimit_struct{
+	//the figure, and the link whose joint is limited
+	int figure, link;
+	RigidBody* parent;
+	RigidBody* child;
+	Vector3d axis;
+	double bias;
+	//the effective mass along the axis, and the impulse accumulated over the solver iterations
+	double mass;
+	double lambda;
+} NativeJointLimit;
+
+/*-----------------------------------------------------------------------------------------------------------------------------------------------------*
+ * This class implements an in-house rigid body engine. Collisions are detected with the collision detection primitives of the rigid bodies, and    *
+ * the joints and the contacts are solved together with sequential impulses, directly on the state of the rigid bodies. It does not depend on any   *
+ * third party library, so it can be used anywhere the rest of the framework builds.                                                                 *
+ * With reduced coordinates, the articulated figures are simulated with the articulated body algorithm instead, so their joints are exact. The      *
+ * contacts and the joint limits are still solved with sequential impulses, but an impulse then moves the whole figure, through its articulated    *
+ * inertias.                                                                                                                                         *
+ *-----------------------------------------------------------------------------------------------------------------------------------------------------*/
+class NativeWorld : public World{
+private:
+	//the forces and torques that are applied to the ith object in the world during the current step
+	DynamicArray<RBForceAccumulator> accumulators;
+	//the constraint data for each one of the joints in the world (in the same order as jts)
+	DynamicArray<RBDynJoint*> rbJoints;
+	//the contacts that are being solved for the current step
+	DynamicArray<NativeContact> contacts;
+	//this is a temporary list used to collect the contact points between two collision detection primitives
+	DynamicArray<ContactPoint> tmpContactPoints;
+
+	//if this is true, the articulated figures are simulated in reduced coordinates, one ABAFigure each (in the same order as AFs)
+	bool reducedCoordinates;
+	DynamicArray<ABAFigure*> abaFigures;
+	//for the ith object in the world, the index of its figure in abaFigures and of its link in that figure, or -1 if it is not part of one
+	DynamicArray<int> bodyFigures, bodyLinks;
+	//with reduced coordinates, the velocities the bodies would have at the end of the step, which the contact impulses work on
+	DynamicArray<Vector3d> solverVelocities, solverAngularVelocities;
+	//with reduced coordinates, the joint limits that are being solved for the current step
+	DynamicArray<NativeJointLimit> jointLimits;
+
+	//the number of sequential impulse passes done every step
+	int solverIterations;
+	//the fraction of the joint drift and of the penetration that is corrected in one step
+	double erp;
+	//penetrations smaller than this are not corrected, which keeps resting contacts from jittering
+	double contactSlop;
+	//the largest velocity that is used to push penetrating bodies apart
+	double maxCorrectionVelocity;
+
+	/**
+		This method links the rigid bodies and the joints that were added to the world since the last time it was called to the engine.
+	*/
+	void linkNewObjects();
+
+	/**
+		This method is used to add the forces and torques that act on the bodies to their accumulators: gravity, the external forces and the joint torques.
+	*/
+	void accumulateForces();
+
+	/**
+		This method finds all the contact points between the bodies in the world, and sets up their solver data.
+	*/
+	void collideBodies(double deltaT);
+
+	/**
+		This method finds all the contact points between the two bodies. b can be a locked body, but a can not.
+	*/
+	void collidePair(RigidBody* a, RigidBody* b, double deltaT);
+
+	/**
+		This method solves the contacts and the joint limits with reduced coordinates, and adds the forces they need to the force accumulators. The
+		accelerations of the figures must be up to date, since the velocities at the end of the step and the impulse responses are computed from them.
+	*/
+	void solveReducedConstraints(double deltaT);
+
+	/**
+		This method finds the joint limits of the figures that are about to be violated, and sets up their solver data. With reduced coordinates only.
+	*/
+	void collectJointLimits(double deltaT);
+
+	/**
+		This method adds a joint limit for the angle (whose rate of change is the relative angular velocity along axis) of the link of the figure,
+		if it is about to leave [minAngle, maxAngle]. With reduced coordinates only.
+	*/
+	void addJointLimit(int figure, int link, const Vector3d& axis, double angle, double minAngle, double maxAngle, double deltaT);
+
+	/**
+		This method does one sequential impulse pass over the joint limit passed in as a parameter. With reduced coordinates only.
+	*/
+	void solveJointLimit(NativeJointLimit* l);
+
+	/**
+		This method adds the velocity changes of the last impulse response of the figure to the solver velocities. With reduced coordinates only.
+	*/
+	void addVelocityChanges(ABAFigure* af);
+
+	/**
+		This method applies the impulse that is passed in to rb at the point that is r away from its center of mass, and updates the solver velocities
+		of all the bodies that it moves. With reduced coordinates only.
+	*/
+	void applyReducedImpulse(RigidBody* rb, const Vector3d& r, const Vector3d& impulse);
+
+	/**
+		This method returns the change in the velocity of the point that is r away from the center of mass of rb, when the impulse u is applied
+		there. With reduced coordinates only.
+	*/
+	Vector3d getReducedResponse(RigidBody* rb, const Vector3d& r, const Vector3d& u);
+
+	/**
+		This method returns the velocity of the contact point on rb1, relative to the one on rb2. With reduced coordinates these are the solver velocities.
+	*/
+	Vector3d getRelativeVelocity(NativeContact* c);
+
+	/**
+		This method integrates the state of a rigid body that is not part of an articulated figure, using the forces in its accumulator.
+	*/
+	void integrateFreeBody(RigidBody* rb, double deltaT);
+
+	/**
+		This method is used to integrate the forward simulation in time, with the articulated figures in reduced coordinates.
+	*/
+	void advanceInTimeReduced(double deltaT);
+
+	/**
+		This method does one sequential impulse pass over the contact passed in as a parameter.
+	*/
+	void solveContact(NativeContact* c);
+
+	/**
+		This method applies the impulse that is passed in to rb1 at the contact point, and the opposite impulse to rb2.
+	*/
+	void applyContactImpulse(NativeContact* c, const Vector3d& impulse);
+
+	/**
+		This method returns 1/(u' * K * u), where K is the collision matrix of the contact. With reduced coordinates K is that of the figures
+		the bodies are part of, so the articulated inertias of the figures must be up to date.
+	*/
+	double getEffectiveMass(NativeContact* c, const Vector3d& u);
+
+	// Destroy the world, it becomes unusable, but everything is clean
+	virtual void destroyWorld();
+
+public:
+	/**
+		constructor. If reducedCoordinates is true, the articulated figures are simulated in reduced coordinates.
+	*/
+	NativeWorld(bool reducedCoordinates = false, bool deterministic = false);
+
+	/**
+		destructor
+	*/
+	virtual ~NativeWorld(void);
+
+	// Destroy all the objects, but the world is still usable
+	virtual void destroyAllObjects();
+
+	/**
+		This method reads a list of rigid bodies from the specified file.
+	*/
+	virtual void loadRBsFromFile(char* fName);
+
+	/**
+		This method adds one rigid body (articulated or not).
+	*/
+	virtual void addRigidBody( RigidBody* rigidBody_disown );
+
+	/**
+		This method adds one articulated figure.
+	*/
+	virtual void addArticulatedFigure( ArticulatedFigure* articulatedFigure_disown );
+
+	/**
+		This method is used to integrate the forward simulation in time.
+	*/
+	virtual void advanceInTime(double deltaT);
+
+	/**
+		This method saves the state of the world in the snapshot. The impulses that warm start the joints are saved as well, since they carry
+		over from one step to the next.
+	*/
+	virtual void saveSnapshot(WorldSnapshot* snapshot);
+
+	/**
+		This method puts the world back in the state that was saved in the snapshot.
+	*/
+	virtual bool restoreSnapshot(const WorldSnapshot& snapshot);
+
+	/**
+		This method is for performance analysis
+	*/
+	virtual void printAllCOMPosition();
+
+	/**
+		this method applies a force to a rigid body, at the specified point. The point is specified in local coordinates,
+		and the force is also specified in local coordinates.
+	*/
+	virtual void applyRelForceTo(RigidBody* b, const Vector3d& f, const Point3d& p);
+
+	/**
+		this method applies a force to a rigid body, at the specified point. The point is specified in local coordinates,
+		and the force is specified in world coordinates.
+	*/
+	virtual void applyForceTo(RigidBody* b, const Vector3d& f, const Point3d& p);
+
+	/**
+		this method applies a torque to a rigid body. The torque is specified in world coordinates.
+	*/
+	virtual void applyTorqueTo(RigidBody* b, const Vector3d& t);
+
+	/**
+		sets the number of sequential impulse passes done every step
+	*/
+	inline void setSolverIterations(int n){
+		solverIterations = (n > 0) ? n : 1;
+	}
+};
@@ -8,17 +8,34 @@
 #include "UniversalJoint.h"
 #include "BallInSocketJoint.h"
 #include "PhysicsGlobals.h"
+#include <Profiler.h>
 #include <cmath>
+#include <mutex>
 
 using namespace std;
 
 static PxDefaultErrorCallback gDefaultErrorCallback;
 static PxDefaultAllocator gDefaultAllocatorCallback;
 
+//this structure holds a PhysX height field that was made for a terrain, and the height of one of its units
+typedef struct {
+	HeightFieldData* field;
+	PxHeightField* heightField;
+	PxReal heightScale;
+} SharedHeightField;
+
+//there is only one PhysX SDK per process, so the height field of a terrain is made once and shared by the scenes of all the worlds.
+//The height fields belong to the SDK, so they are released when the last world lets go of it
+static DynamicArray<SharedHeightField> sharedHeightFields;
+//the number of worlds that hold a reference to the PhysX SDK
+static int sdkUserCount = 0;
+//the worlds of the parallel evaluations may be created and destroyed at the same time
+static mutex sdkLock;
+
 /**
-	Default constructor
+	constructor. A deterministic world runs the steps of its scene on one thread and sorts its contact points.
 */
-PhysX3World::PhysX3World() : World(){
+PhysX3World::PhysX3World(bool deterministic) : World(deterministic){
 	setupWorld();
 }
 
@@ -26,6 +43,7 @@ PhysX3World::PhysX3World() : World(){
 	destructor
 */
 PhysX3World::~PhysX3World(void){
+	destroyWorld();
 }
 
 void PhysX3World::destroyWorld() {
@@ -40,18 +58,36 @@ void PhysX3World::destroyWorld() {
 //          physxToRbs[i].rb = NULL;
 //     }
 	physxToRbs.clear();
+	stateBuffer.positions.clear();
+	stateBuffer.orientations.clear();
+	stateBuffer.velocities.clear();
+	stateBuffer.angularVelocities.clear();
+	stateBuffer.valid.clear();
 	//destroy the PhysX physical world, simulation space and joint group
 	if(gPhysicsSDK != NULL)
 	{
 		if(gScene != NULL) gScene->release();
 		gScene = NULL;
+		//the scene kept a pointer to the contact callback, so it can only go once the scene is released
+		delete contactCallback;
+		contactCallback = NULL;
         if(gCooking != NULL) gCooking->release();
         gCooking = NULL;
         if(defaultMaterial != NULL)defaultMaterial->release();
         defaultMaterial = NULL;
         if(gCudaContextManager != NULL)gCudaContextManager->release();
         gCudaContextManager = NULL;
+        if(gCpuDispatcher != NULL)gCpuDispatcher->release();
+        gCpuDispatcher = NULL;
         spaceID = NULL;
+		lock_guard<mutex> lock(sdkLock);
+		sdkUserCount--;
+		if (sdkUserCount == 0){
+			//the scenes of all the worlds are gone, so nothing uses the height fields anymore
+			for (uint i=0;i<sharedHeightFields.size();i++)
+				sharedHeightFields[i].heightField->release();
+			sharedHeightFields.clear();
+		}
         gPhysicsSDK->release();
         gPhysicsSDK = NULL;
 	}
@@ -66,6 +102,7 @@ void PhysX3World::destroyWorld() {
 	contact points.
 */
 void PhysX3World::collisionsPostProcessing(PxContactPair & pair, PxU32 events){
+	PROFILE_SCOPE(PROFILE_CONTACT_PROCESSING);
 	// Iterate through contact points
 	PxContactStreamIterator i(pair.stream);
 	//user can call getNumPairs() here
@@ -109,7 +146,7 @@ void PhysX3World::collisionsPostProcessing(PxContactPair & pair, PxU32 events){
 			{
 				//user can also call getPoint() and getSeparation() here
 				const PxVec3& contactPoint = i.getPoint();
-				if (jointFeedbackCount >= MAX_CONTACT_FEEDBACK){}
+				if (jointFeedbackCount >= getMaxContactFeedback()){}
 					//tprintf("Warning: too many contacts are established. Some of them will not be reported.\n");
 				else{
 					if (contactPoints.size() != jointFeedbackCount){
@@ -144,13 +181,15 @@ class MyCallback : public PxSimulationEventCallback
 	public:
 	PhysX3World *theworld;
 
+	MyCallback(PhysX3World* world) : theworld(world) {}
+
 	virtual void onContact(PxContactPair& pair, PxU32 events)
 	{
 		if(!theworld->testmode)
 			theworld->collisionsPostProcessing(pair,events);
 	}
 
-}gMyCallback;
+};
 
 PxFilterFlags myFilterShader(
         PxFilterObjectAttributes attributes0, PxFilterData filterData0,
@@ -196,13 +235,32 @@ void PhysX3World::setupFiltering(PxRigidActor* actor, PxU32 filterGroup, PxU32 f
 }
 
 
+/**
+	this method returns the collision group of the rigid body that is passed in. Bodies that share a group never collide with each other
+*/
+PxU32 PhysX3World::getFilterGroup(RigidBody* rb){
+	if (rb->isLocked())
+		return PHYSX3_GROUP_STATIC;
+	if (rb->isArticulated() && ((ArticulatedRigidBody*)rb)->getAFParent() != NULL){
+		for (uint i=0;i<AFs.size();i++)
+			if (AFs[i] == ((ArticulatedRigidBody*)rb)->getAFParent())
+				return 1 << (PHYSX3_FIRST_FIGURE_GROUP + i % PHYSX3_FIGURE_GROUP_COUNT);
+	}
+	return PHYSX3_GROUP_FREE;
+}
+
 void PhysX3World::setupWorld() 
 {
 	int maxCont = 4;
 
 	//desc.flags &= ~PX_SDKF_NO_HARDWARE;
 	bool recordMemoryAllocations = true;
-	gPhysicsSDK = PxCreatePhysics(PX_PHYSICS_VERSION, gDefaultAllocatorCallback, gDefaultErrorCallback, PxTolerancesScale(), recordMemoryAllocations);
+	{
+		//every call gives the same SDK, and adds one to its reference count
+		lock_guard<mutex> lock(sdkLock);
+		gPhysicsSDK = PxCreatePhysics(PX_PHYSICS_VERSION, gDefaultAllocatorCallback, gDefaultErrorCallback, PxTolerancesScale(), recordMemoryAllocations);
+		sdkUserCount++;
+	}
 
 	if(!PxInitExtensions(*gPhysicsSDK))
 		printf("PxInitExtensions failed!");
@@ -226,7 +284,9 @@ void PhysX3World::setupWorld()
 	sceneDesc.gravity = PxVec3(gravity.x, gravity.y, gravity.z);
 	//sceneDesc.gravity = PxVec3(0, 0, 0);
 
-	sceneDesc.simulationEventCallback = &gMyCallback;
+	contactCallback = new MyCallback(this);
+	sceneDesc.simulationEventCallback = contactCallback;
+	gCpuDispatcher = NULL;
 	if(!sceneDesc.cpuDispatcher)
 	{
 		PxU32 gNbThreads;
@@ -235,9 +295,12 @@ void PhysX3World::setupWorld()
 #elif defined(PX_X360)
 		gNbThreads = 2;
 #else
-		gNbThreads = 3;
+		gNbThreads = PhysicsGlobals::physXThreadCount;
 #endif
-		physx::pxtask::CpuDispatcher* gCpuDispatcher = PxDefaultCpuDispatcherCreate(gNbThreads);
+		//in deterministic mode all the work of a step is done by one worker thread, so it is always done in the same order
+		if (deterministic)
+			gNbThreads = 1;
+		gCpuDispatcher = PxDefaultCpuDispatcherCreate(gNbThreads);
         if(!gCpuDispatcher)
 			printf("PxDefaultCpuDispatcherCreate failed!\n");
         sceneDesc.cpuDispatcher = gCpuDispatcher;
@@ -245,13 +308,16 @@ void PhysX3World::setupWorld()
 	if(!sceneDesc.filterShader)
         sceneDesc.filterShader  = myFilterShader;
 	//sceneDesc.flags |= PxSceneFlag::eENABLE_KINEMATIC_STATIC_PAIRS;
+	//have PhysX report the poses of the bodies that moved during a step in one list, so the others don't need to be read back
+	sceneDesc.flags |= PxSceneFlag::eENABLE_ACTIVETRANSFORMS;
 
+	gCudaContextManager = NULL;
 #ifdef PX_WINDOWS
 	pxtask::CudaContextManagerDesc cudaContextManagerDesc;
 	gCudaContextManager = pxtask::createCudaContextManager(cudaContextManagerDesc, &(gPhysicsSDK->getProfileZoneManager()));
 #endif
 #ifdef PX_WINDOWS
-	if(!sceneDesc.gpuDispatcher && gCudaContextManager)
+	if(!sceneDesc.gpuDispatcher && gCudaContextManager && !deterministic)
 	{
 		sceneDesc.gpuDispatcher = gCudaContextManager->getGpuDispatcher();
 	}
@@ -272,8 +338,7 @@ void PhysX3World::setupWorld()
 	//gScene->setVisualizationParameter(PxVisualizationParameter::eCONTACT_FORCE, 1.0f);
 	//gScene->setVisualizationParameter(PxVisualizationParameter::eCONTACT_POINT, 1.0f);
 	//gScene->setVisualizationParameter(PxVisualizationParameter::eCONTACT_NORMAL, 1.0f);
-	gMyCallback.theworld = this;
-	gScene->setSimulationEventCallback(&gMyCallback);
+	gScene->setSimulationEventCallback(contactCallback);
 	
 	// Set default material
 	defaultMaterial = gPhysicsSDK->createMaterial(1.0f, 1.0f, 0.0f);
@@ -298,6 +363,37 @@ void PhysX3World::destroyAllObjects() {
 
 
 
+/**
+	this method makes sure that the state buffer has one entry for every rigid body
+*/
+void PhysX3World::resizeStateBuffer(){
+	uint n = physxToRbs.size();
+	if (stateBuffer.valid.size() == n)
+		return;
+	stateBuffer.positions.resize(n);
+	stateBuffer.orientations.resize(n);
+	stateBuffer.velocities.resize(n);
+	stateBuffer.angularVelocities.resize(n);
+	stateBuffer.valid.resize(n, false);
+}
+
+/**
+	this method returns true if the state of the ith rigid body is the same as the one that was last exchanged with PhysX
+*/
+bool PhysX3World::isStateBufferCurrent(int i){
+	if (!stateBuffer.valid[i])
+		return false;
+	const RBState& s = physxToRbs[i].rb->state;
+	const Point3d& p = stateBuffer.positions[i];
+	const Quaternion& q = stateBuffer.orientations[i];
+	const Vector3d& v = stateBuffer.velocities[i];
+	const Vector3d& w = stateBuffer.angularVelocities[i];
+	return s.position.x == p.x && s.position.y == p.y && s.position.z == p.z &&
+		s.orientation.s == q.s && s.orientation.v.x == q.v.x && s.orientation.v.y == q.v.y && s.orientation.v.z == q.v.z &&
+		s.velocity.x == v.x && s.velocity.y == v.y && s.velocity.z == v.z &&
+		s.angularVelocity.x == w.x && s.angularVelocity.y == w.y && s.angularVelocity.z == w.z;
+}
+
 /**
 	this method is used to copy the state of the ith rigid body to its PhysX counterpart.
 */
@@ -305,56 +401,57 @@ void PhysX3World::setPhysXStateFromRB(int i){
 	if (i<0 || (uint)i>=physxToRbs.size())
 		return;
 
-	//if it is a locked object, we update its CDPS
-	if (physxToRbs[i].rb->isLocked() == true) {
+	resizeStateBuffer();
+	RigidBody* rb = physxToRbs[i].rb;
+	stateBuffer.positions[i] = rb->state.position;
+	stateBuffer.orientations[i] = rb->state.orientation;
+	stateBuffer.velocities[i] = rb->state.velocity;
+	stateBuffer.angularVelocities[i] = rb->state.angularVelocity;
+	stateBuffer.valid[i] = true;
 
-		for (uint j=0;j<physxToRbs[i].collisionVolumes.size();j++){
-			Point3d pos = physxToRbs[i].rb->getLocalCoordinates(physxToRbs[i].rb->state.position);
-			PxQuat orient(physxToRbs[i].rb->state.orientation.v.x, physxToRbs[i].rb->state.orientation.v.y,
-				physxToRbs[i].rb->state.orientation.v.z, physxToRbs[i].rb->state.orientation.s);
-			PxTransform pose;
-			pose.q = orient;
-			pose.p = PxVec3(pos.x, pos.y, pos.z);
-			PxShape * t = physxToRbs[i].collisionVolumes[j];
-			t->setLocalPose(pose);
-		}
+	PxTransform pose;
+	pose.q = PxQuat(rb->state.orientation.v.x, rb->state.orientation.v.y, rb->state.orientation.v.z, rb->state.orientation.s);
+	pose.p = PxVec3(rb->state.position.x, rb->state.position.y, rb->state.position.z);
+
+	//if it is a locked object, its shapes simply move with its static actor
+	if (rb->isLocked() == true) {
+		if (physxToRbs[i].staticId != NULL)
+			physxToRbs[i].staticId->setGlobalPose(pose);
 		return;
 	}
-	
-	PxTransform pose;
-	pose.q = PxQuat(physxToRbs[i].rb->state.orientation.v.x,physxToRbs[i].rb->state.orientation.v.y,physxToRbs[i].rb->state.orientation.v.z,physxToRbs[i].rb->state.orientation.s);
-	pose.p = PxVec3(physxToRbs[i].rb->state.position.x, physxToRbs[i].rb->state.position.y, physxToRbs[i].rb->state.position.z);
+
 	physxToRbs[i].id->setGlobalPose(pose);
-	physxToRbs[i].id->setLinearVelocity(PxVec3(physxToRbs[i].rb->state.velocity.x, physxToRbs[i].rb->state.velocity.y, physxToRbs[i].rb->state.velocity.z));
-	physxToRbs[i].id->setAngularVelocity(PxVec3(physxToRbs[i].rb->state.angularVelocity.x, physxToRbs[i].rb->state.angularVelocity.y, physxToRbs[i].rb->state.angularVelocity.z));
+	physxToRbs[i].id->setLinearVelocity(PxVec3(rb->state.velocity.x, rb->state.velocity.y, rb->state.velocity.z));
+	physxToRbs[i].id->setAngularVelocity(PxVec3(rb->state.angularVelocity.x, rb->state.angularVelocity.y, rb->state.angularVelocity.z));
 }
 
 /**
 	this method is used to copy the state of the ith rigid body, from the PhysX object to its rigid body counterpart 
 */
 void PhysX3World::setRBStateFromPhysX(int i){
-	PxVec3 tempData;
-
 	//if it is a locked object, we won't do anything about it
 	if (physxToRbs[i].rb->isLocked() == true){
 		//printf("rb locked\n");
 		return;
 	}
 
+	setRBStateFromPhysX(i, physxToRbs[i].id->getGlobalPose(), physxToRbs[i].id->getLinearVelocity(), physxToRbs[i].id->getAngularVelocity());
+}
+
+/**
+	this method is used to copy the pose and the velocities that PhysX computed for the ith rigid body to the state buffer and to the rigid body
+*/
+void PhysX3World::setRBStateFromPhysX(int i, const PxTransform& pose, const PxVec3& velocity, const PxVec3& angularVelocity){
+	PxVec3 p0 = pose.p;
+	PxQuat quat = pose.q;
+	PxVec3 rot = angularVelocity;
+
 	//if the objects is supposed to be planar, make sure we don't let drift accumulate
 	if (physxToRbs[i].rb->props.isPlanar){
 		//printf("rb planar\n");
-		PxVec3 rot = physxToRbs[i].id->getAngularVelocity();
-		PxQuat quat_ptr;
-		PxQuat quat;
-		PxReal quat_len;
-		quat_ptr = physxToRbs[i].id->getGlobalPose().q;
-		PxVec3 p0 = physxToRbs[i].id->getGlobalPose().p;
-		quat.w = quat_ptr.w;
-		quat.x = quat_ptr.x;
 		quat.y = 0; 
 		quat.z = 0; 
-		quat_len = sqrt( quat.w * quat.w + quat.x * quat.x );
+		PxReal quat_len = sqrt( quat.w * quat.w + quat.x * quat.x );
 		quat.w /= quat_len;
 		quat.x /= quat_len;
 		physxToRbs[i].id->setGlobalPose(PxTransform(p0, quat));
@@ -362,35 +459,28 @@ void PhysX3World::setRBStateFromPhysX(int i){
 		rot.z = 0;
 		physxToRbs[i].id->setAngularVelocity(rot);
 	}
-	//printf("before x : %f\n",physxToRbs[i].rb->state.position.x);
-	//printf("before y : %f\n",physxToRbs[i].rb->state.position.y);
-	//printf("before z : %f\n",physxToRbs[i].rb->state.position.z);
-
-	tempData = physxToRbs[i].id->getGlobalPose().p;
-	physxToRbs[i].rb->state.position.x = tempData.x;
-	physxToRbs[i].rb->state.position.y = tempData.y;
-    physxToRbs[i].rb->state.position.z = tempData.z;
 
-	//printf("after x : %f\n",physxToRbs[i].rb->state.position.x);
-	//printf("after y : %f\n",physxToRbs[i].rb->state.position.y);
-	//printf("after z : %f\n",physxToRbs[i].rb->state.position.z);
-
-	PxQuat orientation;
-	orientation = physxToRbs[i].id->getGlobalPose().q;
-	physxToRbs[i].rb->state.orientation.s = orientation.w;
-	physxToRbs[i].rb->state.orientation.v.x = orientation.x;
-	physxToRbs[i].rb->state.orientation.v.y = orientation.y;
-	physxToRbs[i].rb->state.orientation.v.z = orientation.z;
-
-	tempData = physxToRbs[i].id->getLinearVelocity();
-	physxToRbs[i].rb->state.velocity.x = tempData.x;
-	physxToRbs[i].rb->state.velocity.y = tempData.y;
-	physxToRbs[i].rb->state.velocity.z = tempData.z;
+	resizeStateBuffer();
+	stateBuffer.positions[i] = Point3d(p0.x, p0.y, p0.z);
+	stateBuffer.orientations[i] = Quaternion(quat.w, Vector3d(quat.x, quat.y, quat.z));
+	stateBuffer.velocities[i] = Vector3d(velocity.x, velocity.y, velocity.z);
+	stateBuffer.angularVelocities[i] = Vector3d(rot.x, rot.y, rot.z);
+	stateBuffer.valid[i] = true;
+
+	RBState& state = physxToRbs[i].rb->state;
+	state.position = stateBuffer.positions[i];
+	state.orientation = stateBuffer.orientations[i];
+	state.velocity = stateBuffer.velocities[i];
+	state.angularVelocity = stateBuffer.angularVelocities[i];
+}
 
-	tempData = physxToRbs[i].id->getAngularVelocity();
-	physxToRbs[i].rb->state.angularVelocity.x = tempData.x;
-	physxToRbs[i].rb->state.angularVelocity.y = tempData.y;
-	physxToRbs[i].rb->state.angularVelocity.z = tempData.z;
+/**
+	returns the PhysX actor of the ith rigid body: its dynamic actor, or its static actor if the body is locked
+*/
+PxRigidActor* PhysX3World::getPhysXActor(int i){
+	if (physxToRbs[i].id != NULL)
+		return physxToRbs[i].id;
+	return physxToRbs[i].staticId;
 }
 
 /**
@@ -399,8 +489,8 @@ void PhysX3World::setRBStateFromPhysX(int i){
 void PhysX3World::setupPhysXFixedJoint(StiffJoint* hj){
 	//printf("setupPhysXFixedJoint\n");
 
-	PxRigidBody* actor1 = physxToRbs[(int)(hj->parent->id)].id;
-	PxRigidBody* actor2 = physxToRbs[(int)(hj->child->id)].id;
+	PxRigidActor* actor1 = getPhysXActor(hj->parent->id);
+	PxRigidActor* actor2 = getPhysXActor(hj->child->id);
 	Point3d p = hj->pJPos;
 	Point3d c = hj->cJPos;
 	PxFixedJoint* fixedJoint=PxFixedJointCreate(*gPhysicsSDK, actor1, PxTransform(PxVec3(p.x, p.y, p.z)),
@@ -416,11 +506,12 @@ void PhysX3World::setupPhysXFixedJoint(StiffJoint* hj){
 void PhysX3World::setupPhysXHingeJoint(HingeJoint* hj){
 	//printf("setupPhysXHingeJoint\n");
 	
-	PxRevoluteJoint* revoluteJoint = PxRevoluteJointCreate(*gPhysicsSDK, physxToRbs[(int)(hj->parent->id)].id, PxTransform(PxVec3(hj->pJPos.x, hj->pJPos.y, hj->pJPos.z)),
-		physxToRbs[(int)(hj->child->id)].id, PxTransform(PxVec3(hj->cJPos.x, hj->cJPos.y, hj->cJPos.z)));
+	PxRevoluteJoint* revoluteJoint = PxRevoluteJointCreate(*gPhysicsSDK, getPhysXActor(hj->parent->id), PxTransform(PxVec3(hj->pJPos.x, hj->pJPos.y, hj->pJPos.z)),
+		getPhysXActor(hj->child->id), PxTransform(PxVec3(hj->cJPos.x, hj->cJPos.y, hj->cJPos.z)));
 	Point3d p = hj->child->getWorldCoordinates(hj->cJPos);
 	Vector3d a = hj->parent->getWorldCoordinates(hj->a);
-	PxSetJointGlobalFrame(*revoluteJoint, &PxVec3(p.x, p.y, p.z), &PxVec3(a.x, a.y, a.z));
+	PxVec3 anchor(p.x, p.y, p.z), axis(a.x, a.y, a.z);
+	PxSetJointGlobalFrame(*revoluteJoint, &anchor, &axis);
 	//revoluteJoint->setConstraintFlag(PxConstraintFlag::eCOLLISION_ENABLED, true);
 
 	if(hj->useJointLimits == true && !testmode){
@@ -451,8 +542,8 @@ void PhysX3World::setupPhysXUniversalJoint(UniversalJoint* uj){
 		pose2.q = PxQuat(rotAngle, PxVec3(q.x, q.y, q.z));
 	}
 
-	PxD6Joint* d6Joint = PxD6JointCreate(*gPhysicsSDK, physxToRbs[(int)(uj->parent->id)].id, pose1,
-		physxToRbs[(int)(uj->child->id)].id, pose2);
+	PxD6Joint* d6Joint = PxD6JointCreate(*gPhysicsSDK, getPhysXActor(uj->parent->id), pose1,
+		getPhysXActor(uj->child->id), pose2);
 	//Point3d a = uj->parent->getWorldCoordinates(uj->pJPos);
 	//Vector3d b = uj->child->getWorldCoordinates(uj->b);
 	//PxSetJointGlobalFrame(*d6Joint, &PxVec3(a.x, a.y, a.z), &PxVec3(b.x, b.y, b.z));
@@ -490,8 +581,8 @@ void PhysX3World::setupPhysXBallAndSocketJoint(BallInSocketJoint* basj){
 		pose1.q = PxQuat(rotAngle, PxVec3(q.x, q.y, q.z));
 		pose2.q = PxQuat(rotAngle, PxVec3(q.x, q.y, q.z));
 	}
-	PxD6Joint* d6Joint = PxD6JointCreate(*gPhysicsSDK, physxToRbs[(int)(basj->parent->id)].id, pose1,
-		physxToRbs[(int)(basj->child->id)].id, pose2);
+	PxD6Joint* d6Joint = PxD6JointCreate(*gPhysicsSDK, getPhysXActor(basj->parent->id), pose1,
+		getPhysXActor(basj->child->id), pose2);
 
 	d6Joint->setMotion(PxD6Axis::eX, PxD6Motion::eLOCKED);
 	d6Joint->setMotion(PxD6Axis::eY, PxD6Motion::eLOCKED);
@@ -504,7 +595,8 @@ void PhysX3World::setupPhysXBallAndSocketJoint(BallInSocketJoint* basj){
 		Point3d a = basj->child->getWorldCoordinates(basj->cJPos);
 		Vector3d b = basj->child->getWorldCoordinates(basj->twistAxis);
 		if(basj->useJointLimits == true && !testmode){
-			PxSetJointGlobalFrame(*d6Joint, &PxVec3(a.x, a.y, a.z), &PxVec3(b.x, b.y, b.z));
+			PxVec3 anchor(a.x, a.y, a.z), axis(b.x, b.y, b.z);
+			PxSetJointGlobalFrame(*d6Joint, &anchor, &axis);
 		}
 		d6Joint->setMotion(PxD6Axis::eTWIST, PxD6Motion::eLIMITED);
 		if(basj->maxTwistAngle > 2 * 22 / 7){
@@ -523,9 +615,18 @@ void PhysX3World::setupPhysXBallAndSocketJoint(BallInSocketJoint* basj){
 */
 void PhysX3World::createPhysXCollisionPrimitives(RigidBody* body, int index){
 	//printf("createPhysXCollisionPrimitives\n");
-	//now we'll set up the body's collision detection primitives
-	PxRigidDynamic* actor = gPhysicsSDK->createRigidDynamic(PxTransform(PxVec3(0,0,0)));
-	PxRigidStatic* staticActor = gPhysicsSDK->createRigidStatic(PxTransform(PxVec3(0,0,0)));
+	//a locked body only needs one static actor, which holds all of its shapes, and the other bodies only need a dynamic one
+	PxTransform bodyPose;
+	bodyPose.q = PxQuat(body->state.orientation.v.x, body->state.orientation.v.y, body->state.orientation.v.z, body->state.orientation.s);
+	bodyPose.p = PxVec3(body->state.position.x, body->state.position.y, body->state.position.z);
+	PxRigidDynamic* actor = NULL;
+	PxRigidStatic* staticActor = NULL;
+	PxRigidActor* shapeOwner;
+	if (body->isLocked() == true)
+		shapeOwner = staticActor = gPhysicsSDK->createRigidStatic(bodyPose);
+	else
+		shapeOwner = actor = gPhysicsSDK->createRigidDynamic(PxTransform(PxVec3(0,0,0)));
+
 	for (uint j=0;j<body->cdps.size();j++){
 		int cdpType = body->cdps[j]->getType();
 
@@ -534,7 +635,7 @@ void PhysX3World::createPhysXCollisionPrimitives(RigidBody* body, int index){
 			SphereCDP* s = (SphereCDP*)body->cdps[j];
 			Point3d c = s->getCenter();
 			PxReal radius = s->getRadius();
-			PxShape* aSphereShape = actor->createShape(PxSphereGeometry(radius), *defaultMaterial, PxTransform(PxVec3(c.x,c.y,c.z)));
+			PxShape* aSphereShape = shapeOwner->createShape(PxSphereGeometry(radius), *defaultMaterial, PxTransform(PxVec3(c.x,c.y,c.z)));
 			aSphereShape->userData = body;
 		} else if(cdpType == CAPSULE_CDP){
 			//printf("capsule\n");
@@ -551,47 +652,70 @@ void PhysX3World::createPhysXCollisionPrimitives(RigidBody* body, int index){
 			double rotAngle = defA.angleWith(ab);
 			Quaternion relOrientation = Quaternion::getRotationQuaternion(rotAngle, axis);
 			pose.q = PxQuat(relOrientation.v.x,relOrientation.v.y,relOrientation.v.z,relOrientation.s);
-			PxShape* aCapsuleShape = actor->createShape(PxCapsuleGeometry(c->getRadius(), ab.length()/2), *defaultMaterial, pose);
+			PxShape* aCapsuleShape = shapeOwner->createShape(PxCapsuleGeometry(c->getRadius(), ab.length()/2), *defaultMaterial, pose);
 			aCapsuleShape->userData = body;
 		} else if(cdpType == BOX_CDP){
 			//printf("box\n");
 			BoxCDP* b = (BoxCDP*)body->cdps[j];
 			Point3d c = b->getCenter();
-			PxShape* aBoxShape = actor->createShape(PxBoxGeometry(b->getXLen() / 2, b->getYLen() / 2, b->getZLen() / 2), *defaultMaterial, PxTransform(PxVec3(c.x, c.y, c.z)));
+			PxShape* aBoxShape = shapeOwner->createShape(PxBoxGeometry(b->getXLen() / 2, b->getYLen() / 2, b->getZLen() / 2), *defaultMaterial, PxTransform(PxVec3(c.x, c.y, c.z)));
 			aBoxShape->userData = body;
 		} else if(cdpType == PLANE_CDP){
 			//printf("plane\n");
+			if (staticActor == NULL){
+				printf("Warning: only the locked bodies can have planes - the plane of %s is ignored\n", body->getName());
+				continue;
+			}
 			PlaneCDP* p = (PlaneCDP*)body->cdps[j];
+			//PhysX planes are the x=0 plane of their shape, so the x axis is rotated onto the normal of the plane
 			PxTransform pose;
-			Vector3d n = body->getWorldCoordinates(p->getNormal());
-			Vector3d o = Vector3d(body->getWorldCoordinates(p->getOrigin()));
+			Vector3d n = p->getNormal();
+			Point3d o = p->getOrigin();
 			Vector3d defA(1,0,0);
-			Vector3d q = defA.crossProductWith(n);
-			double rotAngle = defA.angleWith(n);
+			Vector3d axis = defA.crossProductWith(n);
+			if (axis.length() < 1e-10)
+				axis = Vector3d(0,1,0);
+			axis.toUnit();
+			Quaternion relOrientation = Quaternion::getRotationQuaternion(defA.angleWith(n), axis);
 			pose.p = PxVec3(o.x, o.y, o.z);
-			pose.q = PxQuat(rotAngle, PxVec3(q.x, q.y, q.z));
-			staticActor = gPhysicsSDK->createRigidStatic(pose);
-			PxShape* aShape = staticActor->createShape(PxPlaneGeometry(), *defaultMaterial);
+			pose.q = PxQuat(relOrientation.v.x,relOrientation.v.y,relOrientation.v.z,relOrientation.s);
+			PxShape* aShape = staticActor->createShape(PxPlaneGeometry(), *defaultMaterial, pose);
+			aShape->userData = body;
+		} else if(cdpType == HEIGHT_FIELD_CDP){
+			//printf("height field\n");
+			if (staticActor == NULL){
+				printf("Warning: only the locked bodies can have height fields - the height field of %s is ignored\n", body->getName());
+				continue;
+			}
+			HeightFieldCDP* h = (HeightFieldCDP*)body->cdps[j];
+			PxReal heightScale;
+			PxHeightField* heightField = getPhysXHeightField(h->getHeightField(), &heightScale);
+			if (heightField == NULL)
+				continue;
+			Point3d o = h->getOrigin();
+			PxHeightFieldGeometry geometry(heightField, PxMeshGeometryFlags(), heightScale, (PxReal)h->getHeightField()->getRowSpacing(), (PxReal)h->getHeightField()->getColumnSpacing());
+			PxShape* aShape = staticActor->createShape(geometry, *defaultMaterial, PxTransform(PxVec3(o.x, o.y, o.z)));
 			aShape->userData = body;
-			physxToRbs[index].collisionVolumes.push_back(aShape);
 		} else {
 			//printf("error\n");
-			return;
+			printf("Warning: unknown collision primitive %s - it is ignored\n", body->cdps[j]->typeName());
 		}
-
-		PxRigidBodyExt::updateMassAndInertia(*actor, 1);
-
 	}
 
 	if (body->isLocked() == true)
     {
-		setupFiltering(staticActor, 1, 2);
+		setupFiltering(staticActor, getFilterGroup(body), ~getFilterGroup(body));
 		gScene->addActor(*staticActor);
+		physxToRbs[index].staticId = staticActor;
 	} else {
+		//this gives the mass frame of the actor, from all of its shapes at once. The mass and the moments of inertia are then set to the
+		//ones of the rigid body
+		if (actor->getNbShapes() > 0)
+			PxRigidBodyExt::updateMassAndInertia(*actor, 1);
 		actor->setMass(physxToRbs[index].rb->getMass());
 		Vector3d principalMoments = physxToRbs[index].rb->getPMI();
 		actor->setMassSpaceInertiaTensor(PxVec3(principalMoments.x,principalMoments.y,principalMoments.z));
-		setupFiltering(actor, 2, 1);
+		setupFiltering(actor, getFilterGroup(body), ~getFilterGroup(body));
 		gScene->addActor(*actor);
 		actor->setContactReportThreshold(100);
 		actor->setContactReportThreshold(0);
@@ -602,6 +726,56 @@ void PhysX3World::createPhysXCollisionPrimitives(RigidBody* body, int index){
 	}
 }
 
+/**
+	this method returns the PhysX height field for the terrain passed in as a parameter. It is only made the first time it is asked
+	for, and then shared by the scenes of all the worlds. The heights are stored as 16 bit integers, so heightScale is set to the
+	height of one unit.
+*/
+PxHeightField* PhysX3World::getPhysXHeightField(HeightFieldData* field, PxReal* heightScale){
+	lock_guard<mutex> lock(sdkLock);
+	for (uint i=0;i<sharedHeightFields.size();i++)
+		if (sharedHeightFields[i].field == field){
+			*heightScale = sharedHeightFields[i].heightScale;
+			return sharedHeightFields[i].heightField;
+		}
+
+	int sampleCount = field->getRowCount() * field->getColumnCount();
+	double maxHeight = 0;
+	for (int i=0;i<field->getRowCount();i++)
+		for (int j=0;j<field->getColumnCount();j++)
+			maxHeight = max(maxHeight, fabs(field->getHeight(i, j)));
+	*heightScale = (maxHeight > 0) ? (PxReal)(maxHeight / 32767) : 1;
+
+	//every cell is split along the diagonal that starts at its first sample, the same way HeightFieldCDP splits them
+	DynamicArray<PxHeightFieldSample> samples(sampleCount);
+	for (int i=0;i<field->getRowCount();i++)
+		for (int j=0;j<field->getColumnCount();j++){
+			PxHeightFieldSample& s = samples[i * field->getColumnCount() + j];
+			s.height = (PxI16)floor(field->getHeight(i, j) / *heightScale + 0.5);
+			s.materialIndex0 = PxBitAndByte(0, true);
+			s.materialIndex1 = PxBitAndByte(0);
+		}
+
+	PxHeightFieldDesc desc;
+	desc.format = PxHeightFieldFormat::eS16_TM;
+	desc.nbRows = field->getRowCount();
+	desc.nbColumns = field->getColumnCount();
+	desc.samples.data = &samples[0];
+	desc.samples.stride = sizeof(PxHeightFieldSample);
+
+	PxHeightField* heightField = gPhysicsSDK->createHeightField(desc);
+	if (heightField == NULL){
+		printf("Cannot create the PhysX height field for %s\n", field->getFileName());
+		return NULL;
+	}
+	SharedHeightField shared;
+	shared.field = field;
+	shared.heightField = heightField;
+	shared.heightScale = *heightScale;
+	sharedHeightFields.push_back(shared);
+	return heightField;
+}
+
 /**
 	This method reads a list of rigid bodies from the specified file.
 */
@@ -612,6 +786,8 @@ void PhysX3World::loadRBsFromFile(char* fName){
 	int index_afs = AFs.size();
 
 	World::loadRBsFromFile(fName);
+	//the contacts are reported into a list that is sized once, so the simulation steps never have to grow it
+	contactPoints.reserve(getMaxContactFeedback());
 
 	// Add all non-articulated rigid bodies in ODE
 	for (uint i=index;i<objects.size();i++){
@@ -683,6 +859,7 @@ void PhysX3World::addRigidBody( RigidBody* rigidBody ) {
 */
 void PhysX3World::addArticulatedFigure(ArticulatedFigure* articulatedFigure){
 	World::addArticulatedFigure( articulatedFigure );
+	contactPoints.reserve(getMaxContactFeedback());
 
 	// Add the articulated bodies contained into that figure to PhysX		
 	for (uint j=0;j<objects.size();j++){
@@ -740,9 +917,8 @@ void PhysX3World::linkRigidBodyToPhysX( int index ) {
 	//printf("code reached s\n");
 	RigidBody* rigidBody = physxToRbs[index].rb; 
 
-	if(!rigidBody->isLocked()){
-		rigidBody->setBodyID( index );
-	}
+	//the fixed bodies get an id as well, since the contact points are sorted by the ids of their bodies
+	rigidBody->setBodyID( index );
 	//CREATE AND LINK THE PhysX BODY WITH OUR RIGID BODY
 	//PROCESS THE COLLISION PRIMITIVES OF THE BODY
 	createPhysXCollisionPrimitives(rigidBody, index);
@@ -752,11 +928,11 @@ void PhysX3World::linkRigidBodyToPhysX( int index ) {
 	if (!rigidBody->isLocked()){
 		rigidBody->setBodyID( index );
 		//set the data
-		physxToRbs[index].id->userData = (void*) index;
+		physxToRbs[index].id->userData = (void*)(size_t) index;
 	}
 
-	//if this is a planar object, make sure we constrain it to always stay planar
-	if (rigidBody->props.isPlanar){
+	//if this is a planar object, make sure we constrain it to always stay planar. The locked bodies do not move anyway
+	if (rigidBody->props.isPlanar && !rigidBody->isLocked()){
 		PxD6Joint* pip = PxD6JointCreate(*gPhysicsSDK, NULL, PxTransform(), physxToRbs[index].id, PxTransform());
 		pip->setMotion(PxD6Axis::eY, PxD6Motion::eFREE);
 		pip->setMotion(PxD6Axis::eZ, PxD6Motion::eFREE);
@@ -785,6 +961,28 @@ void PhysX3World::setState(DynamicArray<double>* state, int start){
 	World::setState(state, start);
 }
 
+/**
+	This method puts the world back in the state that was saved in the snapshot. The PhysX actors are teleported to the saved poses, their
+	pending forces are cleared and they are woken up, so the next step starts from the snapshot and not from what PhysX last simulated.
+*/
+bool PhysX3World::restoreSnapshot(const WorldSnapshot& snapshot){
+	if (!World::restoreSnapshot(snapshot))
+		return false;
+
+	for (uint i=0;i<physxToRbs.size();i++){
+		//every actor is written, not only the ones whose state differs from the state buffer, so none of them keeps anything from after the snapshot
+		setPhysXStateFromRB(i);
+		if (physxToRbs[i].rb->isLocked())
+			continue;
+		physxToRbs[i].id->clearForce();
+		physxToRbs[i].id->clearTorque();
+		PxRigidDynamic* dynamicActor = physxToRbs[i].id->isRigidDynamic();
+		if (dynamicActor != NULL)
+			dynamicActor->wakeUp();
+	}
+	return true;
+}
+
 
 /**
 	This method is a simple call back function that passes the message to the world whose objects are being acted upon. 
@@ -799,62 +997,73 @@ void collisionCallBack(void* PhysX3World, PxShape * o1, PxShape * o2){
 */
 void PhysX3World::advanceInTime(double deltaT){
 	//printf("advanceInTime\n");
-	/*countto1000++;
-	LARGE_INTEGER ticksPerSecond;
-	QueryPerformanceFrequency(&ticksPerSecond);
-	LARGE_INTEGER tickbegin;
-	LARGE_INTEGER tickend;
-	LARGE_INTEGER time;
-	QueryPerformanceFrequency(&ticksPerSecond);
-	QueryPerformanceCounter(&tickbegin);*/
-
 	//printf("code reached x\n");
 	if( deltaT <= 0 )
 		return;
 
 	//make sure that the state of the RB's is synchronized with the engine...
-	setEngineStateFromRB();
+	{
+		PROFILE_SCOPE(PROFILE_STATE_SYNC);
+		setEngineStateFromRB();
+	}
 
 	//restart the counter for the joint feedback terms
 	jointFeedbackCount = 0;
 
-	//go through all the rigid bodies in the world, and apply their external force
-	for (uint j=0;j<objects.size();j++){
-		if( objects[j]->isLocked() ) 
-			continue;
-		const Vector3d& f = objects[j]->externalForce;
-		if( !f.isZeroVector() )
-			physxToRbs[objects[j]->id].id->addForce(PxVec3(f.x, f.y, f.z));
-		const Vector3d& t = /*Vector3d(0,0,1);//*/objects[j]->externalTorque;
-		if( !t.isZeroVector() )
-			//if(objects[j]->id == 1)
-			physxToRbs[objects[j]->id].id->addTorque(PxVec3(t.x, t.y, t.z));
-	}
+	{
+		PROFILE_SCOPE(PROFILE_TORQUE_APPLICATION);
+		//go through all the rigid bodies in the world, and apply their external force
+		for (uint j=0;j<objects.size();j++){
+			if( objects[j]->isLocked() ) 
+				continue;
+			const Vector3d& f = objects[j]->externalForce;
+			if( !f.isZeroVector() )
+				physxToRbs[objects[j]->id].id->addForce(PxVec3(f.x, f.y, f.z));
+			const Vector3d& t = /*Vector3d(0,0,1);//*/objects[j]->externalTorque;
+			if( !t.isZeroVector() )
+				//if(objects[j]->id == 1)
+				physxToRbs[objects[j]->id].id->addTorque(PxVec3(t.x, t.y, t.z));
+		}
 
-	//go through all the joints in the world, and apply their torques to the parent and child rb's
-	for (uint j=0;j<jts.size();j++){
-		Vector3d t = jts[j]->torque;
-		physxToRbs[jts[j]->parent->id].id->addTorque(PxVec3((float)t.x,(float)t.y, (float)t.z));
-		physxToRbs[jts[j]->child->id].id->addTorque(PxVec3((float)-t.x,(float)-t.y, (float)-t.z));
+		//go through all the joints in the world, and apply their torques to the parent and child rb's. A locked body has no dynamic
+		//actor, so its side of the torque is simply dropped
+		for (uint j=0;j<jts.size();j++){
+			Vector3d t = jts[j]->torque;
+			PxRigidBody* parent = physxToRbs[jts[j]->parent->id].id;
+			PxRigidBody* child = physxToRbs[jts[j]->child->id].id;
+			if (parent != NULL)
+				parent->addTorque(PxVec3((float)t.x,(float)t.y, (float)t.z));
+			if (child != NULL)
+				child->addTorque(PxVec3((float)-t.x,(float)-t.y, (float)-t.z));
+		}
 	}
 
 	//clear the previous list of contact forces
 	contactPoints.clear();
 	//gScene->setTiming(deltaT, 1, PX_TIMESTEP_FIXED);
-	gScene->simulate(deltaT);
-	gScene->fetchResults(true);
+	{
+		PROFILE_SCOPE(PROFILE_ENGINE_SIMULATE);
+		gScene->simulate(deltaT);
+	}
+	{
+		//the contacts are reported to the callback from in here
+		PROFILE_SCOPE(PROFILE_ENGINE_FETCH);
+		gScene->fetchResults(true);
+	}
 
 	//copy over the state of the PhysX bodies to the rigid bodies...
-	setRBStateFromEngine();
+	{
+		PROFILE_SCOPE(PROFILE_STATE_SYNC);
+		setRBStateFromEngine();
+	}
 
-	//printf("%d\n",countto1000);
-	/*QueryPerformanceCounter(&tickend);
-	after1000 += ((float)tickend.QuadPart - tickbegin.QuadPart)/ticksPerSecond.QuadPart;
-	if(countto1000 >= 1000){
-		printf("time of simulation : %f s\n",after1000/countto1000);
-		after1000 = 0.0f;
-		countto1000 = 0;
-	}*/
+	PROFILE_SCOPE(PROFILE_CONTACT_PROCESSING);
+	//the contact points are reported in the order in which PhysX processed the pairs, which can change from one run to the next
+	if (deterministic)
+		sortContactPoints();
+	//and let the rigid bodies know about the contact forces acting on them
+	indexContactPoints();
+	updateStepHash();
 }
 
 /**
@@ -869,9 +1078,15 @@ void PhysX3World::printAllCOMPosition(){
 */
 void PhysX3World::setRBStateFromEngine(){
 	//printf("code reached y\n");
-	//now update all the rigid bodies...
-	for (uint i=0;i<objects.size();i++){
-		setRBStateFromPhysX(i);
+	//only the bodies that moved during the last step are reported, and their poses all come in one list. The others keep their state
+	PxU32 nbActiveTransforms = 0;
+	const PxActiveTransform* activeTransforms = gScene->getActiveTransforms(nbActiveTransforms);
+	for (PxU32 k=0;k<nbActiveTransforms;k++){
+		//the user data of the PhysX actors is the index of their rigid body
+		int i = (int)(size_t)activeTransforms[k].userData;
+		if (i<0 || (uint)i>=physxToRbs.size() || physxToRbs[i].id != activeTransforms[k].actor || physxToRbs[i].rb->isLocked())
+			continue;
+		setRBStateFromPhysX(i, activeTransforms[k].actor2World, physxToRbs[i].id->getLinearVelocity(), physxToRbs[i].id->getAngularVelocity());
 //		objects[i]->updateToWorldTransformation();
 	}
 }
@@ -881,8 +1096,11 @@ void PhysX3World::setRBStateFromEngine(){
 */
 void PhysX3World::setEngineStateFromRB(){
 	//printf("code reached z\n");
-	//now update all the rigid bodies...
-	for (uint i=0;i<objects.size();i++){
+	//only the rigid bodies whose state was changed since it was last exchanged with PhysX need to be updated
+	resizeStateBuffer();
+	for (uint i=0;i<physxToRbs.size();i++){
+		if (isStateBufferCurrent(i))
+			continue;
 		setPhysXStateFromRB(i);
 	}
 }
@@ -893,7 +1111,8 @@ void PhysX3World::setEngineStateFromRB(){
 */
 void PhysX3World::applyRelForceTo(RigidBody* b, const Vector3d& f, const Point3d& p){
 	//printf("code reached a1\n");
-	if (!b)
+	//the locked bodies only have a static actor, forces do not move them
+	if (!b || physxToRbs[b->id].id == NULL)
 		return;
 	PxRigidBodyExt::addLocalForceAtLocalPos(*(physxToRbs[b->id].id), PxVec3(f.x, f.y, f.z), PxVec3(p.x, p.y, p.z));
 }
@@ -904,7 +1123,7 @@ void PhysX3World::applyRelForceTo(RigidBody* b, const Vector3d& f, const Point3d
 */
 void PhysX3World::applyForceTo(RigidBody* b, const Vector3d& f, const Point3d& p){
 	//printf("code reached a2\n");
-	if (!b)
+	if (!b || physxToRbs[b->id].id == NULL)
 		return;
 	PxRigidBodyExt::addForceAtLocalPos(*(physxToRbs[b->id].id), PxVec3(f.x, f.y, f.z), PxVec3(p.x, p.y, p.z));
 }
@@ -914,7 +1133,7 @@ void PhysX3World::applyForceTo(RigidBody* b, const Vector3d& f, const Point3d& p
 */
 void PhysX3World::applyTorqueTo(RigidBody* b, const Vector3d& t){
 	//printf("code reached a3\n");
-	if (!b)
+	if (!b || physxToRbs[b->id].id == NULL)
 		return;
 	physxToRbs[b->id].id->addTorque(PxVec3(t.x, t.y, t.z));
 	//dBodyAddTorque(odeToRbs[b->id].id, t.x, t.y, t.z);
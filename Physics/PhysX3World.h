@@ -3,7 +3,7 @@
 #include <PxPhysicsAPI.h>
 #include <PxExtensionsAPI.h>
 #include <PxCudaContextManager.h>
-#include <PxProfileZonemanager.h>
+#include <PxProfileZoneManager.h>
 #include <PvdConnectionManager.h>
 
 #define NOMINMAX
@@ -13,21 +13,45 @@
 #include "CapsuleCDP.h"
 #include "BoxCDP.h"
 #include "PlaneCDP.h"
+#include "HeightFieldCDP.h"
 #include "PreCollisionQuery.h"
+#include "StiffJoint.h"
 
 #define MAX_CONTACT_FEEDBACK 200
 
+//the collision groups of the PhysX shapes. Shapes that share a group never collide with each other: the static bodies are one group, the free
+//bodies another, and every articulated figure gets its own, so the characters of a crowd collide with each other but not with themselves
+#define PHYSX3_GROUP_STATIC 1
+#define PHYSX3_GROUP_FREE 2
+//the figures use the groups 1<<2 to 1<<31. Beyond 30 figures the groups are reused, so figures k and k+30 do not collide with each other
+#define PHYSX3_FIRST_FIGURE_GROUP 2
+#define PHYSX3_FIGURE_GROUP_COUNT 30
+
 using namespace physx;
 
 //this structure is used to map a rigid body to the id of its PhysX counterpart
 typedef struct PhysX3_RB_Map_struct{
 	PxRigidBody* id;
 	RigidBody* rb;
-	DynamicArray<PxShape*> collisionVolumes; // Only used for rigid bodies
-	PhysX3_RB_Map_struct() : id(NULL), rb(NULL) {}
-	PhysX3_RB_Map_struct(PxRigidBody* newId, RigidBody* newRb){ this->id = newId; this->rb = newRb;}
+	//the locked bodies get a static actor instead, which holds all of their shapes
+	PxRigidStatic* staticId;
+	PhysX3_RB_Map_struct() : id(NULL), rb(NULL), staticId(NULL) {}
+	PhysX3_RB_Map_struct(PxRigidBody* newId, RigidBody* newRb){ this->id = newId; this->rb = newRb; this->staticId = NULL;}
 } PhysX3_RB_Map;
 
+/**
+	This structure holds the state of all the bodies in the world, one contiguous array per quantity, in the same order as physxToRbs. It is the state
+	that was last exchanged with PhysX, so the bodies whose state did not change since then can be skipped when the states are transferred.
+*/
+typedef struct PhysX3_State_Buffer_struct{
+	DynamicArray<Point3d> positions;
+	DynamicArray<Quaternion> orientations;
+	DynamicArray<Vector3d> velocities;
+	DynamicArray<Vector3d> angularVelocities;
+	//this is false for the bodies that were never exchanged with PhysX yet
+	DynamicArray<bool> valid;
+} PhysX3_State_Buffer;
+
 class PhysX3World : public World
 {
 	friend class MyCallback;
@@ -38,6 +62,10 @@ private :
 	PxCooking* gCooking;
 	PxMaterial* defaultMaterial;
 	physx::pxtask::CudaContextManager* gCudaContextManager;
+	PxDefaultCpuDispatcher* gCpuDispatcher;
+
+	//each world gets its own event callback, so that the contacts of one scene never end up in another world
+	PxSimulationEventCallback* contactCallback;
 
 	//PhysX's static actor for collision space
 	PxActor * spaceID;
@@ -45,6 +73,9 @@ private :
 	//keep track of the mapping between the rigid bodies and their PhysX counterparts with this
 	DynamicArray<PhysX3_RB_Map> physxToRbs;
 
+	//the state of the bodies, as it was last exchanged with PhysX
+	PhysX3_State_Buffer stateBuffer;
+
 	//this is the max number of contacts that are going to be processed between any two objects
 	int maxContactCount;
 
@@ -60,6 +91,18 @@ private :
 	*/
 	void setupFiltering(PxRigidActor* actor, PxU32 filterGroup, PxU32 filterMask);
 
+	/**
+		this method returns the collision group of the rigid body that is passed in. Bodies that share a group never collide with each other
+	*/
+	PxU32 getFilterGroup(RigidBody* rb);
+
+	/**
+		this method returns the largest number of contact points that are reported in one step. Every articulated figure gets MAX_CONTACT_FEEDBACK
+	*/
+	inline int getMaxContactFeedback(){
+		return MAX_CONTACT_FEEDBACK * ((AFs.size() > 1) ? AFs.size() : 1);
+	}
+
 	/**
 		this method is used to copy the state of the ith rigid body to its PhysX counterpart.
 	*/
@@ -70,6 +113,26 @@ private :
 	*/
 	void setRBStateFromPhysX(int i);
 
+	/**
+		this method is used to copy the pose and the velocities that PhysX computed for the ith rigid body to the state buffer and to the rigid body
+	*/
+	void setRBStateFromPhysX(int i, const PxTransform& pose, const PxVec3& velocity, const PxVec3& angularVelocity);
+
+	/**
+		this method makes sure that the state buffer has one entry for every rigid body
+	*/
+	void resizeStateBuffer();
+
+	/**
+		this method returns true if the state of the ith rigid body is the same as the one that was last exchanged with PhysX
+	*/
+	bool isStateBufferCurrent(int i);
+
+	/**
+		returns the PhysX actor of the ith rigid body: its dynamic actor, or its static actor if the body is locked
+	*/
+	PxRigidActor* getPhysXActor(int i);
+
 	/**
 		This method is used to set up a PhysX fixed joint, based on the information in the fixed joint passed in as a parameter
 	*/
@@ -95,6 +158,13 @@ private :
 	*/
 	void createPhysXCollisionPrimitives(RigidBody* body, int index);
 
+	/**
+		this method returns the PhysX height field for the terrain passed in as a parameter. It is only made the first time it is asked
+		for, and then shared by the scenes of all the worlds. The heights are stored as 16 bit integers, so heightScale is set to the
+		height of one unit.
+	*/
+	PxHeightField* getPhysXHeightField(HeightFieldData* field, PxReal* heightScale);
+
 	/**
 		This method reads a list of rigid bodies from the specified file.
 	*/
@@ -130,9 +200,9 @@ private :
 
 public :
 	/**
-		default constructor
+		constructor. A deterministic world runs the steps of its scene on one thread and sorts its contact points.
 	*/
-	PhysX3World();
+	PhysX3World(bool deterministic = false);
 
 	/**
 		destructor
@@ -157,6 +227,12 @@ public :
 	*/
 	void setState(DynamicArray<double>* state, int start = 0);
 
+	/**
+		This method puts the world back in the state that was saved in the snapshot. The PhysX actors are teleported to the saved poses, their
+		pending forces are cleared and they are woken up, so the next step starts from the snapshot and not from what PhysX last simulated.
+	*/
+	virtual bool restoreSnapshot(const WorldSnapshot& snapshot);
+
 	/**
 		This method is used to integrate the forward simulation in time.
 	*/
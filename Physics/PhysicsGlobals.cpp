@@ -7,3 +7,5 @@
 //give this a very high value so that we can use the scripted values in the rb specs for the value to use
 double PhysicsGlobals::gravity = -9.81;//*/0.0;
 Vector3d PhysicsGlobals::up = Vector3d(0, 1, 0);
+int PhysicsGlobals::physXThreadCount = 3;
+bool PhysicsGlobals::deterministic = false;
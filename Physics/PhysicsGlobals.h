@@ -11,5 +11,10 @@ public:
 	//We will assume that the gravity is in the y-direction (this can easily be changed if need be), and this value gives its magnitude. 
 	static double gravity;
 	static Vector3d up;
+	//this is the number of worker threads each PhysX scene gets for its CPU dispatcher. Lower it when many worlds run side by side.
+	static int physXThreadCount;
+	//when this is true, the worlds that World::create makes from then on are deterministic, whatever controllerconfig.txt says (see World).
+	//The worlds that already exist keep the mode they were created with
+	static bool deterministic;
 
 };
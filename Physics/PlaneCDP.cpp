@@ -3,6 +3,7 @@
 #include "PlaneCDP.h"
 #include "SphereCDP.h"
 #include "CapsuleCDP.h"
+#include "BoxCDP.h"
 #include "RigidBody.h"
 
 PlaneCDP::~PlaneCDP(void){
@@ -31,3 +32,12 @@ int PlaneCDP::computeCollisionsWithCapsuleCDP(CapsuleCDP* c,  DynamicArray<Conta
 	return getContactPoints(&this->wP, &c->wC, cps);
 }
 
+
+int PlaneCDP::computeCollisionsWithBoxCDP(BoxCDP* b,  DynamicArray<ContactPoint> *cps){
+	//the box knows how to do this - we just need the normals to point the other way
+	int start = cps->size();
+	int n = b->computeCollisionsWithPlaneCDP(this, cps);
+	for (int i=0;i<n;i++)
+		((*cps)[start+i]).n *= -1;
+	return n;
+}
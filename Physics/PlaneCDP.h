@@ -18,6 +18,7 @@
 class PlaneCDP : public CollisionDetectionPrimitive{
 	friend class SphereCDP;
 	friend class CapsuleCDP;
+	friend class BoxCDP;
 private:
 	//this is the plane, expressed in the local coordinates of the rigid body that owns it
 	Plane p;
@@ -36,7 +37,7 @@ public:
 		CollisionDetectionPrimitive( PLANE_CDP, theBody ) {}
 	~PlaneCDP(void);
 
-	virtual char* save() { return "PlaneCDP"; }
+	virtual const char* save() { return "PlaneCDP"; }
 
 	virtual void updateToWorldPrimitive();
 
@@ -62,7 +63,7 @@ public:
 
 	virtual int computeCollisionsWithPlaneCDP(PlaneCDP* sp,  DynamicArray<ContactPoint> *cps){return 0;}
 	virtual int computeCollisionsWithCapsuleCDP(CapsuleCDP* c,  DynamicArray<ContactPoint> *cps);
-	virtual int computeCollisionsWithBoxCDP(BoxCDP* sp,  DynamicArray<ContactPoint> *cps){return 0;}
+	virtual int computeCollisionsWithBoxCDP(BoxCDP* b,  DynamicArray<ContactPoint> *cps);
 
 };
 
@@ -1,32 +1,364 @@
-#include "RBDynJoint.h"
+#include "stdafx.h"
 
-RBDynJoint::RBDynJoint(void){
+#include "RBDynJoint.h"
+#include "RigidBody.h"
+#include "ArticulatedRigidBody.h"
+#include "StiffJoint.h"
+#include "HingeJoint.h"
+#include "UniversalJoint.h"
+#include "BallInSocketJoint.h"
+#include <MathLib.h>
+#include <float.h>
 
+RBDynJoint::RBDynJoint(Joint* joint){
+	this->j = joint;
+	//stiff joints keep whatever relative orientation the bodies start with
+	j->computeRelativeOrientation(qRelRest);
+	for (int i=0;i<9;i++)
+		kInv[i] = 0;
+	nRows = 0;
+	nProjectionRows = 0;
+	for (int i=0;i<RBDYN_MAX_ANGULAR_ROWS;i++){
+		rows[i].bias = rows[i].effMass = rows[i].impulse = 0;
+		rows[i].lo = -DBL_MAX;
+		rows[i].hi = DBL_MAX;
+	}
 }
 
 RBDynJoint::~RBDynJoint(void){
 
 }
 
+/**
+	This method returns the inverse world inertia tensor of the body, multiplied by v.
+*/
+Vector3d RBDynJoint::applyInverseInertia(RigidBody* rb, const Vector3d& v){
+	if (rb->props.isLocked)
+		return Vector3d(0,0,0);
+	//the inertia tensor is diagonal in the body frame, so go to the body frame, scale, and come back
+	Vector3d vLocal = rb->state.orientation.inverseRotate(v);
+	vLocal.x *= rb->props.invMOI_local.x;
+	vLocal.y *= rb->props.invMOI_local.y;
+	vLocal.z *= rb->props.invMOI_local.z;
+	return rb->state.orientation.rotate(vLocal);
+}
+
+/**
+	This method is used to set up the rows of P (the directions along which no relative rotation is allowed), together with
+	the bias that corrects the drift of the relative orientation.
+*/
+void RBDynJoint::setUpProjectionMatrix(const Quaternion& qRel, double erp, double dt){
+	Quaternion qP = j->parent->state.orientation;
+	Quaternion qC = j->child->state.orientation;
+	//the impulses of the rows of P are left alone, they are the warm starting guess for this step
+	nRows = 0;
+
+	switch (j->getJointType()){
+		case STIFF_JOINT:{
+			//all three directions are constrained. The error is the rotation that takes the child to where it should be
+			Quaternion qErr = (qP * qRelRest) * qC.getComplexConjugate();
+			if (qErr.s < 0)
+				qErr *= -1;
+			Vector3d err = qErr.v * 2;
+			rows[0].axis = Vector3d(1,0,0);
+			rows[1].axis = Vector3d(0,1,0);
+			rows[2].axis = Vector3d(0,0,1);
+			for (int i=0;i<3;i++)
+				rows[i].bias = err.dotProductWith(rows[i].axis) * erp / dt;
+			nRows = 3;
+			break;
+		}
+		case HINGE_JOINT:{
+			//only rotation about the hinge axis is allowed, so the two directions orthogonal to it are constrained
+			HingeJoint* hj = (HingeJoint*)j;
+			Vector3d aP = qP.rotate(hj->a);
+			Vector3d aC = qC.rotate(hj->a);
+			Vector3d err = aC.crossProductWith(aP);
+			aP.getOrthogonalVectors(&rows[0].axis, &rows[1].axis);
+			for (int i=0;i<2;i++)
+				rows[i].bias = err.dotProductWith(rows[i].axis) * erp / dt;
+			nRows = 2;
+			break;
+		}
+		case UNIVERSAL_JOINT:{
+			//the axis a of the parent and b of the child need to stay orthogonal, which constrains the rotation about a x b
+			UniversalJoint* uj = (UniversalJoint*)j;
+			Vector3d aW = qP.rotate(uj->a);
+			Vector3d bW = qC.rotate(uj->b);
+			Vector3d n = aW.crossProductWith(bW);
+			double len = n.length();
+			if (len < 1e-6)
+				break;
+			rows[0].axis = n / len;
+			rows[0].bias = aW.dotProductWith(bW) * erp / (dt * len);
+			nRows = 1;
+			break;
+		}
+		default:
+			//ball in socket joints are free to rotate
+			break;
+	}
+
+	for (int i=0;i<nRows;i++){
+		rows[i].lo = -DBL_MAX;
+		rows[i].hi = DBL_MAX;
+	}
+	nProjectionRows = nRows;
+}
+
+/**
+	This method adds a one-sided row that keeps the joint angle (whose rate of change is relative angular velocity along axis)
+	within [minAngle, maxAngle].
+*/
+void RBDynJoint::addLimitRow(const Vector3d& axis, double angle, double minAngle, double maxAngle, double erp, double dt){
+	Vector3d wRel = j->child->state.angularVelocity - j->parent->state.angularVelocity;
+	//look ahead one step, so that the limit is caught before it is crossed rather than after
+	double predictedAngle = angle + wRel.dotProductWith(axis) * dt;
+
+	if (predictedAngle < minAngle && nRows < RBDYN_MAX_ANGULAR_ROWS){
+		double err = minAngle - angle;
+		rows[nRows].axis = axis;
+		rows[nRows].bias = (err > 0) ? (err * erp / dt) : (err / dt);
+		rows[nRows].impulse = 0;
+		rows[nRows].lo = 0;
+		rows[nRows].hi = DBL_MAX;
+		nRows++;
+	}
+	if (predictedAngle > maxAngle && nRows < RBDYN_MAX_ANGULAR_ROWS){
+		double err = angle - maxAngle;
+		rows[nRows].axis = axis * -1;
+		rows[nRows].bias = (err > 0) ? (err * erp / dt) : (err / dt);
+		rows[nRows].impulse = 0;
+		rows[nRows].lo = 0;
+		rows[nRows].hi = DBL_MAX;
+		nRows++;
+	}
+}
+
+/**
+	This method computes the angles of the joint that are subject to joint limits, given the relative orientation qRel of the child
+	with respect to the parent. It returns the number of angles that were written to limits (at most RBDYN_MAX_ANGULAR_ROWS/2).
+*/
+int RBDynJoint::getLimitedAngles(Joint* j, const Quaternion& qRel, RBDynLimitedAngle* limits){
+	Quaternion qP = j->parent->state.orientation;
+	Quaternion qC = j->child->state.orientation;
+	Quaternion q = qRel;
+	int n = 0;
+
+	switch (j->getJointType()){
+		case HINGE_JOINT:{
+			HingeJoint* hj = (HingeJoint*)j;
+			limits[n].axis = qP.rotate(hj->a);
+			limits[n].angle = q.getRotationAngle(hj->a);
+			limits[n].minAngle = hj->minAngle;
+			limits[n].maxAngle = hj->maxAngle;
+			n++;
+			break;
+		}
+		case UNIVERSAL_JOINT:{
+			//qRel = qA * qB, where qA is about a (parent frame) and qB about b (child frame)
+			UniversalJoint* uj = (UniversalJoint*)j;
+			Quaternion qA, qB;
+			q.decomposeRotation(&qA, &qB, uj->b);
+			limits[n].axis = qP.rotate(uj->a);
+			limits[n].angle = qA.getRotationAngle(uj->a);
+			limits[n].minAngle = uj->minAngleA;
+			limits[n].maxAngle = uj->maxAngleA;
+			n++;
+			limits[n].axis = qC.rotate(uj->b);
+			limits[n].angle = qB.getRotationAngle(uj->b);
+			limits[n].minAngle = uj->minAngleB;
+			limits[n].maxAngle = uj->maxAngleB;
+			n++;
+			break;
+		}
+		case BALL_IN_SOCKET_JOINT:{
+			//qRel = qSwing * qTwist, where qTwist is about the twist axis (child frame). The swing is limited separately along
+			//the two swing axes, which is a box approximation of the elliptical cone
+			BallInSocketJoint* bj = (BallInSocketJoint*)j;
+			if (bj->twistAxis.isZeroVector())
+				break;
+			Quaternion qSwing, qTwist;
+			q.decomposeRotation(&qSwing, &qTwist, bj->twistAxis);
+			if (bj->maxTwistAngle - bj->minTwistAngle < 2*PI){
+				limits[n].axis = qC.rotate(bj->twistAxis);
+				limits[n].angle = qTwist.getRotationAngle(bj->twistAxis);
+				limits[n].minAngle = bj->minTwistAngle;
+				limits[n].maxAngle = bj->maxTwistAngle;
+				n++;
+			}
+
+			if (qSwing.s < 0)
+				qSwing *= -1;
+			double swingAngle = 2 * safeACOS(qSwing.s);
+			Vector3d swing = qSwing.v;
+			if (swing.length() > 1e-10)
+				swing = swing.unit() * swingAngle;
+			Vector3d swingAxis2 = bj->swingAxis2;
+			if (swingAxis2.isZeroVector())
+				swingAxis2 = bj->swingAxis1.crossProductWith(bj->twistAxis).toUnit();
+			if (!bj->swingAxis1.isZeroVector()){
+				limits[n].axis = qP.rotate(bj->swingAxis1);
+				limits[n].angle = swing.dotProductWith(bj->swingAxis1);
+				limits[n].minAngle = bj->minSwingAngle1;
+				limits[n].maxAngle = bj->maxSwingAngle1;
+				n++;
+			}
+			if (!swingAxis2.isZeroVector()){
+				limits[n].axis = qP.rotate(swingAxis2);
+				limits[n].angle = swing.dotProductWith(swingAxis2);
+				limits[n].minAngle = bj->minSwingAngle2;
+				limits[n].maxAngle = bj->maxSwingAngle2;
+				n++;
+			}
+			break;
+		}
+		default:
+			break;
+	}
+	return n;
+}
+
+/**
+	This method is used to determine which joint limits are about to be violated, and it adds a one-sided row for each one of them.
+*/
+void RBDynJoint::addJointLimitRows(const Quaternion& qRel, double erp, double dt){
+	RBDynLimitedAngle limits[RBDYN_MAX_ANGULAR_ROWS/2];
+	int n = getLimitedAngles(j, qRel, limits);
+	for (int i=0;i<n;i++)
+		addLimitRow(limits[i].axis, limits[i].angle, limits[i].minAngle, limits[i].maxAngle, erp, dt);
+}
+
+/**
+	This method is used to prepare the constraint quantities (anchors, effective masses, P, the joint limits) for the step that
+	is about to be taken. erp is the fraction of the drift that is corrected in one step.
+*/
+void RBDynJoint::prepare(double erp, double dt){
+	RigidBody* p = j->parent;
+	RigidBody* c = j->child;
 
+	Point3d pAnchor = p->getWorldCoordinates(j->pJPos);
+	Point3d cAnchor = c->getWorldCoordinates(j->cJPos);
+	rP = Vector3d(p->state.position, pAnchor);
+	rC = Vector3d(c->state.position, cAnchor);
+	//move the child's anchor back on top of the parent's
+	pointBias = Vector3d(cAnchor, pAnchor) * (erp / dt);
+
+	//K = (1/mp + 1/mc) * I - [rc]x Ic^-1 [rc]x - [rp]x Ip^-1 [rp]x, built one column at a time
+	double K[9];
+	double invM = p->props.invMass + c->props.invMass;
+	for (int k=0;k<3;k++){
+		Vector3d e((k==0)?1:0, (k==1)?1:0, (k==2)?1:0);
+		Vector3d col = e * invM + applyInverseInertia(c, rC.crossProductWith(e)).crossProductWith(rC) + applyInverseInertia(p, rP.crossProductWith(e)).crossProductWith(rP);
+		K[k] = col.x;
+		K[3+k] = col.y;
+		K[6+k] = col.z;
+	}
+	double det = K[0]*(K[4]*K[8]-K[5]*K[7]) - K[1]*(K[3]*K[8]-K[5]*K[6]) + K[2]*(K[3]*K[7]-K[4]*K[6]);
+	if (fabs(det) < 1e-12){
+		for (int i=0;i<9;i++)
+			kInv[i] = 0;
+	}else{
+		double invDet = 1 / det;
+		kInv[0] = (K[4]*K[8]-K[5]*K[7]) * invDet;
+		kInv[1] = (K[2]*K[7]-K[1]*K[8]) * invDet;
+		kInv[2] = (K[1]*K[5]-K[2]*K[4]) * invDet;
+		kInv[3] = (K[5]*K[6]-K[3]*K[8]) * invDet;
+		kInv[4] = (K[0]*K[8]-K[2]*K[6]) * invDet;
+		kInv[5] = (K[2]*K[3]-K[0]*K[5]) * invDet;
+		kInv[6] = (K[3]*K[7]-K[4]*K[6]) * invDet;
+		kInv[7] = (K[1]*K[6]-K[0]*K[7]) * invDet;
+		kInv[8] = (K[0]*K[4]-K[1]*K[3]) * invDet;
+	}
+
+	Quaternion qRel;
+	j->computeRelativeOrientation(qRel);
+	setUpProjectionMatrix(qRel, erp, dt);
+	if (j->useJointLimits)
+		addJointLimitRows(qRel, erp, dt);
+
+	for (int i=0;i<nRows;i++){
+		rows[i].invIpAxis = applyInverseInertia(p, rows[i].axis);
+		rows[i].invIcAxis = applyInverseInertia(c, rows[i].axis);
+		double denom = rows[i].axis.dotProductWith(rows[i].invIpAxis + rows[i].invIcAxis);
+		rows[i].effMass = (denom > 1e-12) ? (1 / denom) : 0;
+	}
+}
 
 /**
-	This method is used to determine if we need to enforce joint limits, and which limits (for universal joints for instance)
-	we need to enforce. The details for the return value are implemented on a per joint basis.
+	This method applies the impulse that is passed in to the child at the child anchor, and the opposite impulse to the parent.
 */
-int Joint::getJointLimitsToEnforce(const Quaternion& qRel, const Vector3d &relAngVel){
-	return 0;
+void RBDynJoint::applyPointImpulse(const Vector3d& impulse){
+	RigidBody* p = j->parent;
+	RigidBody* c = j->child;
+	c->state.velocity += impulse * c->props.invMass;
+	c->state.angularVelocity += applyInverseInertia(c, rC.crossProductWith(impulse));
+	p->state.velocity -= impulse * p->props.invMass;
+	p->state.angularVelocity -= applyInverseInertia(p, rP.crossProductWith(impulse));
 }
 
+/**
+	This method applies an angular impulse of the given magnitude along the axis of the row to the child, and the opposite one to the parent.
+*/
+void RBDynJoint::applyRowImpulse(const RBDynAngularRow& row, double impulse){
+	j->child->state.angularVelocity += row.invIcAxis * impulse;
+	j->parent->state.angularVelocity -= row.invIpAxis * impulse;
+}
 
 /**
-	This method is used to set up the P matrix using the vectors in the constrained vector above.
+	This method applies the impulses accumulated in the previous step, as a starting guess for this one.
 */
-void Joint::setUpProjectionMatrix(){
-	if (cVecs.size()==0 || cVecs.size()>3)
-		return;
+void RBDynJoint::warmStart(){
+	applyPointImpulse(pointImpulse);
+	for (int i=0;i<nProjectionRows;i++)
+		applyRowImpulse(rows[i], rows[i].impulse);
+}
 
-	P.resizeTo(cVecs.size(), 3);
-	for (int i=0;i<cVecs.size();i++)
-		setMatrixRow(&P, *cVecs[i], i);
-}
\ No newline at end of file
+/**
+	This method writes the impulses that are kept from one step to the next (RBDYN_WARM_START_SIZE values) to values.
+*/
+void RBDynJoint::getWarmStartImpulses(double* values){
+	values[0] = pointImpulse.x;
+	values[1] = pointImpulse.y;
+	values[2] = pointImpulse.z;
+	for (int i=0;i<3;i++)
+		values[3+i] = rows[i].impulse;
+}
+
+/**
+	This method sets the impulses that are kept from one step to the next from values (RBDYN_WARM_START_SIZE of them).
+*/
+void RBDynJoint::setWarmStartImpulses(const double* values){
+	pointImpulse = Vector3d(values[0], values[1], values[2]);
+	for (int i=0;i<3;i++)
+		rows[i].impulse = values[3+i];
+}
+
+/**
+	This method does one sequential impulse pass over all the constraints of this joint.
+*/
+void RBDynJoint::solve(){
+	RigidBody* p = j->parent;
+	RigidBody* c = j->child;
+
+	//the point constraint: the two anchors should move together (plus the drift correction)
+	Vector3d vRel = (c->state.velocity + c->state.angularVelocity.crossProductWith(rC)) - (p->state.velocity + p->state.angularVelocity.crossProductWith(rP));
+	Vector3d dv = pointBias - vRel;
+	Vector3d impulse(kInv[0]*dv.x + kInv[1]*dv.y + kInv[2]*dv.z,
+					 kInv[3]*dv.x + kInv[4]*dv.y + kInv[5]*dv.z,
+					 kInv[6]*dv.x + kInv[7]*dv.y + kInv[8]*dv.z);
+	pointImpulse += impulse;
+	applyPointImpulse(impulse);
+
+	//and then the angular rows
+	for (int i=0;i<nRows;i++){
+		RBDynAngularRow& row = rows[i];
+		double wRel = (c->state.angularVelocity - p->state.angularVelocity).dotProductWith(row.axis);
+		double lambda = row.effMass * (row.bias - wRel);
+		double oldImpulse = row.impulse;
+		row.impulse = oldImpulse + lambda;
+		if (row.impulse < row.lo) row.impulse = row.lo;
+		if (row.impulse > row.hi) row.impulse = row.hi;
+		applyRowImpulse(row, row.impulse - oldImpulse);
+	}
+}
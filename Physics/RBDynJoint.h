@@ -1,51 +1,145 @@
 #pragma once
 
+#include <Vector3d.h>
+#include <Quaternion.h>
+#include "Joint.h"
+
+class RigidBody;
+
+//the most angular constraint rows a joint can need: 3 for a stiff joint, or up to 3 joint limits for a ball in socket joint
+#define RBDYN_MAX_ANGULAR_ROWS 6
+//the number of values that are carried over from one step to the next: the point impulse, and the impulses of the (at most 3) rows of P
+#define RBDYN_WARM_START_SIZE 6
+
+/**
+	One scalar angular constraint of a joint: the relative angular velocity of the child with respect to the parent, projected
+	on axis, is driven towards bias. The accumulated impulse is clamped to [lo, hi], so equality constraints use an infinite
+	range and joint limits only allow impulses that push away from the limit.
+*/
+typedef struct RBDynAngularRow_struct{
+	//the constrained axis, in world coordinates
+	Vector3d axis;
+	//the target relative angular velocity along the axis (used to correct drift)
+	double bias;
+	//the change in angular velocity of the parent and of the child due to a unit impulse along the axis
+	Vector3d invIpAxis, invIcAxis;
+	//1 / (axis' * (Ip^-1 + Ic^-1) * axis)
+	double effMass;
+	//the impulse accumulated over the solver iterations of this step
+	double impulse;
+	double lo, hi;
+} RBDynAngularRow;
+
+/**
+	One angle of a joint that has limits: angle is measured about axis (in world coordinates), and it should stay within [minAngle, maxAngle].
+*/
+typedef struct RBDynLimitedAngle_struct{
+	Vector3d axis;
+	double angle;
+	double minAngle, maxAngle;
+} RBDynLimitedAngle;
+
 /*-----------------------------------------------------------------------------------------------------------------------------------------------------*
- * This class provides an interface, and some of the common and necessary class members + methods that the joints used in the RBDyn library will need. *
+ * This class holds the constraint data that the in-house rigid body engine (NativeWorld) needs for one joint. Every joint keeps its two anchors    *
+ * together (a point constraint), and then the projection matrix P picks the directions along which relative rotation is not allowed, based on the *
+ * joint type. Joint limits are added as extra, one-sided rows whenever they are about to be violated. The constraints are solved with sequential  *
+ * impulses, directly on the velocities stored in the rigid bodies.                                                                                 *
  *-----------------------------------------------------------------------------------------------------------------------------------------------------*/
 class RBDynJoint {
 private:
-	//this matrix is used to project quantities into a different manifold (i.e. a plane or on a line). Typically, this is
-	//the plane or line along which there should be 0 relative orientation. For instance, for a hinge joint, rotation is only
-	//permitted along a certain axis, so it shouldn't be allowed in the plane that the axis is perpendicular on.
-	Matrix P;
-	//this list of vectors is used to easily set up the P matrix. The entries in this vector represent the axis along which rotation should be constrained
-	PODDynamicArray<Vector3d*> cVecs;
+	//this is the joint that we are enforcing
+	Joint* j;
+
+	//for stiff joints, this is the relative orientation between the parent and the child that needs to be preserved
+	Quaternion qRelRest;
 
-	//this is the location, in world coordinates, of the joint. It is located at the mid-point between the world coordinates of the
-	//child and parent's joint poisition - this should really be the same point in world coordinates, otherwise we have drift problems!!!
-	Point3d globalP;
+	//the vectors from the parent's and the child's center of mass to the joint anchors, in world coordinates
+	Vector3d rP, rC;
+	//the target relative velocity of the two anchors (used to correct drift)
+	Vector3d pointBias;
+	//the inverse of the 3x3 effective mass matrix of the point constraint, stored row major
+	double kInv[9];
+	//the linear impulse accumulated on the child (the parent gets the opposite). It is kept from one step to the next to warm start the solver
+	Vector3d pointImpulse;
+
+	//the rows of the projection matrix P, followed by the joint limit rows that are active for the current step
+	RBDynAngularRow rows[RBDYN_MAX_ANGULAR_ROWS];
+	int nRows;
+	//the first nProjectionRows rows are the equality constraints of P, and their impulses are also used to warm start the solver
+	int nProjectionRows;
 
 	/**
-		This method is used to set up the P matrix using the vectors in the constrained vector above.
+		This method is used to set up the rows of P (the directions along which no relative rotation is allowed), together with
+		the bias that corrects the drift of the relative orientation.
 	*/
-	void setUpProjectionMatrix();
+	void setUpProjectionMatrix(const Quaternion& qRel, double erp, double dt);
 
 	/**
-		This method is used to determine if we need to enforce joint limits, and which limits (for universal joints for instance)
-		we need to enforce. The details for the return value are implemented on a per joint basis.
+		This method is used to determine which joint limits are about to be violated, and it adds a one-sided row for each one of them.
 	*/
-	virtual int getJointLimitsToEnforce(const Quaternion& qRel, const Vector3d &relAngVel) = 0;
+	void addJointLimitRows(const Quaternion& qRel, double erp, double dt);
 
 	/**
-		This method is used to give a rough estimate of the new relative positition between the connected rigid bodies, given the
-		current orientation and relative angular velocity. This way we can see if a joint limit needs to be enforced or not.
+		This method adds a one-sided row that keeps the joint angle (whose rate of change is relative angular velocity along axis)
+		within [minAngle, maxAngle].
 	*/
-	Quaternion getPredictedRelativeOrientation(const Quaternion& qRel, const Vector3d &relAngVel);
+	void addLimitRow(const Vector3d& axis, double angle, double minAngle, double maxAngle, double erp, double dt);
 
 	/**
-		This method returns true if there is a need for an angular impulse, false otherwise. 
+		This method applies the impulse that is passed in to the child at the child anchor, and the opposite impulse to the parent.
 	*/
-	virtual bool needAngularImpulse() = 0;
+	void applyPointImpulse(const Vector3d& impulse);
 
 	/**
-		This method is used to prepare the proper quantities (i.e. P, the joint angles, etc) for the current joint. 
-		The relative orientation and relative angular velocity are passed in so that we can predict 
-		if joint limits need to be enforced or not.
+		This method applies an angular impulse of the given magnitude along the axis of the row to the child, and the opposite one to the parent.
 	*/
-	virtual void prepareAngularConstraint(const Quaternion& qRel, const Vector3d &relAngVel) = 0;
+	void applyRowImpulse(const RBDynAngularRow& row, double impulse);
 
 public:
-	RBDynJoint(void);
+	RBDynJoint(Joint* joint);
 	~RBDynJoint(void);
+
+	/**
+		returns the joint that is being enforced
+	*/
+	inline Joint* getJoint(){
+		return j;
+	}
+
+	/**
+		This method is used to prepare the constraint quantities (anchors, effective masses, P, the joint limits) for the step that
+		is about to be taken. erp is the fraction of the drift that is corrected in one step.
+	*/
+	void prepare(double erp, double dt);
+
+	/**
+		This method applies the impulses accumulated in the previous step, as a starting guess for this one.
+	*/
+	void warmStart();
+
+	/**
+		This method writes the impulses that are kept from one step to the next (RBDYN_WARM_START_SIZE values) to values.
+	*/
+	void getWarmStartImpulses(double* values);
+
+	/**
+		This method sets the impulses that are kept from one step to the next from values (RBDYN_WARM_START_SIZE of them).
+	*/
+	void setWarmStartImpulses(const double* values);
+
+	/**
+		This method does one sequential impulse pass over all the constraints of this joint.
+	*/
+	void solve();
+
+	/**
+		This method returns the inverse world inertia tensor of the body, multiplied by v.
+	*/
+	static Vector3d applyInverseInertia(RigidBody* rb, const Vector3d& v);
+
+	/**
+		This method computes the angles of the joint that are subject to joint limits, given the relative orientation qRel of the child
+		with respect to the parent. It returns the number of angles that were written to limits (at most RBDYN_MAX_ANGULAR_ROWS/2).
+	*/
+	static int getLimitedAngles(Joint* j, const Quaternion& qRel, RBDynLimitedAngle* limits);
 };
@@ -50,7 +50,8 @@ int getRBLineType(char* &buffer){
 		{"CDP_Box", RB_BOX},
 		{"planar", RB_PLANAR},
 		{"ODEGroundParameters", RB_ODE_GROUND_COEFFS},
-		{"softBody", RB_SOFT_BODY}
+		{"softBody", RB_SOFT_BODY},
+		{"CDP_HeightField", RB_HEIGHT_FIELD}
 	};
 
 	//declare a list of keywords
@@ -37,6 +37,7 @@
 #define RB_ODE_GROUND_COEFFS			35
 #define RB_PLANAR						36
 #define RB_SOFT_BODY					37
+#define RB_HEIGHT_FIELD					38
 
 /**
 	This method is used to determine the type of a line that was used in the input file for a rigid body.
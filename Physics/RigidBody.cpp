@@ -27,6 +27,7 @@
 #include "CapsuleCDP.h"
 #include "PlaneCDP.h"
 #include "BoxCDP.h"
+#include "HeightFieldCDP.h"
 #include "SphereCDP.h"
 
 #include <PUtils.h>
@@ -36,6 +37,8 @@
 */
 RigidBody::RigidBody(void){
 	name[0] = '\0';
+	id = -1;
+	contactCount = 0;
 //	toWorld.loadIdentity();
 }
 
@@ -132,6 +135,32 @@ uint RigidBody::renderToObjFile(FILE* fp, uint vertexIdxOffset) {
 //	toWorld.setTranslation(this->state.position);
 //}
 
+/**
+	This method associates an OBJ mesh with the rigid body. The mesh itself is loaded by the renderer
+*/
+void RigidBody::addMeshObj( char* objFilename, const Vector3d& offset, const Vector3d& scale ){
+	RBMesh mesh;
+	strncpy(mesh.fileName, objFilename, 199);
+	mesh.fileName[199] = '\0';
+	mesh.offset = offset;
+	mesh.scale = scale;
+	mesh.r = mesh.g = mesh.b = mesh.a = 1;
+	meshes.push_back(mesh);
+}
+
+/**
+	This method sets the colour of the last mesh loaded
+*/
+void RigidBody::setColour( double r, double g, double b, double a ){
+	if (meshes.size() == 0)
+		return;
+	RBMesh& mesh = meshes[meshes.size()-1];
+	mesh.r = r;
+	mesh.g = g;
+	mesh.b = b;
+	mesh.a = a;
+}
+
 /**
 	This method loads all the pertinent information regarding the rigid body from a file.
 */
@@ -158,6 +187,25 @@ void RigidBody::loadFromFile(FILE* f){
         case RB_NAME:
             sscanf(line, "%s", this->name);
             break;
+        case RB_MESH_NAME:{
+            //the name of the OBJ file, optionally followed by its offset, and then by its scale, in the coordinates of the body.
+            //The meshes are only used to draw the body, so a line that cannot be read is skipped rather than ending the body
+            Vector3d offset(0,0,0), scale(1,1,1);
+            int count = sscanf(line, "%s %lf %lf %lf %lf %lf %lf", meshName, &offset.x, &offset.y, &offset.z, &scale.x, &scale.y, &scale.z);
+            if (count!=1 && count!=4 && count!=7){
+                printf("Ignoring mesh line of %s: \'%s\'\n", this->name, line);
+                break;
+            }
+            addMeshObj(meshName, offset, scale);
+            break;
+        }
+        case RB_COLOUR:
+            if (sscanf(line, "%lf %lf %lf %lf", &r, &g, &b, &a)!=4){
+                printf("Ignoring colour line of %s: \'%s\'\n", this->name, line);
+                break;
+            }
+            setColour(r, g, b, a);
+            break;
         case RB_MASS:
             if (sscanf(line, "%lf", &t)!=1)
                 return;
@@ -193,6 +241,17 @@ void RigidBody::loadFromFile(FILE* f){
                 return;
             cdps.push_back(new PlaneCDP(n, p1, this));
             break;
+        case RB_HEIGHT_FIELD:{
+            //the name of the file with the heights, followed by the position of its first sample
+            char fieldName[200];
+            if (sscanf(line, "%s %lf %lf %lf", fieldName, &p1.x, &p1.y, &p1.z)!=4)
+                return;
+            HeightFieldData* field = HeightFieldData::getHeightField(fieldName);
+            if (field == NULL)
+                return;
+            cdps.push_back(new HeightFieldCDP(field, p1, this));
+            break;
+        }
         case RB_NOT_IMPORTANT:
             if (strlen(line)!=0 && line[0] != '#')
                 printf("Ignoring input line: \'%s\'\n", line);
@@ -31,6 +31,21 @@
 class Force;
 class ArticulatedFigure;
 
+/**
+	This class describes one of the meshes that are used to draw a rigid body. The physics never looks at the geometry, so only the name
+	of the OBJ file is kept here, along with how it is placed and coloured - loading it is left to whatever renders the rigid body.
+*/
+class RBMesh{
+public:
+	//the name of the OBJ file, as it is given in the .rbs file
+	char fileName[200];
+	//the mesh is scaled and then moved by the offset, both expressed in the local coordinates of the rigid body
+	Vector3d offset;
+	Vector3d scale;
+	//the colour of the mesh
+	double r, g, b, a;
+};
+
 
 //define some drawing flags:
 #define SHOW_MESH				0x0001
@@ -74,6 +89,9 @@ friend class MyContactReport;
 friend class BulletWorld;
 friend class VortexWorld;
 friend class AbstractRBEngine;
+friend class NativeWorld;
+friend class RBDynJoint;
+friend class ABAFigure;
 
 protected:
 	//--> the state of the rigid body: made up of the object's position in the world, its orientation and linear/angular velocities (stored in world coordinates)
@@ -89,9 +107,15 @@ protected:
 	DynamicArray<CollisionDetectionPrimitive*> cdps;
 	//--> the name of the rigid body - it might be used to reference the object for articulated bodies
 	char name[100];
+	//--> the meshes that are used to draw the rigid body, in the order they are listed in the .rbs file
+	DynamicArray<RBMesh> meshes;
 	//--> the id of the rigid body
 	int id;
 
+	//--> the net force that the contact points of the last step applied to this rigid body, and the number of those contact points. They are set by the world
+	Vector3d netContactForce;
+	int contactCount;
+
 	//--> this transformation matrix is used to transform points/vectors from local coordinates to global coordinates. It will be updated using the state
 	//information, and is therefore redundant, but it will be used to draw the object quickly. Everytime the state is updated, this matrix must also be updated!
 //	TransformationMatrix toWorld;
@@ -230,7 +254,8 @@ public:
 		This method sets the rigid body name
 	*/
 	void setName( char* name ) {
-		strncpy_s( this->name, name, 99 );
+		strncpy( this->name, name, 99 );
+		this->name[99] = '\0';
 	}
 
 	const char* getName() const {
@@ -238,7 +263,7 @@ public:
 	}
 
 	/**
-		This method loads an OBJ mesh and associates it with the rigid body
+		This method associates an OBJ mesh with the rigid body. The mesh itself is loaded by the renderer
 	*/
 	void addMeshObj( char* objFilename, const Vector3d& offset = Vector3d(0,0,0), const Vector3d& scale = Vector3d(1,1,1) );
 
@@ -247,6 +272,14 @@ public:
 	*/
 	void setColour( double r, double g, double b, double a );
 
+	int getMeshCount() const {
+		return meshes.size();
+	}
+
+	const RBMesh& getMesh(unsigned int index) const {
+		return meshes[index];
+	}
+
 	int getCDPCount() const {
 		return cdps.size();
 	}
@@ -348,6 +381,20 @@ public:
 	*/
 //	void updateToWorldTransformation();
 
+	/**
+		Returns the net force that the contact points of the last step applied to this rigid body
+	*/
+	inline const Vector3d& getNetContactForce(){
+		return netContactForce;
+	}
+
+	/**
+		Returns the number of contact points this rigid body was part of during the last step
+	*/
+	inline int getContactCount(){
+		return contactCount;
+	}
+
 	/**
 		this method sets the id of the current rigid body.
 	*/
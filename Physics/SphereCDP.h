@@ -18,6 +18,7 @@ class SphereCDP : public CollisionDetectionPrimitive{
 friend class CapsuleCDP;
 friend class PlaneCDP;
 friend class RigidBody;
+friend class HeightFieldCDP;
 public:
 	//keep track of the local-coordinates sphere used by this collision detection primitive
 	Sphere s;
@@ -35,7 +36,7 @@ public:
 	
 	virtual ~SphereCDP(void);
 
-	virtual char* save() { return "SphereCDP"; }
+	virtual const char* save() { return "SphereCDP"; }
 
 	virtual void updateToWorldPrimitive();
 
@@ -10,6 +10,8 @@ class UniversalJoint : public Joint{
 friend class ODEWorld;
 friend class PhysXWorld;
 friend class PhysX3World;
+friend class RBDynJoint;
+friend class ABAFigure;
 friend class BulletWorld;
 friend class VortexWorld;
 private:
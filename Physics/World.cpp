@@ -10,42 +10,45 @@
 #include <PUtils.h>
 #include <string>
 #include <fstream>
+#include <sstream>
 #include <iostream>
+#include <algorithm>
 #include "NullWorld.h"
+#include "PhysicsGlobals.h"
 
+#ifdef PhysX3
 #include "PhysX3World.h"
+#endif
+#include "NativeWorld.h"
 
-#pragma comment( linker, "/subsystem:\"windows\" /entry:\"mainCRTStartup\"" )
-
-// Singleton stuff
-World* World::_instance = NULL;
-void World::create() {
+/**
+	This method creates a new, independent world. The simulation engine is picked from ../controllerconfig.txt
+	(PhysX 3 if the file does not say otherwise, or the native engine when PhysX 3 is not compiled in). The world is
+	deterministic if the file asks for it or if PhysicsGlobals::deterministic is set. The caller owns the world that is returned.
+*/
+World* World::create() {
+	World* world = NULL;
 	bool test = false;
-	//World::testmode = false;
-	assert( _instance == NULL );
+	bool deterministic = PhysicsGlobals::deterministic;
 	
 	std::string line;
-	int engine;
-	std::ifstream myfile("..\\controllerconfig.txt");
+	std::ifstream myfile("../controllerconfig.txt");
 	if (myfile.is_open())
 	{
 		std::getline (myfile,line);
-		char *a=new char[line.size()+1];
-		memcpy(a,line.c_str(),line.size());
-		if(a[0] == 't'){
+		if(line.size() > 0 && line[0] == 't'){
 			test = true;
 		}
-		a[line.size()]=0;
 		std::getline (myfile,line);
-		a=new char[line.size()+1];
-		a[line.size()]=0;
-		memcpy(a,line.c_str(),line.size());
-		engine = atoi(a);
-		//delete [] a;
+		char a[3] = {0, 0, 0};
+		strncpy(a, line.c_str(), 2);
+		//the words after the name of the engine are options: 'd' asks for a deterministic simulation
+		if (hasEngineOption(line, "d") || hasEngineOption(line, "D"))
+			deterministic = true;
 		//printf("simulation engine : %c\n",a[0]);
 		if(a[0] == 'o' || a[0] == 'O' || a[0] == 'q' || a[0] == 'Q'){
 #ifdef ODE
-			_instance = new ODEWorld();
+			world = new ODEWorld();
 #else
 			printf("ODE needs to be defined in compileconfig.h before it is instantiated... exiting...\n");
 			exit(0);
@@ -57,11 +60,15 @@ void World::create() {
 			}*/
 		} else if(a[0] == 'p' || a[0] == 'P'){
 			if(a[1] == '3'){
-			_instance = new PhysX3World();
-
+#ifdef PhysX3
+			world = new PhysX3World(deterministic);
+#else
+			printf("PhysX3 is not defined in this build, using the native engine instead...\n");
+			world = new NativeWorld(false, deterministic);
+#endif
 			}else{
 #ifdef PhysX
-			_instance = new PhysXWorld();
+			world = new PhysXWorld();
 #else
 			printf("PhysX needs to be defined in compileconfig.h before it is instantiated... exiting...\n");
 			exit(0);
@@ -69,50 +76,94 @@ void World::create() {
 			}
 		} else if(a[0] == 'v' || a[0] == 'V'){
 #ifdef Vortex
-			_instance = new VortexWorld();
+			world = new VortexWorld();
 #else
 			printf("Vortex needs to be defined in compileconfig.h before it is instantiated... exiting...\n");
 			exit(0);
 #endif
 		} else if(a[0] == 'b' || a[0] == 'B'){
 #ifdef Bullet
-			_instance = new BulletWorld();
+			world = new BulletWorld();
 #else
 			printf("Bullet needs to be defined in compileconfig.h before it is instantiated... exiting...\n");
 			exit(0);
 #endif
+		} else if(a[0] == 'n' || a[0] == 'N'){
+			//'nr' simulates the articulated figures in reduced coordinates
+			world = new NativeWorld(a[1] == 'r' || a[1] == 'R', deterministic);
 		} else{
 			printf("Please specify a valid simulation engine\n");
 			printf("'o' for ODE (or 'oq' for ODE Quick)\n");
 			printf("'p' for PhysX\n");
 			printf("'b' for Bullet\n");
 			printf("'v' for Vortex\n");
+			printf("'n' for the native engine (or 'nr' for the native engine in reduced coordinates)\n");
+			printf("followed by 'd' for a deterministic simulation (e.g. 'p3 d')\n");
+			printf("and by 'profile' to time the simulation steps (e.g. 'p3 d profile')\n");
 			exit(0);
 		}
-		_instance->testmode = test;
-		_instance->testmode = false;
-		_instance->nperturb = 0;
 	}
 	myfile.close();
 
-	std::atexit( World::destroy );
+	if (world == NULL){
+#ifdef PhysX3
+		world = new PhysX3World(deterministic);
+#else
+		world = new NativeWorld(false, deterministic);
+#endif
+	}
+	world->testmode = test;
+	world->testmode = false;
+	world->nperturb = 0;
+	return world;
 }
 
-void World::destroy() {
-	assert( _instance != NULL );
-	delete _instance;
-}
 
 
+/**
+	This method returns true if the option is one of the words that follow the name of the engine on the engine line of
+	controllerconfig.txt.
+*/
+bool World::hasEngineOption(const std::string& engineLine, const char* option){
+	std::istringstream words(engineLine);
+	std::string word;
+	//the first word is the name of the engine
+	words >> word;
+	while (words >> word)
+		if (word == option)
+			return true;
+	return false;
+}
+
+/**
+	This method returns true if the option is one of the words that follow the name of the engine in ../controllerconfig.txt.
+	It is meant for the options that apply to the whole program, such as 'profile', which the applications read once when they start.
+*/
+bool World::isEngineOptionSet(const char* option){
+	std::string line;
+	std::ifstream myfile("../controllerconfig.txt");
+	if (!myfile.is_open())
+		return false;
+	//the engine is on the second line
+	std::getline(myfile, line);
+	std::getline(myfile, line);
+	return hasEngineOption(line, option);
+}
 
-World::World(void){
+World::World(bool deterministic){
+	this->deterministic = deterministic;
 	this->objects = DynamicArray<RigidBody*>(300);
 	this->objects.clear();
+	this->contactPoints = DynamicArray<ContactPoint>(MAX_CONTACT_POINTS);
+	this->contactPoints.clear();
+	this->bodiesInContact = DynamicArray<RigidBody*>(MAX_CONTACT_POINTS);
+	this->bodiesInContact.clear();
 
 	//for performance analysis
 	nbFrames = 0;
 	stepCounter = 0;
     testmode = false;
+	stepHash = 0;
 	//this->frame = DynamicArray<Vector3d>(20);
 	//this->frame.clear();
 }
@@ -143,6 +194,36 @@ void World::destroyWorld() {
 	jts.clear();
 
 	contactPoints.clear();
+	bodiesInContact.clear();
+}
+
+/**
+	This method adds up the contact forces acting on each rigid body, so that they can be queried directly from the bodies. The engines call it
+	once the contact points of a step are known.
+*/
+void World::indexContactPoints(){
+	//only the bodies that were in contact during the previous step need to be reset
+	for (uint i=0;i<bodiesInContact.size();i++){
+		bodiesInContact[i]->netContactForce = Vector3d(0,0,0);
+		bodiesInContact[i]->contactCount = 0;
+	}
+	bodiesInContact.clear();
+
+	//f is applied to rb1, and -f to rb2
+	for (uint i=0;i<contactPoints.size();i++){
+		RigidBody* rbs[2] = {contactPoints[i].rb1, contactPoints[i].rb2};
+		for (int j=0;j<2;j++){
+			if (rbs[j] == NULL)
+				continue;
+			if (rbs[j]->contactCount == 0)
+				bodiesInContact.push_back(rbs[j]);
+			rbs[j]->contactCount++;
+			if (j == 0)
+				rbs[j]->netContactForce += contactPoints[i].f;
+			else
+				rbs[j]->netContactForce -= contactPoints[i].f;
+		}
+	}
 }
 
 void World::destroyAllObjects() {
@@ -151,13 +232,14 @@ void World::destroyAllObjects() {
 
 
 /**
-	This method returns the reference to the first articulated rigid body with 
-	its name and its articulared figure name, or NULL if it is not found
+	This method returns the reference to the last articulated rigid body with 
+	its name and its articulared figure name, or NULL if it is not found. The bodies that were
+	added last are found first, so a file can be loaded several times, with each copy of a figure linking its own bodies
 */
 ArticulatedRigidBody* World::getARBByName(char* name, char* articulatedFigureName){
 	if (name == NULL)
 		return NULL;
-	for (uint i=0;i<ABs.size();i++)
+	for (int i=(int)ABs.size()-1;i>=0;i--)
 		if (strcmp(name, ABs[i]->name) == 0)
 			if( articulatedFigureName == NULL ||
 				strcmp( articulatedFigureName, ABs[i]->getAFParent()->getName() ) == 0 )
@@ -256,14 +338,12 @@ void World::addRigidBody(RigidBody* rigidBody){
 }
 
 
-int nchar = 0;
 /**
 	This method adds one rigid body (not articulated).
 */
 void World::addArticulatedFigure(ArticulatedFigure* articulatedFigure){
-	nchar++;
-	printf("Creating character %d\n",nchar);
-	articulatedFigure->loadIntoWorld();
+	printf("Creating character %d\n",(int)AFs.size()+1);
+	articulatedFigure->loadIntoWorld(this);
 	AFs.push_back(articulatedFigure);
 	articulatedFigure->addJointsToList(&jts);
 	articulatedFigure->fixJointConstraints();
@@ -311,6 +391,112 @@ void World::setState(DynamicArray<double>* state, int start){
 	}
 }
 
+/**
+	This method saves the state of the world, including the contact points and the data the engine keeps between steps, in the snapshot.
+*/
+void World::saveSnapshot(WorldSnapshot* snapshot){
+	//the arrays keep their storage from one snapshot to the next, so this is only a copy
+	snapshot->rbStates.resize(objects.size());
+	for (uint i=0;i<objects.size();i++)
+		snapshot->rbStates[i] = objects[i]->state;
+	snapshot->contactPoints.assign(contactPoints.begin(), contactPoints.end());
+	snapshot->engineState.clear();
+	snapshot->stepHash = stepHash;
+}
+
+/**
+	This method puts the world back in the state that was saved in the snapshot, so that the simulation continues exactly as it did from
+	that point on. Returns false if the snapshot does not match this world.
+*/
+bool World::restoreSnapshot(const WorldSnapshot& snapshot){
+	if (snapshot.rbStates.size() != objects.size()){
+		printf("Cannot restore a snapshot of %d bodies into a world with %d bodies\n", (int)snapshot.rbStates.size(), (int)objects.size());
+		return false;
+	}
+	for (uint i=0;i<objects.size();i++)
+		objects[i]->state = snapshot.rbStates[i];
+	contactPoints.assign(snapshot.contactPoints.begin(), snapshot.contactPoints.end());
+	indexContactPoints();
+	stepHash = snapshot.stepHash;
+	return true;
+}
+
+/**
+	this method adds the bits of the n values that are passed in to the hash h (64 bit FNV-1a)
+*/
+static unsigned long long hashDoubles(unsigned long long h, const double* values, int n){
+	const unsigned char* bytes = (const unsigned char*)values;
+	for (uint i=0;i<n * sizeof(double);i++){
+		h ^= bytes[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+/**
+	this method adds the state of the world to the hash h
+*/
+unsigned long long World::hashState(unsigned long long h){
+	for (uint i=0;i<objects.size();i++){
+		const RBState& s = objects[i]->state;
+		double values[13] = {s.position.x, s.position.y, s.position.z, s.orientation.s, s.orientation.v.x, s.orientation.v.y, s.orientation.v.z,
+			s.velocity.x, s.velocity.y, s.velocity.z, s.angularVelocity.x, s.angularVelocity.y, s.angularVelocity.z};
+		h = hashDoubles(h, values, 13);
+	}
+	for (uint i=0;i<contactPoints.size();i++){
+		const ContactPoint& c = contactPoints[i];
+		double values[6] = {c.cp.x, c.cp.y, c.cp.z, c.f.x, c.f.y, c.f.z};
+		h = hashDoubles(h, values, 6);
+	}
+	return h;
+}
+
+/**
+	This method returns a hash of the current state of the world: the state of every rigid body and the contact points, bit for bit.
+*/
+unsigned long long World::getStateHash(){
+	return hashState(14695981039346656037ULL);
+}
+
+/**
+	The engines call this method at the end of each step. In deterministic mode, it chains the hash of the new state of the world into
+	the step hash.
+*/
+void World::updateStepHash(){
+	if (!deterministic)
+		return;
+	if (stepHash == 0)
+		stepHash = 14695981039346656037ULL;
+	stepHash = hashState(stepHash);
+}
+
+/**
+	this method orders two contact points by the ids of their bodies, then by their position and then by their force, so that only contact
+	points that are exactly the same are ever left in the order the engine reported them
+*/
+bool World::contactPointComesFirst(const ContactPoint& a, const ContactPoint& b){
+	int a1 = (a.rb1 != NULL) ? a.rb1->id : -1, b1 = (b.rb1 != NULL) ? b.rb1->id : -1;
+	if (a1 != b1)
+		return a1 < b1;
+	int a2 = (a.rb2 != NULL) ? a.rb2->id : -1, b2 = (b.rb2 != NULL) ? b.rb2->id : -1;
+	if (a2 != b2)
+		return a2 < b2;
+	double va[6] = {a.cp.x, a.cp.y, a.cp.z, a.f.x, a.f.y, a.f.z};
+	double vb[6] = {b.cp.x, b.cp.y, b.cp.z, b.f.x, b.f.y, b.f.z};
+	for (int i=0;i<6;i++)
+		if (va[i] != vb[i])
+			return va[i] < vb[i];
+	return false;
+}
+
+/**
+	This method sorts the contact points by the ids of their bodies and by their position, so that they are always in the same order no
+	matter in which order the engine reported them.
+*/
+void World::sortContactPoints(){
+	std::sort(contactPoints.begin(), contactPoints.end(), contactPointComesFirst);
+}
+
 bool World::addStepCounter(){
 	stepCounter++;
 	if(stepCounter>=10 && stepCounter < 32)
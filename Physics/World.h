@@ -1,11 +1,30 @@
 #pragma once
 
 #include <PUtils.h>
+#include <string>
 
 #include "RigidBody.h"
 #include "ArticulatedRigidBody.h"
 #include "ArticulatedFigure.h"
 
+//the number of contact points the contact list has room for before it needs to grow
+#define MAX_CONTACT_POINTS 200
+
+/**
+	This structure holds the state of a world at one point in time: the state of each rigid body, the contact points of the last step, and the
+	data that the engine carries over from one step to the next. A snapshot refers to the bodies of the world it was taken from, so it can only
+	be restored into that same world. Once its arrays have grown to the size of the world, taking a snapshot again does not allocate any memory.
+*/
+typedef struct WorldSnapshot_struct{
+	//the state of objects[i] is in rbStates[i]
+	DynamicArray<RBState> rbStates;
+	DynamicArray<ContactPoint> contactPoints;
+	//whatever else the engine needs to carry on exactly where it left off, in a format that only that engine reads
+	DynamicArray<double> engineState;
+	//the hash of the steps taken so far, so that it goes on from the same value
+	unsigned long long stepHash;
+} WorldSnapshot;
+
 /*--------------------------------------------------------------------------------------------------------------------------------------------*
  * This class implements a container for rigid bodies (both stand alone and articulated). It reads a .rbs file and interprets it.             *
  *--------------------------------------------------------------------------------------------------------------------------------------------*/
@@ -13,11 +32,6 @@ class World{
 friend class RBSimulator;
 friend class ConCompositionFramework;
 
-private:
-	static World* _instance;
-	static void create();
-	static void destroy();
-
 protected:
 	//this is a list of all the objects in the world
 	DynamicArray<RigidBody*> objects;
@@ -29,32 +43,80 @@ protected:
 	//we'll keep a list of all the joints in the world as well, for quick access
 	DynamicArray<Joint*> jts;
 
-	//this is a list of all the contact points
+	//this is a list of all the contact points. Its storage is allocated once, and reused from one step to the next
 	DynamicArray<ContactPoint> contactPoints;
+	//the rigid bodies that are part of at least one of the contact points
+	DynamicArray<RigidBody*> bodiesInContact;
+
+	//when this is true, the world gives up some speed so that the same rollout always gives bit for bit the same result, and it keeps
+	//a hash of its state after every step so that two runs can be compared. It is fixed when the world is created
+	bool deterministic;
+
+	//in deterministic mode, this is the hash of the state of the world after each of the steps taken so far, chained one step into the next
+	unsigned long long stepHash;
 
 protected:
 	//the constructor
-	World(void);
-	//the destructor
-	virtual ~World(void);
+	World(bool deterministic = false);
 
 	// Destroy the world, it becomes unusable, but everything is clean
 	virtual void destroyWorld();
 
+	/**
+		This method adds up the contact forces acting on each rigid body, so that they can be queried directly from the bodies. The engines call it
+		once the contact points of a step are known.
+	*/
+	void indexContactPoints();
+
+	/**
+		This method sorts the contact points by the ids of their bodies and by their position, so that they are always in the same order no
+		matter in which order the engine reported them.
+	*/
+	void sortContactPoints();
+
+	/**
+		this method orders two contact points by the ids of their bodies, then by their position and then by their force
+	*/
+	static bool contactPointComesFirst(const ContactPoint& a, const ContactPoint& b);
+
+	/**
+		this method adds the state of the world to the hash h
+	*/
+	unsigned long long hashState(unsigned long long h);
+
+	/**
+		The engines call this method at the end of each step. In deterministic mode, it chains the hash of the new state of the world into
+		the step hash.
+	*/
+	void updateStepHash();
+
+	/**
+		This method returns true if the option is one of the words that follow the name of the engine on the engine line of
+		controllerconfig.txt.
+	*/
+	static bool hasEngineOption(const std::string& engineLine, const char* option);
+
 public:
-	float after1000;
-	float col1000;
-	float dynamics1000;
-	int countto1000;
+	//the destructor
+	virtual ~World(void);
+
+	/**
+		This method creates a new, independent world. The simulation engine is picked from ..\controllerconfig.txt
+		(PhysX 3 if the file does not say otherwise, or the native engine when PhysX 3 is not compiled in). The world is
+		deterministic if the file asks for it or if PhysicsGlobals::deterministic is set. The caller owns the world that is returned.
+	*/
+	static World* create();
+
+	/**
+		This method returns true if the option is one of the words that follow the name of the engine in ..\controllerconfig.txt.
+		It is meant for the options that apply to the whole program, such as 'profile', which the applications read once when they start.
+	*/
+	static bool isEngineOptionSet(const char* option);
+
 	bool testmode;
 	bool perturb;
 	int nperturb;
 
-	inline static World& instance() {
-		if( _instance == NULL ) create();	
-		return *_instance;
-	}
-
 	// Destroy all the objects, but the world is still usable
 	virtual void destroyAllObjects();
 
@@ -121,8 +183,9 @@ public:
 	virtual void addArticulatedFigure( ArticulatedFigure* articulatedFigure_disown );
 
 	/**
-		This method returns the reference to the first articulated rigid body with 
-		its name and its articulared figure name, or NULL if it is not found
+		This method returns the reference to the last articulated rigid body with 
+		its name and its articulared figure name, or NULL if it is not found. The bodies that were
+		added last are found first, so a file can be loaded several times, with each copy of a figure linking its own bodies
 	*/
 	ArticulatedRigidBody* getARBByName(char* name, char* articulatedFigureName = NULL);
 
@@ -147,6 +210,37 @@ public:
 	*/
 	void setState(DynamicArray<double>* state, int start = 0);
 
+	/**
+		This method saves the state of the world, including the contact points and the data the engine keeps between steps, in the snapshot.
+	*/
+	virtual void saveSnapshot(WorldSnapshot* snapshot);
+
+	/**
+		This method puts the world back in the state that was saved in the snapshot, so that the simulation continues exactly as it did from
+		that point on. Returns false if the snapshot does not match this world.
+	*/
+	virtual bool restoreSnapshot(const WorldSnapshot& snapshot);
+
+	/**
+		This method returns a hash of the current state of the world: the state of every rigid body and the contact points, bit for bit.
+	*/
+	unsigned long long getStateHash();
+
+	/**
+		This method returns the hash of all the steps taken so far. Two rollouts that start from the same state went exactly the same
+		way if they end with the same step hash. It is only computed in deterministic mode.
+	*/
+	inline unsigned long long getStepHash(){
+		return stepHash;
+	}
+
+	/**
+		This method returns true if the world simulates in deterministic mode.
+	*/
+	inline bool isDeterministic(){
+		return deterministic;
+	}
+
 	/**
 		This method returns the number of articulated figures in this collection.
 	*/
@@ -3,7 +3,7 @@
 */
 #pragma once
 
-#include <mathLib.h>
+#include <MathLib.h>
 #include <Sphere.h>
 #include <Plane.h>
 #include <Capsule.h>
@@ -122,6 +122,7 @@ inline int getContactPoints(Capsule* a, Capsule* b, DynamicArray<ContactPoint> *
 
 	Segment(a->p1, a->p2).getShortestSegmentTo(Segment(b->p1, b->p2), &s);
 	
-	return getContactPoints(&Sphere(s.a, a->radius), &Sphere(s.b, b->radius), cps);
+	Sphere sA(s.a, a->radius), sB(s.b, b->radius);
+	return getContactPoints(&sA, &sB, cps);
 }
 
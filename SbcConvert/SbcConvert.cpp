@@ -0,0 +1,87 @@
+// SbcConvert.cpp : converts SimBiCon controllers between the text .sbc format and the compiled .sbcb format.
+//
+// usage: SbcConvert <input.conF> <in> <out> [<in> <out>...]
+//
+// The controllers refer to the joints of a character by name, so the character is loaded from the input file first. Every input
+// controller is then loaded into a fresh copy of it, text or compiled, and written out in the format that the extension of the
+// output file asks for: .sbcb files are compiled, everything else is written as text.
+
+#include "stdafx.h"
+
+#include <SimBiConFramework.h>
+
+/**
+	returns true if the file name passed in as a parameter ends with the extension of the compiled controllers
+*/
+static bool isBinaryFileName(const char* fileName){
+	const char* extension = ".sbcb";
+	int length = (int)strlen(fileName);
+	int extensionLength = (int)strlen(extension);
+	return length >= extensionLength && strcmp(fileName + length - extensionLength, extension) == 0;
+}
+
+static void printUsage(){
+	printf("usage: SbcConvert <input.conF> <in> <out> [<in> <out>...]\n");
+	printf("\tinput.conF\tthe file that loads the character the controllers are written for\n");
+	printf("\tin\t\ta controller, either text (.sbc) or compiled (.sbcb)\n");
+	printf("\tout\t\tthe converted controller - it is compiled if its name ends in .sbcb, and written as text otherwise\n");
+}
+
+/**
+	This method converts one controller. It returns false if it could not be loaded or written.
+*/
+static bool convert(char* inputFile, char* inFile, char* outFile){
+	FILE* test = fopen(inFile, "r");
+	if (test == NULL){
+		printf("Cannot open controller file %s\n", inFile);
+		return false;
+	}
+	fclose(test);
+
+	//the states of a controller are added to the ones that are already loaded, so every controller gets a new framework
+	SimBiConFramework* conF = new SimBiConFramework(inputFile, inFile);
+	SimBiController* con = conF->getController();
+	if (con == NULL || conF->getCharacter() == NULL){
+		printf("The input file %s did not load a character and a controller.\n", inputFile);
+		delete conF;
+		return false;
+	}
+	if (con->getStateCount() == 0){
+		printf("The controller %s has no states.\n", inFile);
+		delete conF;
+		return false;
+	}
+
+	bool written = true;
+	if (isBinaryFileName(outFile))
+		written = con->writeToBinaryFile(outFile);
+	else
+		con->writeControllers(outFile);
+	if (written)
+		printf("%s -> %s (%d states)\n", inFile, outFile, con->getStateCount());
+
+	delete conF;
+	return written;
+}
+
+int main(int argc, char** argv){
+	if (argc < 4 || (argc - 2) % 2 != 0){
+		printUsage();
+		return 1;
+	}
+
+	//the framework does not check this, so make sure the file is there before loading anything
+	FILE* test = fopen(argv[1], "r");
+	if (test == NULL){
+		printf("Cannot open input file %s\n", argv[1]);
+		return 1;
+	}
+	fclose(test);
+
+	int failures = 0;
+	for (int i=2;i+1<argc;i+=2)
+		if (!convert(argv[1], argv[i], argv[i+1]))
+			failures++;
+
+	return (failures > 0) ? 2 : 0;
+}
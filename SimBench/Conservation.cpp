@@ -0,0 +1,227 @@
+// Conservation.cpp : the physics check of SimBench. It answers the question "does a figure simulated in reduced coordinates move the way a
+// passive mechanism has to".
+//
+// Every shipped character is loaded on its own into a native world with reduced coordinates: no ground, no controller and no joint limits.
+// It is then thrown upwards, with all of its links spinning. Nothing but gravity acts on it from then on, so its total energy, its momentum
+// (once what gravity adds is taken out) and its angular momentum about its center of mass have to stay what they were. Any error in the
+// articulated body algorithm - a missing velocity product term, a wrong inertia transform - shows up as a drift in one of them.
+//
+// The native engine with maximal coordinates is not checked: its joints are solved approximately by sequential impulses, and it leaves out
+// the gyroscopic torques, so it does not conserve any of these exactly.
+
+#include "stdafx.h"
+
+#include "SimBench.h"
+#include <NativeWorld.h>
+#include <PhysicsGlobals.h>
+#include <SimGlobals.h>
+#include <math.h>
+
+/**
+	A character, and the file its articulated figure is loaded from.
+*/
+typedef struct {
+	const char* name;
+	const char* rbsFile;
+} ConservationConfig;
+
+static const ConservationConfig configs[] = {
+	{"bipV2", "../Data/characters/bipV2.rbs"},
+	{"bigBird", "../Data/characters/bigBird.rbs"},
+	{"raptor", "../Data/characters/raptor.rbs"},
+	{"bip2D", "../Data/characters/bip2D.rbs"}
+};
+
+static const int configCount = sizeof(configs) / sizeof(configs[0]);
+
+//the largest drifts that pass, in percent. The figures are integrated with semi-implicit Euler, so the drifts are not zero but halve with the
+//time step: at dt = 0.0005 they stay under 1%. Leaving out the gyroscopic torques drives the angular momentum off by 5% or more
+#define ENERGY_TOLERANCE 2.0
+#define MOMENTUM_TOLERANCE 0.5
+#define ANGULAR_MOMENTUM_TOLERANCE 2.0
+
+/**
+	The quantities a passive figure conserves, summed over its links.
+*/
+typedef struct {
+	double mass;
+	//the kinetic energy, and the kinetic plus the potential energy
+	double kineticEnergy;
+	double energy;
+	Vector3d momentum;
+	//about the center of mass of the figure
+	Vector3d angularMomentum;
+} ConservedQuantities;
+
+/**
+	returns the angular momentum of the rigid body about its own center of mass, in world coordinates
+*/
+static Vector3d getSpinMomentum(RigidBody* rb){
+	Quaternion q = rb->getOrientation();
+	Vector3d w = q.inverseRotate(rb->getAngularVelocity());
+	Vector3d moi = rb->getPMI();
+	return q.rotate(Vector3d(w.x * moi.x, w.y * moi.y, w.z * moi.z));
+}
+
+/**
+	This method measures the conserved quantities of the figure whose links are passed in.
+*/
+static void measure(DynamicArray<ArticulatedRigidBody*>* links, ConservedQuantities* r){
+	r->mass = 0;
+	r->kineticEnergy = 0;
+	r->energy = 0;
+	r->momentum = Vector3d(0,0,0);
+	Vector3d com(0,0,0);
+	for (uint i=0;i<links->size();i++){
+		RigidBody* rb = (*links)[i];
+		double m = rb->getMass();
+		Vector3d v = rb->getCMVelocity();
+		Vector3d x = Vector3d(Point3d(0,0,0), rb->getCMPosition());
+		r->mass += m;
+		r->kineticEnergy += 0.5 * m * v.dotProductWith(v) + 0.5 * rb->getAngularVelocity().dotProductWith(getSpinMomentum(rb));
+		//gravity is negative, so the potential energy grows with the height
+		r->energy -= m * PhysicsGlobals::gravity * x.dotProductWith(PhysicsGlobals::up);
+		r->momentum += v * m;
+		com += x * m;
+	}
+	r->energy += r->kineticEnergy;
+	com /= r->mass;
+
+	r->angularMomentum = Vector3d(0,0,0);
+	for (uint i=0;i<links->size();i++){
+		RigidBody* rb = (*links)[i];
+		Vector3d x = Vector3d(Point3d(0,0,0), rb->getCMPosition()) - com;
+		r->angularMomentum += x.crossProductWith(rb->getCMVelocity() * rb->getMass()) + getSpinMomentum(rb);
+	}
+}
+
+/**
+	How far the conserved quantities of one character drifted, at worst, in percent.
+*/
+typedef struct {
+	double energyDrift;
+	double momentumDrift;
+	double angularMomentumDrift;
+} ConservationResult;
+
+/**
+	This method throws the character of the configuration and measures the drifts. It returns false if the character could not be loaded.
+*/
+static bool runConfig(const ConservationConfig* config, double simTime, ConservationResult* result){
+	NativeWorld* world = new NativeWorld(true);
+	world->loadRBsFromFile((char*)config->rbsFile);
+	if (world->getAFCount() == 0){
+		delete world;
+		return false;
+	}
+
+	//the links are collected from the joint tree, breadth first. The joint limits take energy out of the figure, as they should, so they
+	//are turned off
+	ArticulatedFigure* af = world->getAF(0);
+	DynamicArray<ArticulatedRigidBody*> links;
+	links.push_back(af->getRoot());
+	for (uint i=0;i<links.size();i++){
+		for (int k=0;k<links[i]->getChildJointCount();k++){
+			links[i]->getChildJoint(k)->setUseJointLimits(false);
+			links.push_back(links[i]->getChildJoint(k)->getChild());
+		}
+	}
+
+	//every link spins differently, and the whole figure goes up. The linear velocities of the links are made to agree with the joints by
+	//the first step, so the quantities are measured from there on
+	for (uint i=0;i<links.size();i++)
+		links[i]->setAngularVelocity(Vector3d(sin(i + 1.0), cos(2.0 * i + 1), sin(3.0 * i + 2)) * 2);
+	af->getRoot()->setCMVelocity(Vector3d(0.5, 3, -0.3));
+	world->advanceInTime(SimGlobals::dt);
+
+	ConservedQuantities start, now;
+	measure(&links, &start);
+	//the scales the drifts are relative to: the momentum of the whole mass moving with the starting kinetic energy, and the starting
+	//angular momentum
+	double momentumScale = sqrt(2 * start.mass * start.kineticEnergy);
+	double angularMomentumScale = start.angularMomentum.length();
+
+	result->energyDrift = result->momentumDrift = result->angularMomentumDrift = 0;
+	int nSteps = (int)(simTime / SimGlobals::dt + 0.5);
+	for (int i=1;i<=nSteps;i++){
+		world->advanceInTime(SimGlobals::dt);
+		measure(&links, &now);
+		Vector3d gravityImpulse = PhysicsGlobals::up * (PhysicsGlobals::gravity * start.mass * i * SimGlobals::dt);
+		double energyDrift = 100 * fabs(now.energy - start.energy) / start.kineticEnergy;
+		double momentumDrift = 100 * (now.momentum - start.momentum - gravityImpulse).length() / momentumScale;
+		double angularMomentumDrift = 100 * (now.angularMomentum - start.angularMomentum).length() / angularMomentumScale;
+		if (energyDrift > result->energyDrift)
+			result->energyDrift = energyDrift;
+		if (momentumDrift > result->momentumDrift)
+			result->momentumDrift = momentumDrift;
+		if (angularMomentumDrift > result->angularMomentumDrift)
+			result->angularMomentumDrift = angularMomentumDrift;
+	}
+
+	delete world;
+	return true;
+}
+
+static void printConservationUsage(){
+	printf("usage: SimBench -conservation [-t seconds] [-config name]\n");
+	printf("\t-t\t\tsimulated time of every run, in seconds (default 2)\n");
+	printf("\t-config\t\tonly check this character (bipV2, bigBird, raptor or bip2D)\n");
+	printf("The drifts are the largest ones over the run, relative to the starting kinetic energy, momentum and angular momentum.\n");
+}
+
+int runConservationCheck(int argc, char** argv){
+	double simTime = 2;
+	char* configName = NULL;
+
+	for (int i=1;i<argc;i++){
+		bool hasValue = (i+1 < argc);
+		if (strcmp(argv[i], "-t") == 0 && hasValue)
+			simTime = atof(argv[++i]);
+		else if (strcmp(argv[i], "-config") == 0 && hasValue)
+			configName = argv[++i];
+		else{
+			printf("Unknown or incomplete argument: %s\n", argv[i]);
+			printConservationUsage();
+			return 1;
+		}
+	}
+	if (simTime <= 0){
+		printf("The simulated time needs to be positive.\n");
+		return 1;
+	}
+
+	printf("%.1f s of free flight in reduced coordinates at dt = %g, no joint limits\n", simTime, SimGlobals::dt);
+	printf("%-8s %10s %10s %10s %6s\n", "config", "energy", "momentum", "ang. mom.", "");
+	int failures = 0;
+	bool ranAny = false;
+	for (int c=0;c<configCount;c++){
+		if (configName != NULL && strcmp(configs[c].name, configName) != 0)
+			continue;
+		ranAny = true;
+
+		FILE* test = fopen(configs[c].rbsFile, "r");
+		if (test == NULL){
+			printf("Cannot open input file %s\n", configs[c].rbsFile);
+			failures++;
+			continue;
+		}
+		fclose(test);
+
+		ConservationResult r;
+		if (!runConfig(&configs[c], simTime, &r)){
+			printf("The input file %s did not load an articulated figure.\n", configs[c].rbsFile);
+			failures++;
+			continue;
+		}
+		bool passed = r.energyDrift <= ENERGY_TOLERANCE && r.momentumDrift <= MOMENTUM_TOLERANCE && r.angularMomentumDrift <= ANGULAR_MOMENTUM_TOLERANCE;
+		printf("%-8s %9.4f%% %9.4f%% %9.4f%% %6s\n", configs[c].name, r.energyDrift, r.momentumDrift, r.angularMomentumDrift, passed ? "" : "FAILED");
+		if (!passed)
+			failures++;
+	}
+
+	if (!ranAny){
+		printf("There is no character called %s.\n", configName);
+		return 1;
+	}
+	return (failures > 0) ? 2 : 0;
+}
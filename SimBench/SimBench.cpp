@@ -0,0 +1,598 @@
+// SimBench.cpp : times the inner loops of the control and of the physics, without a window or an OpenGL context.
+//
+// usage: SimBench [input.conF] [-filter text] [-time seconds] [-o results.txt] [-baseline results.txt] [-tolerance percent]
+//        SimBench -throughput [-t seconds] [-workers n] [-config name] [-o results.txt]
+//        SimBench -conservation [-t seconds] [-config name]
+//
+// Every benchmark runs an operation over and over, on inputs that are generated from a fixed seed, and reports the time and the
+// number of heap allocations that one operation takes. The results can be saved, and compared to the ones of an earlier run.
+// A whole simulation step is timed last, and it fails whenever it allocates: once the simulation is running, it should not touch the heap.
+//
+// With -throughput, the whole simulation is timed instead - see Throughput.cpp. With -conservation, nothing is timed: the figures simulated
+// in reduced coordinates are checked for the energy and the momenta they have to conserve - see Conservation.cpp.
+
+#include "stdafx.h"
+
+#include "SimBench.h"
+#include <SimBiConFramework.h>
+#include <PoseController.h>
+//GenericTrajectory comes with the controller, from Simbicon/Trajectory.h
+#include <collisionLibrary.h>
+#include <Profiler.h>
+#include <new>
+#include <algorithm>
+#include <atomic>
+
+/**
+	Every heap allocation of the program goes through these, so the benchmarks can count the allocations of the code they time. The
+	end-to-end benchmark allocates from several threads at once, hence the atomic counter. All the replaceable forms are defined, so that
+	no allocation bypasses the counter and no block is freed by a different allocator than the one that made it.
+*/
+static std::atomic<long long> allocationCount(0);
+
+long long getAllocationCount(){
+	return allocationCount;
+}
+
+/**
+	counts the allocation and returns a block of the given size, or NULL if there is no memory left
+*/
+static void* countedAlloc(size_t size){
+	allocationCount++;
+	return malloc(size ? size : 1);
+}
+
+void* operator new(size_t size){
+	void* p = countedAlloc(size);
+	if (p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size){
+	void* p = countedAlloc(size);
+	if (p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) throw(){
+	return countedAlloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) throw(){
+	return countedAlloc(size);
+}
+
+void operator delete(void* p) throw(){
+	free(p);
+}
+
+void operator delete[](void* p) throw(){
+	free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) throw(){
+	free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) throw(){
+	free(p);
+}
+
+//the sized forms are only called by C++14 compilers, older ones never use them
+void operator delete(void* p, size_t) throw(){
+	free(p);
+}
+
+void operator delete[](void* p, size_t) throw(){
+	free(p);
+}
+
+/**
+	The results of the benchmarks are added to this, so that the compiler cannot optimize the timed code away.
+*/
+static volatile double sink = 0;
+
+/**
+	A small random number generator, so that the inputs are the same on every platform and in every run.
+*/
+class BenchRandom{
+private:
+	unsigned int state;
+public:
+	BenchRandom(unsigned int seed){
+		state = seed;
+	}
+
+	/**
+		returns a number between min and max
+	*/
+	double next(double min = 0, double max = 1){
+		state = state * 1664525u + 1013904223u;
+		return min + (max - min) * ((state >> 8) / 16777216.0);
+	}
+
+	Vector3d nextVector(double range){
+		double x = next(-range, range);
+		double y = next(-range, range);
+		return Vector3d(x, y, next(-range, range));
+	}
+
+	Quaternion nextQuaternion(){
+		Vector3d axis = nextVector(1);
+		if (axis.length() < 1e-6)
+			axis = Vector3d(0, 1, 0);
+		axis.toUnit();
+		return Quaternion::getRotationQuaternion(next(-PI, PI), axis);
+	}
+};
+
+//the number of inputs each benchmark cycles through
+#define BENCH_INPUT_COUNT 1024
+
+/**
+	This is the base class of all the benchmarks. run performs the operation that is being timed a given number of times.
+*/
+class Benchmark{
+public:
+	virtual ~Benchmark(void){}
+	virtual const char* getName() = 0;
+	virtual void run(int iterations) = 0;
+	/**
+		returns true if the operation must never allocate, no matter what the baseline says
+	*/
+	virtual bool mustNotAllocate(){ return false; }
+};
+
+class CatmullRomBenchmark : public Benchmark{
+private:
+	GenericTrajectory<double> trajectory;
+	double t[BENCH_INPUT_COUNT];
+public:
+	CatmullRomBenchmark(){
+		BenchRandom r(1);
+		//the trajectories of the controllers have a handful of knots over a phase that goes from 0 to 1
+		for (int i=0;i<=10;i++)
+			trajectory.addKnot(i / 10.0, r.next(-1, 1));
+		for (int i=0;i<BENCH_INPUT_COUNT;i++)
+			t[i] = r.next(-0.05, 1.05);
+	}
+	virtual const char* getName(){ return "GenericTrajectory::evaluate_catmull_rom"; }
+	virtual void run(int iterations){
+		double sum = 0;
+		for (int i=0;i<iterations;i++)
+			sum += trajectory.evaluate_catmull_rom(t[i % BENCH_INPUT_COUNT]);
+		sink += sum;
+	}
+};
+
+class PDTorqueBenchmark : public Benchmark{
+private:
+	Quaternion qRel[BENCH_INPUT_COUNT], qRelD[BENCH_INPUT_COUNT];
+	Vector3d wRel[BENCH_INPUT_COUNT], wRelD[BENCH_INPUT_COUNT];
+	ControlParams params;
+public:
+	PDTorqueBenchmark(){
+		BenchRandom r(2);
+		for (int i=0;i<BENCH_INPUT_COUNT;i++){
+			qRel[i] = r.nextQuaternion();
+			qRelD[i] = r.nextQuaternion();
+			wRel[i] = r.nextVector(5);
+			wRelD[i] = r.nextVector(1);
+		}
+		params.controlled = true;
+		params.kp = 300;
+		params.kd = 30;
+		params.maxAbsTorque = 200;
+		params.scale = Vector3d(1, 1, 1);
+	}
+	virtual const char* getName(){ return "PoseController::computePDTorque"; }
+	virtual void run(int iterations){
+		double sum = 0;
+		for (int i=0;i<iterations;i++){
+			int k = i % BENCH_INPUT_COUNT;
+			sum += PoseController::computePDTorque(qRel[k], qRelD[k], wRel[k], wRelD[k], &params).x;
+		}
+		sink += sum;
+	}
+};
+
+class QuaternionRotateBenchmark : public Benchmark{
+private:
+	Quaternion q[BENCH_INPUT_COUNT];
+	Vector3d v[BENCH_INPUT_COUNT];
+public:
+	QuaternionRotateBenchmark(){
+		BenchRandom r(3);
+		for (int i=0;i<BENCH_INPUT_COUNT;i++){
+			q[i] = r.nextQuaternion();
+			v[i] = r.nextVector(1);
+		}
+	}
+	virtual const char* getName(){ return "Quaternion::rotate"; }
+	virtual void run(int iterations){
+		double sum = 0;
+		for (int i=0;i<iterations;i++){
+			int k = i % BENCH_INPUT_COUNT;
+			sum += q[k].rotate(v[k]).y;
+		}
+		sink += sum;
+	}
+};
+
+class QuaternionMultiplyBenchmark : public Benchmark{
+private:
+	Quaternion q[BENCH_INPUT_COUNT];
+public:
+	QuaternionMultiplyBenchmark(){
+		BenchRandom r(4);
+		for (int i=0;i<BENCH_INPUT_COUNT;i++)
+			q[i] = r.nextQuaternion();
+	}
+	virtual const char* getName(){ return "Quaternion::operator*"; }
+	virtual void run(int iterations){
+		double sum = 0;
+		for (int i=0;i<iterations;i++){
+			int k = i % BENCH_INPUT_COUNT;
+			sum += (q[k] * q[(k + 1) % BENCH_INPUT_COUNT]).s;
+		}
+		sink += sum;
+	}
+};
+
+/**
+	The contact routines are timed on pairs that are close enough that about half of them touch.
+*/
+class ContactBenchmark : public Benchmark{
+private:
+	int pairType;
+	Sphere spheres[BENCH_INPUT_COUNT];
+	Capsule capsules[BENCH_INPUT_COUNT];
+	Capsule otherCapsules[BENCH_INPUT_COUNT];
+	Plane ground;
+	DynamicArray<ContactPoint> cps;
+public:
+	enum {SPHERE_PLANE, CAPSULE_PLANE, SPHERE_CAPSULE, CAPSULE_CAPSULE};
+
+	ContactBenchmark(int pairType){
+		this->pairType = pairType;
+		BenchRandom r(5 + pairType);
+		ground = Plane(Point3d(0, 0, 0), Vector3d(0, 1, 0));
+		for (int i=0;i<BENCH_INPUT_COUNT;i++){
+			spheres[i] = Sphere(Point3d(r.next(-0.1, 0.1), r.next(-0.05, 0.15), r.next(-0.1, 0.1)), 0.05);
+			capsules[i] = Capsule(Point3d(r.next(-0.1, 0.1), r.next(-0.05, 0.15), r.next(-0.1, 0.1)),
+				Point3d(r.next(-0.1, 0.1), r.next(-0.05, 0.15), r.next(-0.1, 0.1)), 0.05);
+			otherCapsules[i] = Capsule(Point3d(r.next(-0.1, 0.1), r.next(-0.05, 0.15), r.next(-0.1, 0.1)),
+				Point3d(r.next(-0.1, 0.1), r.next(-0.05, 0.15), r.next(-0.1, 0.1)), 0.05);
+		}
+		cps.reserve(16);
+	}
+	virtual const char* getName(){
+		switch (pairType){
+			case SPHERE_PLANE: return "getContactPoints(Sphere, Plane)";
+			case CAPSULE_PLANE: return "getContactPoints(Capsule, Plane)";
+			case SPHERE_CAPSULE: return "getContactPoints(Sphere, Capsule)";
+			default: return "getContactPoints(Capsule, Capsule)";
+		}
+	}
+	virtual void run(int iterations){
+		int n = 0;
+		for (int i=0;i<iterations;i++){
+			int k = i % BENCH_INPUT_COUNT;
+			cps.clear();
+			switch (pairType){
+				case SPHERE_PLANE: n += getContactPoints(&spheres[k], &ground, &cps); break;
+				case CAPSULE_PLANE: n += getContactPoints(&capsules[k], &ground, &cps); break;
+				case SPHERE_CAPSULE: n += getContactPoints(&spheres[k], &capsules[k], &cps); break;
+				default: n += getContactPoints(&capsules[k], &otherCapsules[k], &cps); break;
+			}
+		}
+		sink += n;
+	}
+};
+
+/**
+	The benchmarks below work on the character of the input file, after it has walked for a second, so that the controller is in the
+	middle of a step and the feet are on the ground.
+*/
+class CharacterGetStateBenchmark : public Benchmark{
+private:
+	Character* ch;
+	DynamicArray<double> state;
+public:
+	CharacterGetStateBenchmark(Character* ch){ this->ch = ch; }
+	virtual const char* getName(){ return "Character::getState"; }
+	virtual void run(int iterations){
+		for (int i=0;i<iterations;i++){
+			state.clear();
+			ch->getState(&state);
+		}
+		sink += state[0];
+	}
+};
+
+class CharacterSetStateBenchmark : public Benchmark{
+private:
+	Character* ch;
+	DynamicArray<double> state;
+public:
+	CharacterSetStateBenchmark(Character* ch){
+		this->ch = ch;
+		ch->getState(&state);
+	}
+	virtual const char* getName(){ return "Character::setState"; }
+	virtual void run(int iterations){
+		for (int i=0;i<iterations;i++)
+			ch->setState(&state);
+		sink += state[0];
+	}
+};
+
+class WorldGetStateBenchmark : public Benchmark{
+private:
+	World* world;
+	DynamicArray<double> state;
+public:
+	WorldGetStateBenchmark(World* world){ this->world = world; }
+	virtual const char* getName(){ return "World::getState"; }
+	virtual void run(int iterations){
+		for (int i=0;i<iterations;i++){
+			state.clear();
+			world->getState(&state);
+		}
+		sink += state[0];
+	}
+};
+
+class ComputeTorquesBenchmark : public Benchmark{
+private:
+	SimBiConFramework* conF;
+public:
+	ComputeTorquesBenchmark(SimBiConFramework* conF){ this->conF = conF; }
+	virtual const char* getName(){ return "SimBiController::computeTorques"; }
+	virtual void run(int iterations){
+		SimBiController* con = conF->getController();
+		DynamicArray<ContactPoint>* cfs = conF->getWorld()->getContactForces();
+		//the torques are written to the joints, so there is nothing for the compiler to drop here
+		for (int i=0;i<iterations;i++)
+			con->computeTorques(cfs);
+	}
+};
+
+/**
+	A whole simulation step - control and physics. Once the simulation is running, a step is not allowed to allocate anything: the buffers
+	it works in are all sized up front, and allocations show up as jitter in the runs that have to keep up with real time.
+*/
+class SimulationStepBenchmark : public Benchmark{
+private:
+	SimBiConFramework* conF;
+public:
+	SimulationStepBenchmark(SimBiConFramework* conF){ this->conF = conF; }
+	virtual const char* getName(){ return "SimBiConFramework::advanceInTime"; }
+	virtual void run(int iterations){
+		for (int i=0;i<iterations;i++)
+			conF->advanceInTime(SimGlobals::dt);
+	}
+	virtual bool mustNotAllocate(){ return true; }
+};
+
+/**
+	The time and the allocations of one operation of a benchmark.
+*/
+typedef struct {
+	char name[100];
+	double nsPerOp;
+	double allocationsPerOp;
+	long long iterations;
+} BenchResult;
+
+/**
+	This method times a benchmark. The number of iterations is grown until one run takes at least a tenth of the time budget, and then
+	the budget is spent on runs of that size. The fastest run is reported, since the noise of the machine only ever makes runs slower.
+*/
+static BenchResult runBenchmark(Benchmark* b, double timeBudget){
+	BenchResult result;
+	strncpy(result.name, b->getName(), 99);
+	result.name[99] = '\0';
+	double ticksPerSecond = (double)Profiler::getTicksPerSecond();
+
+	//a first run, to warm up the caches and to get everything that is allocated lazily out of the way
+	b->run(1);
+
+	int iterations = 1;
+	double runTime = 0;
+	while (true){
+		long long start = Profiler::getTicks();
+		b->run(iterations);
+		runTime = (Profiler::getTicks() - start) / ticksPerSecond;
+		if (runTime >= timeBudget / 10 || iterations >= (1 << 28))
+			break;
+		iterations *= (runTime < timeBudget / 1000) ? 10 : 2;
+	}
+
+	int runs = std::max(3, (int)(timeBudget / std::max(runTime, 1e-9)));
+	double best = 1e30;
+	long long allocations = 0;
+	for (int i=0;i<runs;i++){
+		long long allocationsBefore = allocationCount;
+		long long start = Profiler::getTicks();
+		b->run(iterations);
+		double t = (Profiler::getTicks() - start) / ticksPerSecond;
+		allocations += allocationCount - allocationsBefore;
+		best = std::min(best, t);
+	}
+
+	result.nsPerOp = best * 1e9 / iterations;
+	result.allocationsPerOp = (double)allocations / ((double)iterations * runs);
+	result.iterations = (long long)iterations * runs;
+	return result;
+}
+
+/**
+	This method reads results that were saved by an earlier run. Returns false if the file cannot be read.
+*/
+static bool loadResults(const char* fileName, DynamicArray<BenchResult>* results){
+	FILE* f = fopen(fileName, "r");
+	if (f == NULL){
+		printf("Cannot open the baseline %s\n", fileName);
+		return false;
+	}
+	char line[300];
+	while (fgets(line, 300, f) != NULL){
+		if (line[0] == '#')
+			continue;
+		//the name is everything before the tab
+		char* tab = strchr(line, '\t');
+		if (tab == NULL)
+			continue;
+		*tab = '\0';
+		BenchResult r;
+		strncpy(r.name, line, 99);
+		r.name[99] = '\0';
+		if (sscanf(tab + 1, "%lf %lf %lld", &r.nsPerOp, &r.allocationsPerOp, &r.iterations) == 3)
+			results->push_back(r);
+	}
+	fclose(f);
+	return true;
+}
+
+static void printUsage(){
+	printf("usage: SimBench [input.conF] [-filter text] [-time seconds] [-o results.txt] [-baseline results.txt] [-tolerance percent]\n");
+	printf("\tinput.conF\tthe character and controller the whole-character benchmarks use (default ../Data/init/input.conF)\n");
+	printf("\t-filter\t\tonly run the benchmarks whose name contains the text\n");
+	printf("\t-time\t\ttime spent on each benchmark, in seconds (default 1)\n");
+	printf("\t-o\t\tsave the results to a file\n");
+	printf("\t-baseline\tcompare the results to the ones saved in the file, and fail if one got slower or allocates more\n");
+	printf("\t-tolerance\thow much slower than the baseline a benchmark can be, in percent (default 10)\n");
+	printf("   or: SimBench -throughput [-t seconds] [-workers n] [-config name] [-o results.txt]\n");
+	printf("\t\t\ttimes whole simulations of every shipped character, see SimBench -throughput -help\n");
+	printf("   or: SimBench -conservation [-t seconds] [-config name]\n");
+	printf("\t\t\tchecks that the characters conserve energy and momentum in reduced coordinates, see SimBench -conservation -help\n");
+}
+
+int main(int argc, char** argv){
+	if (argc > 1 && strcmp(argv[1], "-throughput") == 0)
+		return runThroughputBenchmark(argc - 1, argv + 1);
+	if (argc > 1 && strcmp(argv[1], "-conservation") == 0)
+		return runConservationCheck(argc - 1, argv + 1);
+
+	char* inputFile = (char*)"../Data/init/input.conF";
+	char* filter = NULL;
+	char* outputFile = NULL;
+	char* baselineFile = NULL;
+	double timeBudget = 1;
+	double tolerance = 10;
+
+	for (int i=1;i<argc;i++){
+		bool hasValue = (i+1 < argc);
+		if (strcmp(argv[i], "-filter") == 0 && hasValue)
+			filter = argv[++i];
+		else if (strcmp(argv[i], "-time") == 0 && hasValue)
+			timeBudget = atof(argv[++i]);
+		else if (strcmp(argv[i], "-o") == 0 && hasValue)
+			outputFile = argv[++i];
+		else if (strcmp(argv[i], "-baseline") == 0 && hasValue)
+			baselineFile = argv[++i];
+		else if (strcmp(argv[i], "-tolerance") == 0 && hasValue)
+			tolerance = atof(argv[++i]);
+		else if (argv[i][0] != '-')
+			inputFile = argv[i];
+		else{
+			printf("Unknown or incomplete argument: %s\n", argv[i]);
+			printUsage();
+			return 1;
+		}
+	}
+	if (timeBudget <= 0){
+		printf("The time spent on each benchmark needs to be positive.\n");
+		return 1;
+	}
+
+	DynamicArray<BenchResult> baseline;
+	if (baselineFile != NULL && !loadResults(baselineFile, &baseline))
+		return 1;
+
+	FILE* test = fopen(inputFile, "r");
+	if (test == NULL){
+		printf("Cannot open input file %s\n", inputFile);
+		return 1;
+	}
+	fclose(test);
+	SimBiConFramework* conF = new SimBiConFramework(inputFile, NULL);
+	if (conF->getController() == NULL || conF->getCharacter() == NULL){
+		printf("The input file %s did not load a character and a controller.\n", inputFile);
+		delete conF;
+		return 1;
+	}
+	//walk for one simulated second first, so the benchmarks start from a character that is really walking
+	int warmUpSteps = (int)(1.0 / SimGlobals::dt + 0.5);
+	for (int i=0;i<warmUpSteps;i++)
+		conF->advanceInTime(SimGlobals::dt);
+
+	DynamicArray<Benchmark*> benchmarks;
+	benchmarks.push_back(new CatmullRomBenchmark());
+	benchmarks.push_back(new PDTorqueBenchmark());
+	benchmarks.push_back(new QuaternionRotateBenchmark());
+	benchmarks.push_back(new QuaternionMultiplyBenchmark());
+	benchmarks.push_back(new ContactBenchmark(ContactBenchmark::SPHERE_PLANE));
+	benchmarks.push_back(new ContactBenchmark(ContactBenchmark::CAPSULE_PLANE));
+	benchmarks.push_back(new ContactBenchmark(ContactBenchmark::SPHERE_CAPSULE));
+	benchmarks.push_back(new ContactBenchmark(ContactBenchmark::CAPSULE_CAPSULE));
+	benchmarks.push_back(new CharacterGetStateBenchmark(conF->getCharacter()));
+	benchmarks.push_back(new CharacterSetStateBenchmark(conF->getCharacter()));
+	benchmarks.push_back(new WorldGetStateBenchmark(conF->getWorld()));
+	benchmarks.push_back(new ComputeTorquesBenchmark(conF));
+	//this one moves the simulation forward, so it goes last
+	benchmarks.push_back(new SimulationStepBenchmark(conF));
+
+	FILE* out = NULL;
+	if (outputFile != NULL){
+		out = fopen(outputFile, "w");
+		if (out == NULL)
+			printf("Cannot write the results to %s\n", outputFile);
+		else
+			fprintf(out, "# name\tns/op allocations/op iterations\n");
+	}
+
+	printf("%-42s %12s %12s %12s\n", "benchmark", "ns/op", "allocs/op", "vs baseline");
+	int regressions = 0;
+	for (uint i=0;i<benchmarks.size();i++){
+		if (filter != NULL && strstr(benchmarks[i]->getName(), filter) == NULL)
+			continue;
+		BenchResult r = runBenchmark(benchmarks[i], timeBudget);
+		if (out != NULL)
+			fprintf(out, "%s\t%.3f %.3f %lld\n", r.name, r.nsPerOp, r.allocationsPerOp, r.iterations);
+
+		char comparison[50] = "";
+		for (uint j=0;j<baseline.size();j++){
+			if (strcmp(baseline[j].name, r.name) != 0)
+				continue;
+			double change = (baseline[j].nsPerOp > 0) ? 100 * (r.nsPerOp / baseline[j].nsPerOp - 1) : 0;
+			bool regressed = change > tolerance || r.allocationsPerOp > baseline[j].allocationsPerOp;
+			sprintf(comparison, "%+.1f%%%s", change, regressed ? " FAIL" : "     ");
+			if (regressed)
+				regressions++;
+		}
+		if (benchmarks[i]->mustNotAllocate() && r.allocationsPerOp > 0){
+			strcpy(comparison, "ALLOCATES");
+			regressions++;
+		}
+		printf("%-42s %12.2f %12.3f %12s\n", r.name, r.nsPerOp, r.allocationsPerOp, comparison);
+	}
+
+	if (out != NULL)
+		fclose(out);
+	for (uint i=0;i<benchmarks.size();i++)
+		delete benchmarks[i];
+	delete conF;
+
+	if (regressions > 0){
+		if (baselineFile != NULL)
+			printf("%d benchmark(s) regressed against %s, or allocated when they must not\n", regressions, baselineFile);
+		else
+			printf("%d benchmark(s) allocated when they must not\n", regressions);
+		return 2;
+	}
+	return 0;
+}
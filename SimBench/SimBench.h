@@ -0,0 +1,19 @@
+#pragma once
+
+/**
+	returns the number of heap allocations the program has made so far, from all of its threads
+*/
+long long getAllocationCount();
+
+/**
+	This method runs the end-to-end benchmark: every shipped character walks for a while, in one or more worker threads that each own
+	a whole simulation. The arguments are the ones that follow -throughput on the command line. It returns the exit code of the program.
+*/
+int runThroughputBenchmark(int argc, char** argv);
+
+/**
+	This method runs the physics check: every shipped character flies through the air on its own, in reduced coordinates, and the drift of the
+	quantities it has to conserve is measured. The arguments are the ones that follow -conservation on the command line. It returns the exit
+	code of the program.
+*/
+int runConservationCheck(int argc, char** argv);
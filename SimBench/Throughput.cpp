@@ -0,0 +1,306 @@
+// Throughput.cpp : the end-to-end benchmark of SimBench. It answers the question "how many seconds of walking can we simulate in one
+// second of wall time, and how does that scale with the cores of the machine".
+//
+// Every shipped character walks with its controller for a fixed amount of simulated time, stepped through
+// SimBiConFramework::advanceInTime at SimGlobals::dt. The same run is then repeated with more and more worker threads, each of them
+// owning an independent simulation, and the efficiency tells how close to linear the scaling is.
+
+#include "stdafx.h"
+
+#include "SimBench.h"
+#include <SimBiConFramework.h>
+#include <SimGlobals.h>
+#include <Profiler.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#ifdef WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+/**
+	A character and the controller it walks with.
+*/
+typedef struct {
+	const char* name;
+	const char* inputFile;
+} ThroughputConfig;
+
+static const ThroughputConfig configs[] = {
+	{"bipV2", "../Data/init/bipV2.conF"},
+	{"bigBird", "../Data/init/bigBird.conF"},
+	{"raptor", "../Data/init/raptor.conF"},
+	{"bip2D", "../Data/init/bip2D.conF"}
+};
+
+static const int configCount = sizeof(configs) / sizeof(configs[0]);
+
+/**
+	What one worker measured.
+*/
+typedef struct {
+	bool loaded;
+	int steps;
+	bool fell;
+	//when the worker was done with its steps
+	long long endTicks;
+} WorkerResult;
+
+/**
+	The worker threads load their simulations first, and then wait for all the others so that they all start walking at the same time.
+	When they are done walking, they also wait for all the others before they free their simulations, so that no worker is still
+	being timed while another one tears its simulation down.
+*/
+typedef struct {
+	std::mutex lock;
+	std::condition_variable changed;
+	int readyWorkers;
+	bool started;
+	int finishedWorkers;
+} StartLine;
+
+//building and tearing down a simulation goes through the PhysX SDK and the shared globals, so only one worker at a time does it
+static std::mutex simulationLifetimeLock;
+
+/**
+	returns the largest amount of memory the process has used so far, in megabytes
+*/
+static double getPeakMemoryUsage(){
+#ifdef WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) == 0)
+		return 0;
+	return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#else
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+	//this is in kilobytes
+	return usage.ru_maxrss / 1024.0;
+#endif
+}
+
+/**
+	This is what every worker thread runs: it loads its own simulation and then advances it nSteps times.
+*/
+static void runWorker(const ThroughputConfig* config, int nSteps, StartLine* startLine, WorkerResult* result){
+	result->loaded = false;
+	result->steps = 0;
+	result->fell = false;
+
+	SimBiConFramework* conF = NULL;
+	{
+		std::lock_guard<std::mutex> lifetimeLock(simulationLifetimeLock);
+		conF = new SimBiConFramework((char*)config->inputFile, NULL);
+	}
+	result->loaded = (conF->getController() != NULL && conF->getCharacter() != NULL);
+
+	{
+		std::unique_lock<std::mutex> lock(startLine->lock);
+		startLine->readyWorkers++;
+		startLine->changed.notify_all();
+		while (!startLine->started)
+			startLine->changed.wait(lock);
+	}
+
+	if (result->loaded){
+		for (int i=0;i<nSteps;i++){
+			conF->advanceInTime(SimGlobals::dt);
+			if (conF->getController()->isBodyInContactWithTheGround())
+				result->fell = true;
+		}
+		result->steps = nSteps;
+	}
+	result->endTicks = Profiler::getTicks();
+
+	{
+		std::unique_lock<std::mutex> lock(startLine->lock);
+		startLine->finishedWorkers++;
+		startLine->changed.notify_all();
+		while (startLine->finishedWorkers < startLine->readyWorkers)
+			startLine->changed.wait(lock);
+	}
+
+	std::lock_guard<std::mutex> lifetimeLock(simulationLifetimeLock);
+	delete conF;
+}
+
+/**
+	The numbers of one configuration, run with a given number of workers.
+*/
+typedef struct {
+	int workers;
+	double wallTime;
+	//the simulated seconds per wall second of one of the simulations, and of all of them together
+	double realTimeFactor;
+	double totalRealTimeFactor;
+	double stepsPerSecond;
+	double allocationsPerStep;
+	double peakMemory;
+	bool fell;
+} ThroughputResult;
+
+/**
+	This method runs a configuration on the given number of workers, and returns false if the configuration could not be loaded.
+*/
+static bool runConfig(const ThroughputConfig* config, int workers, double simTime, ThroughputResult* r){
+	int nSteps = (int)(simTime / SimGlobals::dt + 0.5);
+	StartLine startLine;
+	startLine.readyWorkers = 0;
+	startLine.started = false;
+	startLine.finishedWorkers = 0;
+
+	DynamicArray<WorkerResult> results(workers);
+	DynamicArray<std::thread*> threads;
+	for (int i=0;i<workers;i++)
+		threads.push_back(new std::thread(runWorker, config, nSteps, &startLine, &results[i]));
+
+	//loading the files is not timed, only the simulation steps
+	{
+		std::unique_lock<std::mutex> lock(startLine.lock);
+		while (startLine.readyWorkers < workers)
+			startLine.changed.wait(lock);
+	}
+	long long allocationsBefore = getAllocationCount();
+	long long start = Profiler::getTicks();
+	{
+		std::unique_lock<std::mutex> lock(startLine.lock);
+		startLine.started = true;
+		startLine.changed.notify_all();
+	}
+
+	for (int i=0;i<workers;i++){
+		threads[i]->join();
+		delete threads[i];
+	}
+	long long allocations = getAllocationCount() - allocationsBefore;
+
+	//the wall time ends with the slowest worker - freeing the simulations afterwards is not timed
+	long long end = start;
+	r->workers = workers;
+	r->fell = false;
+	long long steps = 0;
+	for (int i=0;i<workers;i++){
+		if (!results[i].loaded)
+			return false;
+		steps += results[i].steps;
+		r->fell = r->fell || results[i].fell;
+		if (results[i].endTicks > end)
+			end = results[i].endTicks;
+	}
+	r->wallTime = (end - start) / (double)Profiler::getTicksPerSecond();
+	r->realTimeFactor = (r->wallTime > 0) ? nSteps * SimGlobals::dt / r->wallTime : 0;
+	r->totalRealTimeFactor = r->realTimeFactor * workers;
+	r->stepsPerSecond = (r->wallTime > 0) ? steps / r->wallTime : 0;
+	r->allocationsPerStep = (steps > 0) ? (double)allocations / steps : 0;
+	r->peakMemory = getPeakMemoryUsage();
+	return true;
+}
+
+static void printThroughputUsage(){
+	printf("usage: SimBench -throughput [-t seconds] [-workers n] [-config name] [-o results.txt]\n");
+	printf("\t-t\t\tsimulated time of every run, in seconds (default 10)\n");
+	printf("\t-workers\tthe largest number of simultaneous simulations, the runs go 1, 2, 4... up to it (default: one per hardware thread)\n");
+	printf("\t-config\t\tonly run this character (bipV2, bigBird, raptor or bip2D)\n");
+	printf("\t-o\t\tsave the results to a file\n");
+	printf("The peak memory is the one of the whole process so far - run one character with -config to get its own.\n");
+}
+
+int runThroughputBenchmark(int argc, char** argv){
+	double simTime = 10;
+	int maxWorkers = (int)std::thread::hardware_concurrency();
+	char* configName = NULL;
+	char* outputFile = NULL;
+
+	for (int i=1;i<argc;i++){
+		bool hasValue = (i+1 < argc);
+		if (strcmp(argv[i], "-t") == 0 && hasValue)
+			simTime = atof(argv[++i]);
+		else if (strcmp(argv[i], "-workers") == 0 && hasValue)
+			maxWorkers = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-config") == 0 && hasValue)
+			configName = argv[++i];
+		else if (strcmp(argv[i], "-o") == 0 && hasValue)
+			outputFile = argv[++i];
+		else{
+			printf("Unknown or incomplete argument: %s\n", argv[i]);
+			printThroughputUsage();
+			return 1;
+		}
+	}
+	//hardware_concurrency returns 0 when it does not know
+	if (maxWorkers <= 0)
+		maxWorkers = 1;
+	if (simTime <= 0){
+		printf("The simulated time needs to be positive.\n");
+		return 1;
+	}
+
+	FILE* out = NULL;
+	if (outputFile != NULL){
+		out = fopen(outputFile, "w");
+		if (out == NULL)
+			printf("Cannot write the results to %s\n", outputFile);
+		else
+			fprintf(out, "# config\tworkers wallTime realTimeFactor totalRealTimeFactor stepsPerSecond allocationsPerStep peakMemoryMB efficiency fell\n");
+	}
+
+	printf("%.1f s of walking at dt = %g, on 1 to %d workers\n", simTime, SimGlobals::dt, maxWorkers);
+	printf("%-8s %7s %9s %9s %10s %12s %11s %11s %10s\n", "config", "workers", "RTF/sim", "RTF", "steps/s", "allocs/step", "peak MB", "efficiency", "");
+	int failures = 0;
+	bool ranAny = false;
+	for (int c=0;c<configCount;c++){
+		if (configName != NULL && strcmp(configs[c].name, configName) != 0)
+			continue;
+		ranAny = true;
+
+		FILE* test = fopen(configs[c].inputFile, "r");
+		if (test == NULL){
+			printf("Cannot open input file %s\n", configs[c].inputFile);
+			failures++;
+			continue;
+		}
+		fclose(test);
+
+		double singleRealTimeFactor = 0;
+		for (int workers=1;;workers*=2){
+			//the last run always uses all the workers, even if that is not a power of two
+			if (workers > maxWorkers)
+				workers = maxWorkers;
+
+			ThroughputResult r;
+			if (!runConfig(&configs[c], workers, simTime, &r)){
+				printf("The input file %s did not load a character and a controller.\n", configs[c].inputFile);
+				failures++;
+				break;
+			}
+			if (workers == 1)
+				singleRealTimeFactor = r.realTimeFactor;
+			double efficiency = (singleRealTimeFactor > 0) ? r.totalRealTimeFactor / (workers * singleRealTimeFactor) : 0;
+
+			printf("%-8s %7d %9.2f %9.2f %10.0f %12.3f %11.1f %10.0f%% %10s\n", configs[c].name, workers, r.realTimeFactor, r.totalRealTimeFactor,
+				r.stepsPerSecond, r.allocationsPerStep, r.peakMemory, 100 * efficiency, r.fell ? "FELL" : "");
+			if (out != NULL)
+				fprintf(out, "%s\t%d %.4f %.4f %.4f %.1f %.4f %.1f %.4f %d\n", configs[c].name, workers, r.wallTime, r.realTimeFactor, r.totalRealTimeFactor,
+					r.stepsPerSecond, r.allocationsPerStep, r.peakMemory, efficiency, r.fell ? 1 : 0);
+			//a character that falls does not run the same code as one that walks, so its numbers are not comparable
+			if (r.fell)
+				failures++;
+
+			if (workers == maxWorkers)
+				break;
+		}
+	}
+
+	if (out != NULL)
+		fclose(out);
+	if (!ranAny){
+		printf("There is no character called %s.\n", configName);
+		return 1;
+	}
+	return (failures > 0) ? 2 : 0;
+}
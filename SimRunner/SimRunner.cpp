@@ -0,0 +1,351 @@
+// SimRunner.cpp : runs a SimBiCon simulation from the command line, without a window or an OpenGL context.
+//
+// usage: SimRunner <input.conF> [-c controller.sbc] [-t seconds] [-dt step] [-o metrics.txt|-] [-every n] [-stopOnFall] [-profile trace.json]
+//                  [-crowd k [spacing]]
+//
+// The simulation is advanced as fast as possible, and one line of metrics is written every n steps. With -crowd, k copies of the character
+// share the world, and the first one is checked against a character that is simulated on its own.
+
+#include "stdafx.h"
+
+#include <SimBiConFramework.h>
+#include <SimBiConCrowdFramework.h>
+#include <Profiler.h>
+#include <chrono>
+
+/**
+	The settings that can be passed in on the command line.
+*/
+typedef struct {
+	char* inputFile;
+	char* conFile;
+	char* metricsFile;
+	char* traceFile;
+	double simTime;
+	double dt;
+	int every;
+	bool stopOnFall;
+	//the number of characters of the crowd, 0 to simulate a single character without the crowd framework
+	int crowdSize;
+	double crowdSpacing;
+} RunnerSettings;
+
+static void printUsage(){
+	printf("usage: SimRunner <input.conF> [-c controller.sbc] [-t seconds] [-dt step] [-o metrics.txt|-] [-every n] [-stopOnFall] [-profile trace.json]\n");
+	printf("                 [-crowd k [spacing]]\n");
+	printf("\t-c\t\tcontroller file to use instead of the one in the input file\n");
+	printf("\t-t\t\tsimulated time, in seconds (default 10)\n");
+	printf("\t-dt\t\tsimulation time step (default 0.0005)\n");
+	printf("\t-o\t\tfile the per-step metrics are written to, - for stdout (default: no metrics)\n");
+	printf("\t-every\t\twrite the metrics once every n steps (default 1)\n");
+	printf("\t-stopOnFall\tstop as soon as the character's body touches the ground\n");
+	printf("\t-profile\ttime the phases of every step, print a summary and write a Chrome trace to the file\n");
+	printf("\t-crowd\t\tsimulate k characters in the same world, spacing meters apart (default 1). The first one has to follow a character\n");
+	printf("\t\t\tsimulated on its own exactly, as long as the characters do not touch each other\n");
+}
+
+/**
+	Returns true if the whole string is a number, which is then written to value.
+*/
+static bool parseNumber(const char* str, double* value){
+	char* end = NULL;
+	*value = strtod(str, &end);
+	return end != str && *end == '\0';
+}
+
+/**
+	Parses the command line into the settings. Returns false if the command line is not valid.
+*/
+static bool parseArguments(int argc, char** argv, RunnerSettings* s){
+	s->inputFile = NULL;
+	s->conFile = NULL;
+	s->metricsFile = NULL;
+	s->traceFile = NULL;
+	s->simTime = 10;
+	s->dt = 0.0005;
+	s->every = 1;
+	s->stopOnFall = false;
+	s->crowdSize = 0;
+	s->crowdSpacing = 1.0;
+
+	for (int i=1;i<argc;i++){
+		bool hasValue = (i+1 < argc);
+		if (strcmp(argv[i], "-c") == 0 && hasValue)
+			s->conFile = argv[++i];
+		else if (strcmp(argv[i], "-t") == 0 && hasValue)
+			s->simTime = atof(argv[++i]);
+		else if (strcmp(argv[i], "-dt") == 0 && hasValue)
+			s->dt = atof(argv[++i]);
+		else if (strcmp(argv[i], "-o") == 0 && hasValue)
+			s->metricsFile = argv[++i];
+		else if (strcmp(argv[i], "-every") == 0 && hasValue)
+			s->every = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-profile") == 0 && hasValue)
+			s->traceFile = argv[++i];
+		else if (strcmp(argv[i], "-stopOnFall") == 0)
+			s->stopOnFall = true;
+		else if (strcmp(argv[i], "-crowd") == 0 && hasValue){
+			s->crowdSize = atoi(argv[++i]);
+			//the spacing is optional
+			double spacing;
+			if (i+1 < argc && parseNumber(argv[i+1], &spacing)){
+				s->crowdSpacing = spacing;
+				i++;
+			}
+			if (s->crowdSize <= 0){
+				printf("The crowd needs at least one character.\n");
+				return false;
+			}
+		}
+		else if (argv[i][0] != '-' && s->inputFile == NULL)
+			s->inputFile = argv[i];
+		else{
+			printf("Unknown or incomplete argument: %s\n", argv[i]);
+			return false;
+		}
+	}
+
+	if (s->inputFile == NULL){
+		printf("No input file specified.\n");
+		return false;
+	}
+	if (s->dt <= 0 || s->simTime <= 0 || s->every <= 0){
+		printf("The time step, the simulated time and the output interval all need to be positive.\n");
+		return false;
+	}
+	if (s->crowdSize > 0 && s->metricsFile != NULL){
+		printf("The metrics are written for a single character, -o cannot be used with -crowd.\n");
+		return false;
+	}
+	return true;
+}
+
+/**
+	Writes one line of metrics describing the current state of the simulation.
+*/
+static void writeMetrics(FILE* f, SimBiConFramework* conF, int step, double t, bool newStep){
+	SimBiController* con = conF->getController();
+	Character* ch = conF->getCharacter();
+	Vector3d com = ch->getCOM();
+	Vector3d comVel = ch->getCOMVelocity();
+	Vector3d lastStep = conF->getLastStepTaken();
+
+	fprintf(f, "%lf %d %lf %d %d %lf %lf %lf %lf %lf %lf %d %d %lf %lf\n", t, step, con->getPhase(), con->getFSMState(), con->getStance(),
+		com.x, com.y, com.z, comVel.x, comVel.y, comVel.z, (int)conF->getWorld()->getContactForces()->size(), newStep?1:0, lastStep.x, lastStep.z);
+}
+
+/**
+	Returns true if the contact is between the bodies of two different figures.
+*/
+static bool isContactBetweenFigures(const ContactPoint& c){
+	if (c.rb1 == NULL || c.rb2 == NULL || !c.rb1->isArticulated() || !c.rb2->isArticulated())
+		return false;
+	return ((ArticulatedRigidBody*)c.rb1)->getAFParent() != ((ArticulatedRigidBody*)c.rb2)->getAFParent();
+}
+
+/**
+	Simulates a crowd of s.crowdSize characters and prints a summary of the run. A crowd of one character is stepped along with it: the
+	characters of the crowd only interact through their contacts, so as long as they never touch each other, the first character of the
+	crowd, which is not moved away from the starting position, has to go through exactly the same states as the character that is alone.
+	Returns 3 if the first character did not match, otherwise 2 if a character fell, and 0 if the run went well.
+*/
+static int runCrowd(const RunnerSettings& s){
+	SimBiConCrowdFramework* crowd = new SimBiConCrowdFramework(s.inputFile, s.crowdSize, s.crowdSpacing, s.conFile);
+	SimBiConCrowdFramework* single = new SimBiConCrowdFramework(s.inputFile, 1, s.crowdSpacing, s.conFile);
+	if (crowd->getCharacterCount() != s.crowdSize || single->getCharacterCount() != 1 || crowd->getController(0) == NULL){
+		printf("The input file %s did not load a character and a controller.\n", s.inputFile);
+		delete crowd;
+		delete single;
+		return 1;
+	}
+
+	int n = crowd->getCharacterCount();
+	DynamicArray<Vector3d> startCOM;
+	DynamicArray<bool> fell;
+	for (int i=0;i<n;i++){
+		startCOM.push_back(crowd->getCharacter(i)->getCOM());
+		fell.push_back(false);
+	}
+
+	int nSteps = (int)(s.simTime / s.dt + 0.5);
+	int step = 0;
+	int stepsTaken = 0;
+	bool anyFell = false;
+	bool touched = false;
+	//the first step at which the first character of the crowd is not in the same state as the one that is alone, -1 if there is none
+	int firstMismatch = -1;
+	DynamicArray<double> crowdState, singleState;
+
+	if (s.traceFile != NULL)
+		Profiler::setEnabled(true);
+	else if (World::isEngineOptionSet("profile"))
+		Profiler::reportAtExit("../profile.json");
+
+	//only the steps of the crowd are timed, not the ones of the reference character
+	double wallTime = 0;
+	while (step < nSteps){
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		bool newStep = crowd->advanceInTime(s.dt);
+		std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+		wallTime += std::chrono::duration_cast<std::chrono::duration<double> >(end - start).count();
+		step++;
+		if (newStep)
+			stepsTaken++;
+
+		DynamicArray<ContactPoint>* cfs = crowd->getWorld()->getContactForces();
+		for (uint j=0;j<cfs->size() && !touched;j++)
+			touched = isContactBetweenFigures((*cfs)[j]);
+
+		if (firstMismatch < 0){
+			single->advanceInTime(s.dt);
+			crowdState.clear();
+			singleState.clear();
+			crowd->getCharacter(0)->getState(&crowdState);
+			single->getCharacter(0)->getState(&singleState);
+			if (crowdState != singleState || crowd->getController(0)->getFSMState() != single->getController(0)->getFSMState())
+				firstMismatch = step;
+		}
+
+		for (int i=0;i<n;i++){
+			if (crowd->getController(i)->isBodyInContactWithTheGround()){
+				fell[i] = true;
+				anyFell = true;
+			}
+		}
+		if (anyFell && s.stopOnFall)
+			break;
+	}
+
+	double simulatedTime = step * s.dt;
+	printf("characters: %d, %lf m apart\n", n, s.crowdSpacing);
+	printf("simulation steps: %d\n", step);
+	printf("simulated time: %lf s\n", simulatedTime);
+	printf("wall time: %lf s\n", wallTime);
+	printf("real-time factor: %lf\n", (wallTime > 0) ? simulatedTime / wallTime : 0.0);
+	printf("steps taken: %d\n", stepsTaken);
+	for (int i=0;i<n;i++){
+		Vector3d walked = crowd->getCharacter(i)->getCOM() - startCOM[i];
+		walked.y = 0;
+		printf("character %d: fell: %s, walked %lf m\n", i, fell[i]?"yes":"no", walked.length());
+	}
+	printf("characters touched each other: %s\n", touched?"yes":"no");
+
+	//once the characters have touched each other, the first one has no reason to follow the character that is alone anymore
+	bool mismatch = (firstMismatch >= 0 && !touched);
+	if (touched)
+		printf("first character matches the single character: not checked\n");
+	else if (firstMismatch >= 0)
+		printf("first character matches the single character: no, from step %d on\n", firstMismatch);
+	else
+		printf("first character matches the single character: yes\n");
+
+	if (s.traceFile != NULL){
+		Profiler::setEnabled(false);
+		Profiler::printSummary(stdout);
+		Profiler::writeChromeTrace(s.traceFile);
+	}
+
+	delete crowd;
+	delete single;
+	if (mismatch)
+		return 3;
+	return anyFell ? 2 : 0;
+}
+
+int main(int argc, char** argv){
+	RunnerSettings s;
+	if (!parseArguments(argc, argv, &s)){
+		printUsage();
+		return 1;
+	}
+
+	//the framework does not check this, so make sure the files are there before loading anything
+	FILE* test = fopen(s.inputFile, "r");
+	if (test == NULL){
+		printf("Cannot open input file %s\n", s.inputFile);
+		return 1;
+	}
+	fclose(test);
+	if (s.conFile != NULL){
+		test = fopen(s.conFile, "r");
+		if (test == NULL){
+			printf("Cannot open controller file %s\n", s.conFile);
+			return 1;
+		}
+		fclose(test);
+	}
+
+	if (s.crowdSize > 0)
+		return runCrowd(s);
+
+	SimBiConFramework* conF = new SimBiConFramework(s.inputFile, s.conFile);
+	if (conF->getController() == NULL || conF->getCharacter() == NULL){
+		printf("The input file %s did not load a character and a controller.\n", s.inputFile);
+		delete conF;
+		return 1;
+	}
+
+	FILE* metrics = NULL;
+	if (s.metricsFile != NULL){
+		metrics = (strcmp(s.metricsFile, "-") == 0) ? stdout : fopen(s.metricsFile, "w");
+		if (metrics == NULL){
+			printf("Cannot open metrics file %s\n", s.metricsFile);
+			delete conF;
+			return 1;
+		}
+		fprintf(metrics, "# time step phase fsmState stance comX comY comZ comVelX comVelY comVelZ contacts newStep lastStepX lastStepZ\n");
+	}
+
+	int nSteps = (int)(s.simTime / s.dt + 0.5);
+	int step = 0;
+	int stepsTaken = 0;
+	bool fell = false;
+
+	//loading the files is not timed, only the simulation steps. Without -profile, the engine line of controllerconfig.txt can still ask for the
+	//report of the whole run
+	if (s.traceFile != NULL)
+		Profiler::setEnabled(true);
+	else if (World::isEngineOptionSet("profile"))
+		Profiler::reportAtExit("../profile.json");
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	while (step < nSteps){
+		bool newStep = conF->advanceInTime(s.dt);
+		step++;
+		if (newStep)
+			stepsTaken++;
+
+		if (metrics != NULL && (step % s.every == 0 || newStep))
+			writeMetrics(metrics, conF, step, step * s.dt, newStep);
+
+		if (conF->getController()->isBodyInContactWithTheGround()){
+			fell = true;
+			if (s.stopOnFall)
+				break;
+		}
+	}
+	std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+	double wallTime = std::chrono::duration_cast<std::chrono::duration<double> >(end - start).count();
+
+	if (metrics != NULL && metrics != stdout)
+		fclose(metrics);
+
+	//the summary goes to stderr when the metrics are streamed to stdout, so the two never get mixed up
+	FILE* summary = (metrics == stdout) ? stderr : stdout;
+	double simulatedTime = step * s.dt;
+	fprintf(summary, "simulation steps: %d\n", step);
+	fprintf(summary, "simulated time: %lf s\n", simulatedTime);
+	fprintf(summary, "wall time: %lf s\n", wallTime);
+	fprintf(summary, "real-time factor: %lf\n", (wallTime > 0) ? simulatedTime / wallTime : 0.0);
+	fprintf(summary, "steps taken: %d\n", stepsTaken);
+	fprintf(summary, "fell: %s\n", fell?"yes":"no");
+
+	if (s.traceFile != NULL){
+		Profiler::setEnabled(false);
+		Profiler::printSummary(summary);
+		Profiler::writeChromeTrace(s.traceFile);
+	}
+
+	delete conF;
+	return fell ? 2 : 0;
+}
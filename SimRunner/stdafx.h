@@ -0,0 +1,12 @@
+// stdafx.h : include file for standard system include files,
+// or project specific include files that are used frequently, but
+// are changed infrequently
+//
+
+#pragma once
+
+// the runner has no window, so it does not pull in any of the Windows headers - this keeps it buildable on other platforms
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
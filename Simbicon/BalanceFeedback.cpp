@@ -25,6 +25,7 @@
 
 #include "BalanceFeedback.h"
 #include "ConUtils.h"
+#include "ConBinary.h"
 #include <Joint.h>
 #include "SimBiController.h"
 
@@ -135,3 +136,29 @@ void LinearBalanceFeedback::writeToFile(std::ofstream& f){
 
     f << "\t\t\t" << getConLineString(CON_FEEDBACK_END) << std::endl;
 }
+
+/**
+	This method is used to read the feedback parameters from a compiled controller
+*/
+void LinearBalanceFeedback::loadFromBinary(ConBinaryReader& r){
+	feedbackProjectionAxis = r.readVector();
+	cd = r.readDouble();
+	cv = r.readDouble();
+	dMin = r.readDouble();
+	dMax = r.readDouble();
+	vMin = r.readDouble();
+	vMax = r.readDouble();
+}
+
+/**
+	This method is used to write the feedback parameters to a compiled controller
+*/
+void LinearBalanceFeedback::writeToBinary(ConBinaryWriter& w){
+	w.writeVector(feedbackProjectionAxis);
+	w.writeDouble(cd);
+	w.writeDouble(cv);
+	w.writeDouble(dMin);
+	w.writeDouble(dMax);
+	w.writeDouble(vMin);
+	w.writeDouble(vMax);
+}
@@ -28,6 +28,8 @@
 
 class SimBiController;
 class Joint;
+class ConBinaryReader;
+class ConBinaryWriter;
 
 /**
 	This generic class provides an interface for classes that provide balance feedback for controllers for physically simulated characters.
@@ -112,5 +114,11 @@ public:
 	virtual void writeToFile(FILE* fp);
     virtual void writeToFile(std::ofstream& fp);
 	virtual void loadFromFile(FILE* fp);
+
+	/**
+		These methods are used to read and write the feedback parameters in a compiled controller
+	*/
+	void loadFromBinary(ConBinaryReader& r);
+	void writeToBinary(ConBinaryWriter& w);
 };
 
@@ -39,6 +39,7 @@ BaseControlFramework::BaseControlFramework(void){
 */
 BaseControlFramework::~BaseControlFramework(void){
 	delete bip;
-	SimGlobals::activeRbEngine = NULL;
+	//the framework owns its world
+	delete pw;
 }
 
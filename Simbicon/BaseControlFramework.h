@@ -30,7 +30,7 @@
 
 class BaseControlFramework{
 public:
-	//this is the physical world that contains all the objects inside.
+	//this is the physical world that contains all the objects inside. Each framework owns its own world.
 	World* pw;
 	//this is the character that we want to control (we can easily have more than one if we wanted to).
 	Character* bip;
@@ -170,9 +170,9 @@ public:
 		this method is used to return a reference to the joint whose name is passed as a parameter, or NULL
 		if it is not found.
 	*/
-	inline Joint* getJointByName(char* jName){
+	inline Joint* getJointByName(const char* jName){
 		for (uint i=0;i<joints.size();i++)
-			if (strcmp(joints[i]->name, jName) == NULL)
+			if (strcmp(joints[i]->name, jName) == 0)
 				return joints[i];
 		return NULL;
 	}
@@ -180,9 +180,9 @@ public:
 	/**
 		this method is used to return the index of the joint (whose name is passed as a parameter) in the articulated figure hierarchy.
 	*/
-	inline int getJointIndex(char* jName){
+	inline int getJointIndex(const char* jName){
 		for (uint i=0;i<joints.size();i++)
-			if (strcmp(joints[i]->name, jName) == NULL)
+			if (strcmp(joints[i]->name, jName) == 0)
 				return i;
 		return -1;
 	}
@@ -191,11 +191,11 @@ public:
 		this method is used to return a reference to the articulated figure's rigid body whose name is passed in as a parameter, 
 		or NULL if it is not found.
 	*/
-	inline ArticulatedRigidBody* getARBByName(char* jName){
+	inline ArticulatedRigidBody* getARBByName(const char* jName){
 		for (uint i=0;i<joints.size();i++){
-			if (strcmp(joints[i]->parent->name, jName) == NULL)
+			if (strcmp(joints[i]->parent->name, jName) == 0)
 				return joints[i]->parent;
-			if (strcmp(joints[i]->child->name, jName) == NULL)
+			if (strcmp(joints[i]->child->name, jName) == 0)
 				return joints[i]->child;
 		}
 		return NULL;
@@ -0,0 +1,239 @@
+#include "stdafx.h"
+
+#include "ConBinary.h"
+#include <string.h>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+//the magic, the version and the byte order
+#define SBC_BINARY_HEADER_SIZE			12
+
+/**
+	returns true if the file that is passed in as a parameter starts like a compiled controller
+*/
+bool isBinaryControllerFile(const char* fileName){
+	FILE* f = fopen(fileName, "rb");
+	if (f == NULL)
+		return false;
+	char magic[4];
+	bool isBinary = (fread(magic, 1, 4, f) == 4 && memcmp(magic, SBC_BINARY_MAGIC, 4) == 0);
+	fclose(f);
+	return isBinary;
+}
+
+/**
+	This constructor opens the file and writes the header of a compiled controller to it.
+*/
+ConBinaryWriter::ConBinaryWriter(const char* fileName){
+	failed = false;
+	f = fopen(fileName, "wb");
+	if (f == NULL){
+		printf("Cannot write the controller file %s\n", fileName);
+		return;
+	}
+	if (fwrite(SBC_BINARY_MAGIC, 1, 4, f) != 4)
+		failed = true;
+	writeInt(SBC_BINARY_VERSION);
+	writeInt(SBC_BINARY_BYTE_ORDER);
+}
+
+/**
+	The destructor closes the file.
+*/
+ConBinaryWriter::~ConBinaryWriter(){
+	if (f != NULL)
+		fclose(f);
+}
+
+void ConBinaryWriter::writeInt(int value){
+	if (f == NULL || fwrite(&value, sizeof(value), 1, f) != 1)
+		failed = true;
+}
+
+void ConBinaryWriter::writeDouble(double value){
+	if (f == NULL || fwrite(&value, sizeof(value), 1, f) != 1)
+		failed = true;
+}
+
+void ConBinaryWriter::writeVector(const Vector3d& v){
+	writeDouble(v.x);
+	writeDouble(v.y);
+	writeDouble(v.z);
+}
+
+void ConBinaryWriter::writeString(const char* s){
+	int length = (int)strlen(s);
+	writeInt(length);
+	if (f == NULL || (length > 0 && fwrite(s, 1, length, f) != (size_t)length))
+		failed = true;
+}
+
+/**
+	This constructor maps the file and checks its header.
+*/
+ConBinaryReader::ConBinaryReader(const char* fileName){
+	data = NULL;
+	size = 0;
+	position = 0;
+	failed = true;
+	version = 0;
+
+#ifdef WIN32
+	fileHandle = INVALID_HANDLE_VALUE;
+	mappingHandle = NULL;
+	HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE){
+		printf("Cannot open the controller file %s\n", fileName);
+		return;
+	}
+	fileHandle = file;
+	LARGE_INTEGER fileSize;
+	if (GetFileSizeEx(file, &fileSize) == 0 || fileSize.QuadPart < SBC_BINARY_HEADER_SIZE){
+		printf("The controller file %s is too short\n", fileName);
+		return;
+	}
+	HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL){
+		printf("Cannot map the controller file %s\n", fileName);
+		return;
+	}
+	mappingHandle = mapping;
+	data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (data == NULL){
+		printf("Cannot map the controller file %s\n", fileName);
+		return;
+	}
+	size = fileSize.QuadPart;
+#else
+	int file = open(fileName, O_RDONLY);
+	if (file < 0){
+		printf("Cannot open the controller file %s\n", fileName);
+		return;
+	}
+	struct stat fileStats;
+	if (fstat(file, &fileStats) != 0 || fileStats.st_size < SBC_BINARY_HEADER_SIZE){
+		printf("The controller file %s is too short\n", fileName);
+		close(file);
+		return;
+	}
+	void* mapped = mmap(NULL, fileStats.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	//the mapping stays valid once the file is closed
+	close(file);
+	if (mapped == MAP_FAILED){
+		printf("Cannot map the controller file %s\n", fileName);
+		return;
+	}
+	data = (const char*)mapped;
+	size = fileStats.st_size;
+#endif
+
+	if (memcmp(data, SBC_BINARY_MAGIC, 4) != 0){
+		printf("%s is not a compiled controller\n", fileName);
+		return;
+	}
+	failed = false;
+	position = 4;
+	version = readInt();
+	if (readInt() != SBC_BINARY_BYTE_ORDER){
+		printf("The controller file %s was written on a machine with a different byte order\n", fileName);
+		failed = true;
+		return;
+	}
+	if (version < 1 || version > SBC_BINARY_VERSION){
+		printf("The controller file %s has version %d, but only versions up to %d can be loaded\n", fileName, version, SBC_BINARY_VERSION);
+		failed = true;
+		return;
+	}
+}
+
+/**
+	The destructor unmaps the file.
+*/
+ConBinaryReader::~ConBinaryReader(){
+#ifdef WIN32
+	if (data != NULL)
+		UnmapViewOfFile(data);
+	if (mappingHandle != NULL)
+		CloseHandle(mappingHandle);
+	if (fileHandle != INVALID_HANDLE_VALUE)
+		CloseHandle(fileHandle);
+#else
+	if (data != NULL)
+		munmap((void*)data, size);
+#endif
+}
+
+/**
+	returns a pointer to the next nBytes bytes of the file and moves past them, or NULL if there are not that many bytes left
+*/
+const char* ConBinaryReader::take(long long nBytes){
+	if (failed || nBytes < 0 || nBytes > size - position){
+		failed = true;
+		return NULL;
+	}
+	const char* p = data + position;
+	position += nBytes;
+	return p;
+}
+
+int ConBinaryReader::readInt(){
+	int value = 0;
+	const char* p = take(sizeof(value));
+	//the values are not aligned in the file, so they are copied out rather than dereferenced
+	if (p != NULL)
+		memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+double ConBinaryReader::readDouble(){
+	double value = 0;
+	const char* p = take(sizeof(value));
+	if (p != NULL)
+		memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+Vector3d ConBinaryReader::readVector(){
+	double x = readDouble();
+	double y = readDouble();
+	double z = readDouble();
+	return Vector3d(x, y, z);
+}
+
+/**
+	reads a string into the buffer that is passed in as a parameter, which can hold maxLength characters including the terminating 0
+*/
+void ConBinaryReader::readString(char* buffer, int maxLength){
+	buffer[0] = '\0';
+	int length = readInt();
+	if (length >= maxLength){
+		failed = true;
+		return;
+	}
+	const char* p = take(length);
+	if (p == NULL)
+		return;
+	memcpy(buffer, p, length);
+	buffer[length] = '\0';
+}
+
+/**
+	reads the number of elements of an array that follows, where each element takes at least elementSize bytes in the file. A count
+	that could not possibly fit in what is left of the file makes the reader fail, so that a corrupt file never makes us allocate
+	huge arrays.
+*/
+int ConBinaryReader::readCount(int elementSize){
+	int count = readInt();
+	if (failed || count < 0 || (long long)count * elementSize > size - position){
+		failed = true;
+		return 0;
+	}
+	return count;
+}
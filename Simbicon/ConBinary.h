@@ -0,0 +1,146 @@
+#pragma once
+
+#include <PUtils.h>
+#include <Vector3d.h>
+#include <stdio.h>
+
+/**
+	A compiled controller (.sbcb) holds the same information as a text .sbc file, but it is read without any parsing: the file is mapped
+	into memory and the values are copied straight out of it. All the numbers are stored as 32 bit ints or 64 bit doubles, in the byte order
+	of the machine that wrote the file, and the strings are stored as their length followed by their characters.
+
+	The file starts with this header. The version is increased every time the layout changes - a program refuses to load a version
+	that is newer than the one it knows.
+*/
+#define SBC_BINARY_MAGIC				"SBCB"
+#define SBC_BINARY_VERSION				1
+//this is written as an int, so that files written on a machine with the other byte order are recognized
+#define SBC_BINARY_BYTE_ORDER			0x01020304
+
+//the stance of a state, as it is stored in the file
+#define SBC_BINARY_STANCE_LEFT			0
+#define SBC_BINARY_STANCE_RIGHT			1
+#define SBC_BINARY_STANCE_REVERSE		2
+#define SBC_BINARY_STANCE_SAME			3
+
+//the kind of balance feedback of a trajectory component
+#define SBC_BINARY_NO_FEEDBACK			0
+#define SBC_BINARY_LINEAR_FEEDBACK		1
+
+/**
+	returns true if the file that is passed in as a parameter starts like a compiled controller
+*/
+bool isBinaryControllerFile(const char* fileName);
+
+/**
+	This class writes the values of a compiled controller, one after the other, to a file.
+*/
+class ConBinaryWriter{
+private:
+	FILE* f;
+	bool failed;
+
+public:
+	/**
+		This constructor opens the file and writes the header of a compiled controller to it.
+	*/
+	ConBinaryWriter(const char* fileName);
+
+	/**
+		The destructor closes the file.
+	*/
+	~ConBinaryWriter();
+
+	void writeInt(int value);
+	void writeDouble(double value);
+	void writeVector(const Vector3d& v);
+	void writeString(const char* s);
+
+	/**
+		returns false if the file could not be opened, or if any of the writes failed
+	*/
+	inline bool isGood(){
+		return f != NULL && !failed;
+	}
+};
+
+/**
+	This class reads a compiled controller. The file is mapped into memory, and every read checks that it does not go past its end. Once
+	a read fails, all the reads that follow it return zeros, so the code that loads the controller only needs to check hasFailed() once
+	in a while.
+*/
+class ConBinaryReader{
+private:
+	//the whole file, as it is mapped into memory
+	const char* data;
+	long long size;
+	//the offset of the next value to be read
+	long long position;
+	bool failed;
+	int version;
+
+#ifdef WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#endif
+
+	/**
+		returns a pointer to the next nBytes bytes of the file and moves past them, or NULL if there are not that many bytes left
+	*/
+	const char* take(long long nBytes);
+
+public:
+	/**
+		This constructor maps the file and checks its header.
+	*/
+	ConBinaryReader(const char* fileName);
+
+	/**
+		The destructor unmaps the file.
+	*/
+	~ConBinaryReader();
+
+	int readInt();
+	double readDouble();
+	Vector3d readVector();
+
+	/**
+		reads a string into the buffer that is passed in as a parameter, which can hold maxLength characters including the terminating 0
+	*/
+	void readString(char* buffer, int maxLength);
+
+	/**
+		reads the number of elements of an array that follows, where each element takes at least elementSize bytes in the file. A count
+		that could not possibly fit in what is left of the file makes the reader fail, so that a corrupt file never makes us allocate
+		huge arrays.
+	*/
+	int readCount(int elementSize);
+
+	/**
+		The loaders call this method when a value that was read makes no sense, so that the file is rejected
+	*/
+	inline void setFailed(){
+		failed = true;
+	}
+
+	/**
+		returns the version of the format the file was written with
+	*/
+	inline int getVersion(){
+		return version;
+	}
+
+	/**
+		returns true if the file could not be mapped, if its header is not valid, or if a read went past the end of the file
+	*/
+	inline bool hasFailed(){
+		return failed;
+	}
+
+	/**
+		returns true if every byte of the file was read
+	*/
+	inline bool isAtEnd(){
+		return !failed && position == size;
+	}
+};
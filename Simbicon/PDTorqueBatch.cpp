@@ -0,0 +1,252 @@
+#include "stdafx.h"
+
+#include "PDTorqueBatch.h"
+#include <MathLib.h>
+#include <math.h>
+
+//the vectorized kernel is built whenever the compiler can generate AVX code: always with Visual Studio, and with -mavx (or -mavx2) otherwise
+#if defined(_MSC_VER) || defined(__AVX__)
+#define PD_TORQUE_AVX
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/**
+	The operations that the PD kernel needs, on one joint at a time.
+*/
+struct PDScalarLanes{
+	typedef double Value;
+	typedef bool Mask;
+	static const int width = 1;
+
+	static inline Value load(const double* p){ return *p; }
+	static inline void store(double* p, Value v){ *p = v; }
+	static inline Value set(double x){ return x; }
+	static inline Value add(Value a, Value b){ return a + b; }
+	static inline Value sub(Value a, Value b){ return a - b; }
+	static inline Value mul(Value a, Value b){ return a * b; }
+	static inline Value div(Value a, Value b){ return a / b; }
+	static inline Value sqrtOf(Value a){ return sqrt(a); }
+	static inline Value asinOf(Value a){ return asin(a); }
+	static inline Mask lessThan(Value a, Value b){ return a < b; }
+	static inline Mask greaterThan(Value a, Value b){ return a > b; }
+	static inline Mask both(Mask a, Mask b){ return a && b; }
+	static inline Value select(Mask m, Value a, Value b){ return m ? a : b; }
+};
+
+#ifdef PD_TORQUE_AVX
+/**
+	The operations that the PD kernel needs, on four joints at a time. There is no vectorized asin, so it is evaluated one lane at a time.
+*/
+struct PDAVXLanes{
+	typedef __m256d Value;
+	typedef __m256d Mask;
+	static const int width = 4;
+
+	static inline Value load(const double* p){ return _mm256_loadu_pd(p); }
+	static inline void store(double* p, Value v){ _mm256_storeu_pd(p, v); }
+	static inline Value set(double x){ return _mm256_set1_pd(x); }
+	static inline Value add(Value a, Value b){ return _mm256_add_pd(a, b); }
+	static inline Value sub(Value a, Value b){ return _mm256_sub_pd(a, b); }
+	static inline Value mul(Value a, Value b){ return _mm256_mul_pd(a, b); }
+	static inline Value div(Value a, Value b){ return _mm256_div_pd(a, b); }
+	static inline Value sqrtOf(Value a){ return _mm256_sqrt_pd(a); }
+	static inline Value asinOf(Value a){
+		double tmp[4];
+		_mm256_storeu_pd(tmp, a);
+		for (int i=0;i<4;i++)
+			tmp[i] = asin(tmp[i]);
+		return _mm256_loadu_pd(tmp);
+	}
+	static inline Mask lessThan(Value a, Value b){ return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+	static inline Mask greaterThan(Value a, Value b){ return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+	static inline Mask both(Mask a, Mask b){ return _mm256_and_pd(a, b); }
+	static inline Value select(Mask m, Value a, Value b){ return _mm256_blendv_pd(b, a, m); }
+};
+#endif
+
+/**
+	Rotates u by the unit quaternion (s, v), the same way Quaternion::rotate does.
+*/
+template <class L> static inline void rotateLanes(typename L::Value s, typename L::Value vx, typename L::Value vy, typename L::Value vz,
+		typename L::Value* ux, typename L::Value* uy, typename L::Value* uz){
+	typedef typename L::Value V;
+	//t = u * s + v x u
+	V tx = L::add(L::mul(*ux, s), L::sub(L::mul(vy, *uz), L::mul(vz, *uy)));
+	V ty = L::add(L::mul(*uy, s), L::sub(L::mul(vz, *ux), L::mul(vx, *uz)));
+	V tz = L::add(L::mul(*uz, s), L::sub(L::mul(vx, *uy), L::mul(vy, *ux)));
+	V d = L::add(L::add(L::mul(*ux, vx), L::mul(*uy, vy)), L::mul(*uz, vz));
+	//result = v * (u . v) + t * s + v x t
+	*ux = L::add(L::add(L::mul(vx, d), L::mul(tx, s)), L::sub(L::mul(vy, tz), L::mul(vz, ty)));
+	*uy = L::add(L::add(L::mul(vy, d), L::mul(ty, s)), L::sub(L::mul(vz, tx), L::mul(vx, tz)));
+	*uz = L::add(L::add(L::mul(vz, d), L::mul(tz, s)), L::sub(L::mul(vx, ty), L::mul(vy, tx)));
+}
+
+/**
+	Clamps the torque component t to [-scale * maxTorque, scale * maxTorque], the same way PoseController::limitTorque does.
+*/
+template <class L> static inline typename L::Value limitLanes(typename L::Value t, typename L::Value scale, typename L::Value maxTorque){
+	typedef typename L::Value V;
+	V lo = L::mul(L::mul(scale, L::set(-1)), maxTorque);
+	V hi = L::mul(scale, maxTorque);
+	t = L::select(L::lessThan(t, lo), lo, t);
+	return L::select(L::greaterThan(t, hi), hi, t);
+}
+
+/**
+	This is PoseController::computePDTorque, followed by the rotation to the output frame, for L::width joints starting at i.
+*/
+template <class L> static inline void computePDTorqueLanes(double** f, int i){
+	typedef typename L::Value V;
+	typedef typename L::Mask M;
+
+	V qs = L::load(f[PD_Q_S] + i), qx = L::load(f[PD_Q_X] + i), qy = L::load(f[PD_Q_Y] + i), qz = L::load(f[PD_Q_Z] + i);
+	V ds = L::load(f[PD_QD_S] + i), dx = L::load(f[PD_QD_X] + i), dy = L::load(f[PD_QD_Y] + i), dz = L::load(f[PD_QD_Z] + i);
+	V minusOne = L::set(-1);
+
+	//qErr = qRel.getComplexConjugate() * qRelD
+	V ax = L::mul(qx, minusOne), ay = L::mul(qy, minusOne), az = L::mul(qz, minusOne);
+	V es = L::sub(L::mul(qs, ds), L::add(L::add(L::mul(ax, dx), L::mul(ay, dy)), L::mul(az, dz)));
+	V ex = L::add(L::add(L::mul(dx, qs), L::mul(ax, ds)), L::sub(L::mul(ay, dz), L::mul(az, dy)));
+	V ey = L::add(L::add(L::mul(dy, qs), L::mul(ay, ds)), L::sub(L::mul(az, dx), L::mul(ax, dz)));
+	V ez = L::add(L::add(L::mul(dz, qs), L::mul(az, ds)), L::sub(L::mul(ax, dy), L::mul(ay, dx)));
+
+	//scale qErr.v by the angle instead of sin(angle), taking the sign of the scalar part into account. There is no proportional term if the orientations match
+	V one = L::set(1), zero = L::set(0);
+	V sinTheta = L::sqrtOf(L::add(L::add(L::mul(ex, ex), L::mul(ey, ey)), L::mul(ez, ez)));
+	sinTheta = L::select(L::greaterThan(sinTheta, one), one, sinTheta);
+	M isZero = L::both(L::greaterThan(sinTheta, L::set(-EPSILON)), L::lessThan(sinTheta, L::set(EPSILON)));
+	V absAngle = L::mul(L::set(2), L::asinOf(sinTheta));
+	V sign = L::select(L::lessThan(es, zero), minusOne, one);
+	V factor = L::mul(L::mul(L::mul(L::div(one, sinTheta), absAngle), L::mul(L::load(f[PD_KP] + i), minusOne)), sign);
+	V tx = L::select(isZero, zero, L::mul(ex, factor));
+	V ty = L::select(isZero, zero, L::mul(ey, factor));
+	V tz = L::select(isZero, zero, L::mul(ez, factor));
+
+	//the torque is in child coordinates, so express it in parent coordinates, and add the damping term
+	rotateLanes<L>(qs, qx, qy, qz, &tx, &ty, &tz);
+	V minusKd = L::mul(L::load(f[PD_KD] + i), minusOne);
+	tx = L::add(tx, L::mul(L::sub(L::load(f[PD_WD_X] + i), L::load(f[PD_W_X] + i)), minusKd));
+	ty = L::add(ty, L::mul(L::sub(L::load(f[PD_WD_Y] + i), L::load(f[PD_W_Y] + i)), minusKd));
+	tz = L::add(tz, L::mul(L::sub(L::load(f[PD_WD_Z] + i), L::load(f[PD_W_Z] + i)), minusKd));
+	V strength = L::load(f[PD_STRENGTH] + i);
+	tx = L::mul(tx, strength);
+	ty = L::mul(ty, strength);
+	tz = L::mul(tz, strength);
+
+	//scale and limit the torque in child coordinates, and go back to parent coordinates
+	V sx = L::load(f[PD_SCALE_X] + i), sy = L::load(f[PD_SCALE_Y] + i), sz = L::load(f[PD_SCALE_Z] + i);
+	V maxTorque = L::load(f[PD_MAX_TORQUE] + i);
+	rotateLanes<L>(qs, ax, ay, az, &tx, &ty, &tz);
+	tx = limitLanes<L>(L::mul(tx, sx), sx, maxTorque);
+	ty = limitLanes<L>(L::mul(ty, sy), sy, maxTorque);
+	tz = limitLanes<L>(L::mul(tz, sz), sz, maxTorque);
+	rotateLanes<L>(qs, L::mul(ax, minusOne), L::mul(ay, minusOne), L::mul(az, minusOne), &tx, &ty, &tz);
+
+	//and finally express it in the output frame
+	rotateLanes<L>(L::load(f[PD_F_S] + i), L::load(f[PD_F_X] + i), L::load(f[PD_F_Y] + i), L::load(f[PD_F_Z] + i), &tx, &ty, &tz);
+
+	L::store(f[PD_T_X] + i, tx);
+	L::store(f[PD_T_Y] + i, ty);
+	L::store(f[PD_T_Z] + i, tz);
+}
+
+PDTorqueBatch::PDTorqueBatch(void){
+	count = 0;
+	stride = 0;
+}
+
+PDTorqueBatch::~PDTorqueBatch(void){
+}
+
+/**
+	This method sets the number of joints in the batch. The storage is only reallocated when the batch grows.
+*/
+void PDTorqueBatch::resize(int n){
+	count = n;
+	stride = (n + 3) & ~3;
+	if (data.size() < (uint)(PD_FIELD_COUNT * stride))
+		data.resize(PD_FIELD_COUNT * stride);
+	//the padding lanes are processed by the vectorized kernel too, so make sure they hold harmless values
+	for (int k=0;k<PD_FIELD_COUNT;k++)
+		for (int i=count;i<stride;i++)
+			data[k * stride + i] = 0;
+}
+
+/**
+	This method sets the state of the ith joint: the current and desired relative orientation and angular velocity (in parent coordinates), and the
+	orientation of the frame that the torque will be expressed in (the torque is computed in parent coordinates, and then rotated by frame).
+*/
+void PDTorqueBatch::setJointState(int i, const Quaternion& qRel, const Quaternion& qRelD, const Vector3d& wRel, const Vector3d& wRelD, const Quaternion& frame){
+	getField(PD_Q_S)[i] = qRel.s; getField(PD_Q_X)[i] = qRel.v.x; getField(PD_Q_Y)[i] = qRel.v.y; getField(PD_Q_Z)[i] = qRel.v.z;
+	getField(PD_QD_S)[i] = qRelD.s; getField(PD_QD_X)[i] = qRelD.v.x; getField(PD_QD_Y)[i] = qRelD.v.y; getField(PD_QD_Z)[i] = qRelD.v.z;
+	getField(PD_W_X)[i] = wRel.x; getField(PD_W_Y)[i] = wRel.y; getField(PD_W_Z)[i] = wRel.z;
+	getField(PD_WD_X)[i] = wRelD.x; getField(PD_WD_Y)[i] = wRelD.y; getField(PD_WD_Z)[i] = wRelD.z;
+	getField(PD_F_S)[i] = frame.s; getField(PD_F_X)[i] = frame.v.x; getField(PD_F_Y)[i] = frame.v.y; getField(PD_F_Z)[i] = frame.v.z;
+}
+
+/**
+	This method sets the gains, the strength, the per axis scale and the torque limit of the ith joint.
+*/
+void PDTorqueBatch::setJointGains(int i, double kp, double kd, double strength, const Vector3d& scale, double maxAbsTorque){
+	getField(PD_KP)[i] = kp;
+	getField(PD_KD)[i] = kd;
+	getField(PD_STRENGTH)[i] = strength;
+	getField(PD_SCALE_X)[i] = scale.x; getField(PD_SCALE_Y)[i] = scale.y; getField(PD_SCALE_Z)[i] = scale.z;
+	getField(PD_MAX_TORQUE)[i] = maxAbsTorque;
+}
+
+/**
+	This method computes the torques of all the joints in the batch.
+*/
+void PDTorqueBatch::computeTorques(){
+	if (count == 0)
+		return;
+
+	double* f[PD_FIELD_COUNT];
+	for (int k=0;k<PD_FIELD_COUNT;k++)
+		f[k] = getField(k);
+
+#ifdef PD_TORQUE_AVX
+	if (isVectorized()){
+		for (int i=0;i<stride;i+=PDAVXLanes::width)
+			computePDTorqueLanes<PDAVXLanes>(f, i);
+		return;
+	}
+#endif
+	for (int i=0;i<count;i++)
+		computePDTorqueLanes<PDScalarLanes>(f, i);
+}
+
+#if defined(PD_TORQUE_AVX) && defined(_MSC_VER)
+/**
+	returns true if the CPU supports AVX, and the OS saves the AVX registers (XSAVE enabled, and the SSE and AVX state bits set in XCR0)
+*/
+static bool detectAvx(){
+	int info[4];
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	return osxsave && avx && (_xgetbv(0) & 6) == 6;
+}
+
+//detected once when the program starts, before any thread can ask for it. This is not a local static, since Visual Studio 2012 does
+//not make their initialization thread safe
+static const bool avxSupported = detectAvx();
+#endif
+
+/**
+	returns true if the torques are computed with AVX instructions on this machine
+*/
+bool PDTorqueBatch::isVectorized(){
+#if defined(PD_TORQUE_AVX) && defined(_MSC_VER)
+	return avxSupported;
+#elif defined(PD_TORQUE_AVX)
+	//the whole file was compiled for AVX
+	return true;
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <PUtils.h>
+#include <Vector3d.h>
+#include <Quaternion.h>
+
+//the inputs and outputs of the batch, one array of each in the packed buffer
+enum PDTorqueBatchField{
+	//the current relative orientation of the child with respect to the parent, and the desired one
+	PD_Q_S = 0, PD_Q_X, PD_Q_Y, PD_Q_Z,
+	PD_QD_S, PD_QD_X, PD_QD_Y, PD_QD_Z,
+	//the current relative angular velocity, and the desired one, in parent coordinates
+	PD_W_X, PD_W_Y, PD_W_Z,
+	PD_WD_X, PD_WD_Y, PD_WD_Z,
+	//the orientation of the frame that the parent coordinates are rotated to once the torque is computed
+	PD_F_S, PD_F_X, PD_F_Y, PD_F_Z,
+	//the gains, the strength, the per axis scale and the torque limit
+	PD_KP, PD_KD, PD_STRENGTH, PD_SCALE_X, PD_SCALE_Y, PD_SCALE_Z, PD_MAX_TORQUE,
+	//and the resulting torque
+	PD_T_X, PD_T_Y, PD_T_Z,
+	PD_FIELD_COUNT
+};
+
+/**
+	This class computes the PD torques of many joints in one pass. The inputs of the joints are packed into one buffer, one contiguous array per
+	quantity, so that four joints at a time can be processed with AVX instructions when the CPU supports them. The operations are the same, and
+	are done in the same order, as in PoseController::computePDTorque, so the results match the ones of the scalar code.
+*/
+class PDTorqueBatch{
+private:
+	//all the arrays, one after the other. Each one of them has room for stride joints
+	DynamicArray<double> data;
+	//the number of joints in the batch, and the length of each array (the number of joints rounded up to a multiple of four)
+	int count;
+	int stride;
+
+	inline double* getField(int field){
+		return &data[field * stride];
+	}
+
+public:
+	PDTorqueBatch(void);
+	~PDTorqueBatch(void);
+
+	/**
+		This method sets the number of joints in the batch. The storage is only reallocated when the batch grows.
+	*/
+	void resize(int n);
+
+	/**
+		returns the number of joints in the batch
+	*/
+	inline int getCount(){
+		return count;
+	}
+
+	/**
+		This method sets the state of the ith joint: the current and desired relative orientation and angular velocity (in parent coordinates), and the
+		orientation of the frame that the torque will be expressed in (the torque is computed in parent coordinates, and then rotated by frame).
+	*/
+	void setJointState(int i, const Quaternion& qRel, const Quaternion& qRelD, const Vector3d& wRel, const Vector3d& wRelD, const Quaternion& frame);
+
+	/**
+		This method sets the gains, the strength, the per axis scale and the torque limit of the ith joint.
+	*/
+	void setJointGains(int i, double kp, double kd, double strength, const Vector3d& scale, double maxAbsTorque);
+
+	/**
+		This method computes the torques of all the joints in the batch.
+	*/
+	void computeTorques();
+
+	/**
+		returns the torque that was computed for the ith joint
+	*/
+	inline Vector3d getTorque(int i){
+		return Vector3d(data[PD_T_X * stride + i], data[PD_T_Y * stride + i], data[PD_T_Z * stride + i]);
+	}
+
+	/**
+		returns true if the torques are computed with AVX instructions on this machine
+	*/
+	static bool isVectorized();
+};
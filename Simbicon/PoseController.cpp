@@ -26,9 +26,9 @@
 #include "PoseController.h"
 #include <Quaternion.h>
 #include "ConUtils.h"
+#include "ConBinary.h"
 #include <PUtils.h>
 #include <iostream>
-#include <conio.h>
 
 using namespace std;
 
@@ -51,6 +51,10 @@ PoseController::PoseController(Character* ch) : Controller(ch)
 		rs.setJointRelativeOrientation(Quaternion(), i);
 		torques.push_back(Vector3d());
 	}
+
+	//the batch never holds more than all the joints, so it gets its storage now rather than during the first control step
+	pdBatchJoints.reserve(jointCount);
+	pdBatch.resize(jointCount);
 }
 
 PoseController::~PoseController(void){
@@ -140,39 +144,42 @@ void PoseController::scaleAndLimitTorque(Vector3d* torque, ControlParams* cParam
 	This method is used to compute the torques that are to be applied at the next step.
 */
 void PoseController::computeTorques(DynamicArray<ContactPoint> *cfs){
-	Quaternion qRelD;
-	Vector3d relAngVelD;
-
 	Quaternion qRel;
 	Vector3d wRel;
 
 	ReducedCharacterState rs(&desiredPose);
 
+	//collect the controlled joints, so that all their torques get computed in one pass
+	pdBatchJoints.clear();
 	for (int i=0;i<jointCount;i++){
-		if (controlParams[i].controlled == true){
-			if (controlParams[i].relToCharFrame == false){
-				//get the current relative orientation between the child and parent
-				character->getRelativeOrientation(i, &qRel);
-				//and the relative angular velocity, computed in parent coordinates
-				character->getRelativeAngularVelocity(i, &wRel);
-				//now compute the torque
-				torques[i] = computePDTorque(qRel, rs.getJointRelativeOrientation(i), wRel, rs.getJointRelativeAngVelocity(i), &controlParams[i]);
-               
-                //_cprintf("Velocity: %lf\n", rs.getJointRelativeAngVelocity(i));
-   
-
-				//the torque is expressed in parent coordinates, so we need to convert it to world coords now
-				torques[i] = character->getJoint(i)->getParent()->getWorldCoordinates(torques[i]);
-			}
-            else
-            {
-				RigidBody* childRB = character->getJoint(i)->getChild();
-				torques[i] = computePDTorque(childRB->getOrientation(), controlParams[i].charFrame * rs.getJointRelativeOrientation(i), childRB->getAngularVelocity(), rs.getJointRelativeAngVelocity(i), &controlParams[i]);
-			}
-		}else{
+		if (controlParams[i].controlled == true)
+			pdBatchJoints.push_back(i);
+		else
 			torques[i].setValues(0,0,0);
+	}
+	pdBatch.resize(pdBatchJoints.size());
+
+	for (uint k=0;k<pdBatchJoints.size();k++){
+		int i = pdBatchJoints[k];
+		if (controlParams[i].relToCharFrame == false){
+			//get the current relative orientation between the child and parent
+			character->getRelativeOrientation(i, &qRel);
+			//and the relative angular velocity, computed in parent coordinates
+			character->getRelativeAngularVelocity(i, &wRel);
+			//the torque is expressed in parent coordinates, so it gets converted to world coords with the orientation of the parent
+			pdBatch.setJointState(k, qRel, rs.getJointRelativeOrientation(i), wRel, rs.getJointRelativeAngVelocity(i), character->getJoint(i)->getParent()->getOrientation());
+		}
+		else
+		{
+			RigidBody* childRB = character->getJoint(i)->getChild();
+			pdBatch.setJointState(k, childRB->getOrientation(), controlParams[i].charFrame * rs.getJointRelativeOrientation(i), childRB->getAngularVelocity(), rs.getJointRelativeAngVelocity(i), Quaternion(1, 0, 0, 0));
 		}
+		pdBatch.setJointGains(k, controlParams[i].kp, controlParams[i].kd, controlParams[i].strength, controlParams[i].scale, controlParams[i].maxAbsTorque);
 	}
+
+	pdBatch.computeTorques();
+	for (uint k=0;k<pdBatchJoints.size();k++)
+		torques[pdBatchJoints[k]] = pdBatch.getTorque(k);
 }
 
 /**
@@ -281,6 +288,53 @@ void PoseController::writeGains(std::ofstream& f){
 }
 
 
+/**
+	This method is used to read the gain coefficients, as well as max torque allowed for each joint, from a compiled controller.
+*/
+void PoseController::readGains(ConBinaryReader& r){
+	char jName[100];
+	//every joint has its name and six doubles
+	int gainCount = r.readCount(sizeof(int) + 6 * sizeof(double));
+	for (int i=0;i<gainCount;i++){
+		r.readString(jName, 100);
+		double kp = r.readDouble();
+		double kd = r.readDouble();
+		double tMax = r.readDouble();
+		Vector3d scale = r.readVector();
+		if (r.hasFailed())
+			return;
+		int jIndex = character->getJointIndex(jName);
+		if (jIndex < 0)
+			continue;
+		controlParams[jIndex].kp = kp;
+		controlParams[jIndex].kd = kd;
+		controlParams[jIndex].maxAbsTorque = tMax;
+		controlParams[jIndex].scale = scale;
+	}
+}
+
+/**
+	This method is used to write the gain coefficients, as well as max torque allowed for each joint, to a compiled controller.
+*/
+void PoseController::writeGains(ConBinaryWriter& w){
+	int gainCount = 0;
+	for (uint jIndex=0;jIndex<controlParams.size();jIndex++)
+		if (character->getJoint(jIndex) != NULL)
+			gainCount++;
+
+	w.writeInt(gainCount);
+	for (uint jIndex=0;jIndex<controlParams.size();jIndex++){
+		Joint* joint = character->getJoint(jIndex);
+		if (joint == NULL)
+			continue;
+		w.writeString(joint->getName());
+		w.writeDouble(controlParams[jIndex].kp);
+		w.writeDouble(controlParams[jIndex].kd);
+		w.writeDouble(controlParams[jIndex].maxAbsTorque);
+		w.writeVector(controlParams[jIndex].scale);
+	}
+}
+
 /**
 	This method is used to read the gain coefficients, as well as max torque allowed for each joint
 	from the file that is passed in as a parameter.
@@ -26,9 +26,11 @@
 #include <PUtils.h>
 #include "Controller.h"
 #include "Character.h"
+#include "PDTorqueBatch.h"
 #include <fstream>
 
-
+class ConBinaryReader;
+class ConBinaryWriter;
 
 /**
 	This class is used as a container for the properties needed by a PD controller
@@ -80,6 +82,10 @@ protected:
 	//this is the array of joint properties used to specify the 
 	DynamicArray<ControlParams> controlParams;
 
+	//the PD torques of all the controlled joints are computed together, in this batch. The second array holds the index of the joint in each slot
+	PDTorqueBatch pdBatch;
+	DynamicArray<int> pdBatchJoints;
+
 	/**
 		This method is used to parse the information passed in the string. This class knows how to read lines
 		that have the name of a joint, followed by a list of the pertinent parameters. If this assumption is not held,
@@ -139,6 +145,13 @@ public:
 
     void writeGains(std::ofstream& f);
 
+	/**
+		These methods are used to read and write the gain coefficients, as well as max torque allowed for each joint, in a compiled
+		controller. The joints are stored by name, and the ones that the character does not have are skipped, as in the text files.
+	*/
+	void readGains(ConBinaryReader& r);
+	void writeGains(ConBinaryWriter& w);
+
 	/**
 		sets the targets to match the current state of the character
 	*/
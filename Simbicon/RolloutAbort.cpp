@@ -0,0 +1,115 @@
+#include "stdafx.h"
+
+#include "RolloutAbort.h"
+#include <PhysicsGlobals.h>
+
+COMHeightAbort::COMHeightAbort(double minHeightRatio){
+	this->minHeightRatio = minHeightRatio;
+	minHeight = 0;
+}
+
+void COMHeightAbort::reset(Character* ch){
+	minHeight = ch->getCOM().dotProductWith(PhysicsGlobals::up) * minHeightRatio;
+}
+
+bool COMHeightAbort::shouldAbort(Character* ch, double dt){
+	return ch->getCOM().dotProductWith(PhysicsGlobals::up) < minHeight;
+}
+
+TorsoTiltAbort::TorsoTiltAbort(double maxTilt, const char* bodyName){
+	this->maxTilt = maxTilt;
+	strncpy(this->bodyName, bodyName, 99);
+	this->bodyName[99] = '\0';
+}
+
+bool TorsoTiltAbort::shouldAbort(Character* ch, double dt){
+	RigidBody* body = ch->getARBByName(bodyName);
+	if (body == NULL)
+		body = ch->getRoot();
+	Vector3d bodyUp = body->getWorldCoordinates(PhysicsGlobals::up);
+	return bodyUp.angleWith(PhysicsGlobals::up) > maxTilt;
+}
+
+NoProgressAbort::NoProgressAbort(double minDistance, double timeWindow){
+	this->minDistance = minDistance;
+	this->timeWindow = timeWindow;
+	timeInWindow = 0;
+}
+
+void NoProgressAbort::reset(Character* ch){
+	windowStart = ch->getCOM();
+	timeInWindow = 0;
+}
+
+bool NoProgressAbort::shouldAbort(Character* ch, double dt){
+	timeInWindow += dt;
+	if (timeInWindow < timeWindow)
+		return false;
+	//only the horizontal motion counts
+	Vector3d com = ch->getCOM();
+	Vector3d moved = com - windowStart;
+	moved -= PhysicsGlobals::up * moved.dotProductWith(PhysicsGlobals::up);
+	if (moved.length() < minDistance)
+		return true;
+	//the character is getting somewhere, so a new window starts here
+	windowStart = com;
+	timeInWindow = 0;
+	return false;
+}
+
+DivergenceAbort::DivergenceAbort(double maxSpeed){
+	this->maxSpeed = maxSpeed;
+}
+
+/**
+	returns true if one of the components of v is not a number, or is larger than bound in magnitude. NaNs fail every comparison, so
+	they are caught along with the infinite values
+*/
+static bool isOutOfBounds(const Vector3d& v, double bound){
+	return !(fabs(v.x) <= bound && fabs(v.y) <= bound && fabs(v.z) <= bound);
+}
+
+bool DivergenceAbort::shouldAbort(Character* ch, double dt){
+	//nothing in a simulation is ever this far away from the origin
+	const double maxPosition = 1e6;
+	for (int i=-1;i<ch->getJointCount();i++){
+		RigidBody* rb = (i < 0) ? ch->getRoot() : ch->getJoint(i)->getChild();
+		Quaternion q = rb->getOrientation();
+		if (isOutOfBounds(Vector3d(rb->getCMPosition()), maxPosition) || isOutOfBounds(q.v, 1) || !(fabs(q.s) <= 1) ||
+			isOutOfBounds(rb->getCMVelocity(), maxSpeed) || isOutOfBounds(rb->getAngularVelocity(), maxSpeed))
+			return true;
+	}
+	return false;
+}
+
+RolloutAbortSet::~RolloutAbortSet(void){
+	for (uint i=0;i<predicates.size();i++)
+		delete predicates[i];
+	predicates.clear();
+}
+
+/**
+	This method adds a predicate to the set. The set deletes it when it is deleted itself.
+*/
+void RolloutAbortSet::addPredicate(RolloutAbortPredicate* predicate_disown){
+	predicates.push_back(predicate_disown);
+}
+
+/**
+	This method resets all the predicates at the start of a rollout.
+*/
+void RolloutAbortSet::reset(Character* ch){
+	for (uint i=0;i<predicates.size();i++)
+		predicates[i]->reset(ch);
+}
+
+/**
+	This method checks all the predicates after a simulation step, and returns the first one that stops the rollout, or NULL if the
+	rollout can go on.
+*/
+RolloutAbortPredicate* RolloutAbortSet::check(Character* ch, double dt){
+	for (uint i=0;i<predicates.size();i++)
+		if (predicates[i]->shouldAbort(ch, dt))
+			return predicates[i];
+	return NULL;
+}
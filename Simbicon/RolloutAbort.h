@@ -0,0 +1,122 @@
+#pragma once
+
+#include <PUtils.h>
+#include <Vector3d.h>
+#include "Character.h"
+
+/**
+	This is the base class of the tests that decide that a rollout has failed before the character actually falls, so that an optimizer
+	does not keep simulating a candidate that cannot recover. A predicate is reset when a rollout starts, and is then checked after each
+	simulation step.
+*/
+class RolloutAbortPredicate{
+public:
+	virtual ~RolloutAbortPredicate(void){}
+
+	/**
+		This method is called at the start of every rollout, with the character in its initial state.
+	*/
+	virtual void reset(Character* ch){}
+
+	/**
+		This method is called after every simulation step of length dt. It returns true if the rollout should be stopped.
+	*/
+	virtual bool shouldAbort(Character* ch, double dt) = 0;
+
+	/**
+		returns a short name for the predicate, to report why a rollout was stopped
+	*/
+	virtual const char* getName() = 0;
+};
+
+/**
+	The rollout fails once the center of mass of the character drops below a fraction of the height it started at.
+*/
+class COMHeightAbort : public RolloutAbortPredicate{
+private:
+	double minHeightRatio;
+	double minHeight;
+public:
+	COMHeightAbort(double minHeightRatio = 0.6);
+	virtual void reset(Character* ch);
+	virtual bool shouldAbort(Character* ch, double dt);
+	virtual const char* getName(){ return "COM height"; }
+};
+
+/**
+	The rollout fails once the up axis of a body of the character (the torso, or the root if there is no body with that name) is tilted
+	away from the vertical by more than maxTilt radians.
+*/
+class TorsoTiltAbort : public RolloutAbortPredicate{
+private:
+	double maxTilt;
+	char bodyName[100];
+public:
+	TorsoTiltAbort(double maxTilt = 1.0, const char* bodyName = "torso");
+	virtual bool shouldAbort(Character* ch, double dt);
+	virtual const char* getName(){ return "torso tilt"; }
+};
+
+/**
+	The rollout fails if the center of mass of the character has not moved, horizontally, by at least minDistance over any window of
+	timeWindow seconds.
+*/
+class NoProgressAbort : public RolloutAbortPredicate{
+private:
+	double minDistance;
+	double timeWindow;
+	//where the center of mass was at the start of the current window, and how long ago that was
+	Vector3d windowStart;
+	double timeInWindow;
+public:
+	NoProgressAbort(double minDistance = 0.1, double timeWindow = 2.0);
+	virtual void reset(Character* ch);
+	virtual bool shouldAbort(Character* ch, double dt);
+	virtual const char* getName(){ return "no progress"; }
+};
+
+/**
+	The rollout fails if the state of any body of the character is not a number, is infinite, or is moving faster than maxSpeed (linear,
+	in m/s, or angular, in rad/s). Past that point the simulation has blown up and nothing it computes is meaningful.
+*/
+class DivergenceAbort : public RolloutAbortPredicate{
+private:
+	double maxSpeed;
+public:
+	DivergenceAbort(double maxSpeed = 100);
+	virtual bool shouldAbort(Character* ch, double dt);
+	virtual const char* getName(){ return "divergence"; }
+};
+
+/**
+	This class holds a list of predicates, and checks all of them at once. It owns the predicates that are added to it.
+*/
+class RolloutAbortSet{
+private:
+	DynamicArray<RolloutAbortPredicate*> predicates;
+public:
+	~RolloutAbortSet(void);
+
+	/**
+		This method adds a predicate to the set. The set deletes it when it is deleted itself.
+	*/
+	void addPredicate(RolloutAbortPredicate* predicate_disown);
+
+	/**
+		This method resets all the predicates at the start of a rollout.
+	*/
+	void reset(Character* ch);
+
+	/**
+		This method checks all the predicates after a simulation step, and returns the first one that stops the rollout, or NULL if the
+		rollout can go on.
+	*/
+	RolloutAbortPredicate* check(Character* ch, double dt);
+
+	/**
+		returns the number of predicates in the set
+	*/
+	inline int getPredicateCount(){
+		return (int)predicates.size();
+	}
+};
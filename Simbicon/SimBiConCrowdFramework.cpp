@@ -0,0 +1,145 @@
+#include "stdafx.h"
+
+#include "SimBiConCrowdFramework.h"
+#include <PUtils.h>
+#include "ConUtils.h"
+#include <Profiler.h>
+
+SimBiConCrowdFramework::SimBiConCrowdFramework(char* input, int characterCount, double spacing, char* conFile){
+	//create the physical world - all the characters share it
+	pw = World::create();
+	bip = NULL;
+	if (characterCount < 1)
+		characterCount = 1;
+	bool conLoaded = false;
+
+	//now we'll interpret the input file...
+	FILE *f = fopen(input, "r");
+	if (f == NULL){
+		printf("Cannot open the input file %s\n", input);
+		return;
+	}
+
+	//have a temporary buffer used to read the file line by line...
+	char buffer[200];
+	//this is where it happens.
+	while (!feof(f)){
+		//get a line from the file...
+		fgets(buffer, 200, f);
+		if (feof(f))
+			break;
+		char *line = lTrim(buffer);
+		int lineType = getConLineType(line);
+		switch (lineType) {
+		case LOAD_RB_FILE:
+			loadRBFile(trim(line), characterCount);
+			break;
+		case LOAD_CON_FILE:
+			if( conFile != NULL ) break; // Controller file
+			for (uint i=0;i<controllers.size();i++)
+				controllers[i]->loadFromFile(trim(line));
+			conLoaded = true;
+			break;
+		case CON_NOT_IMPORTANT:
+			break;
+		case CON_COMMENT:
+			break;
+		default:
+			fclose(f);
+			return;
+		}
+	}
+	fclose(f);
+
+	if( conFile != NULL ) {
+		for (uint i=0;i<controllers.size();i++)
+			controllers[i]->loadFromFile(conFile);
+		conLoaded = true;
+	}
+
+	if (!conLoaded)
+		return;
+
+	//the controller file puts every character in the same starting state, so now they are spread out. Every body is moved by the same
+	//amount, which leaves the pose and the velocities of the character exactly as they were
+	for (uint i=1;i<characters.size();i++){
+		Vector3d offset(i * spacing, 0, 0);
+		RigidBody* root = characters[i]->getRoot();
+		root->setCMPosition(root->getCMPosition() + offset);
+		for (int j=0;j<characters[i]->getJointCount();j++){
+			RigidBody* rb = characters[i]->getJoint(j)->getChild();
+			rb->setCMPosition(rb->getCMPosition() + offset);
+		}
+		controllers[i]->updateDAndV();
+	}
+}
+
+SimBiConCrowdFramework::~SimBiConCrowdFramework(void){
+	for (uint i=0;i<controllers.size();i++)
+		delete controllers[i];
+	//the first character is bip, which the base class deletes
+	for (uint i=1;i<characters.size();i++)
+		delete characters[i];
+}
+
+/**
+	This method loads the .rbs file that is passed in. If it contains an articulated figure, it is loaded once for every character.
+*/
+void SimBiConCrowdFramework::loadRBFile(char* fName, int characterCount){
+	int afCount = pw->getAFCount();
+	pw->loadRBsFromFile(fName);
+	//files without a character (the ground, props) are only loaded once
+	if (pw->getAFCount() == afCount || characters.size() > 0)
+		return;
+	for (int i=1;i<characterCount;i++)
+		pw->loadRBsFromFile(fName);
+
+	//there is one character, and one controller, for each one of the figures
+	for (int i=afCount;i<pw->getAFCount();i++){
+		characters.push_back(new Character(pw->getAF(i)));
+		controllers.push_back(new SimBiController(characters[characters.size()-1]));
+	}
+	bip = characters[0];
+}
+
+/**
+	this method is used to advance the simulation. The control of every character is computed, then the world takes one simulation step,
+	and then the controllers are advanced in time. This method returns true if any of the controllers transitions to a new state,
+	false otherwise.
+*/
+bool SimBiConCrowdFramework::advanceInTime(double dt, bool applyControl, bool recomputeTorques, bool advanceWorldInTime){
+	PROFILE_SCOPE(PROFILE_SIMULATION_STEP);
+	DynamicArray<ContactPoint>* cfs = pw->getContactForces();
+	int n = (int)controllers.size();
+
+	//every controller only reads the state of the world and writes the torques of its own character, so they can all run at the same time
+	#pragma omp parallel for
+	for (int i=0;i<n;i++){
+		if (applyControl == false)
+			controllers[i]->resetTorques();
+		else
+			if (recomputeTorques == true){
+				PROFILE_SCOPE(PROFILE_CONTROLLER_COMPUTE);
+				controllers[i]->computeTorques(cfs);
+			}
+
+		//not applying control is the same as just resetting the torques
+		PROFILE_SCOPE(PROFILE_TORQUE_APPLICATION);
+		controllers[i]->applyTorques();
+	}
+
+	//one step of the world for the whole crowd
+	if (advanceWorldInTime)
+		pw->advanceInTime(dt);
+
+	int newFSMStates = 0;
+	#pragma omp parallel for reduction(+:newFSMStates)
+	for (int i=0;i<n;i++){
+		PROFILE_SCOPE(PROFILE_FSM_TRANSITION);
+		if (controllers[i]->advanceInTime(dt, cfs) != -1)
+			newFSMStates++;
+		controllers[i]->updateDAndV();
+	}
+
+	return newFSMStates > 0;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "BaseControlFramework.h"
+#include "Character.h"
+#include "SimBiController.h"
+
+/**
+	This class is used to simulate a crowd: many copies of the same simbicon character, each one with its own controller, all in one world.
+	The torques of all the characters are computed first (in parallel when OpenMP is enabled), and then the world takes a single step for
+	all of them, so the cost of a step of the physics engine is shared by the whole crowd instead of being paid once per character.
+*/
+class SimBiConCrowdFramework : public BaseControlFramework
+{
+protected:
+	//the characters of the crowd, and their controllers, in the same order as the articulated figures of the world. bip is characters[0]
+	DynamicArray<Character*> characters;
+	DynamicArray<SimBiController*> controllers;
+
+	/**
+		This method loads the .rbs file that is passed in. If it contains an articulated figure, it is loaded once for every character.
+	*/
+	void loadRBFile(char* fName, int characterCount);
+
+public:
+	/**
+		Constructor. The input file is read just like the one of a SimBiConFramework, but the character is loaded characterCount times. The
+		characters are placed next to each other, spacing meters apart along the x axis.
+	*/
+	SimBiConCrowdFramework(char* input, int characterCount, double spacing = 1.0, char* conFile = NULL);
+	virtual ~SimBiConCrowdFramework(void);
+
+	/**
+		this method is used to advance the simulation. The control of every character is computed, then the world takes one simulation step,
+		and then the controllers are advanced in time. This method returns true if any of the controllers transitions to a new state,
+		false otherwise.
+	*/
+	virtual bool advanceInTime(double dt, bool applyControl = true, bool recomputeTorques = true, bool advanceWorldInTime = true);
+
+	/**
+		returns the number of characters in the crowd
+	*/
+	inline int getCharacterCount(){
+		return (int)characters.size();
+	}
+
+	using BaseControlFramework::getCharacter;
+
+	/**
+		returns the ith character of the crowd
+	*/
+	inline Character* getCharacter(int i){
+		return characters[i];
+	}
+
+	/**
+		returns the controller of the ith character of the crowd
+	*/
+	inline SimBiController* getController(int i){
+		return controllers[i];
+	}
+};
@@ -28,11 +28,11 @@
 #include "PoseController.h"
 #include "SimBiController.h"
 #include "SimGlobals.h"
-#include <PhysX3World.h>
+#include <Profiler.h>
 
 SimBiConFramework::SimBiConFramework(char* input, char* conFile){
-    //create the physical world...
-    pw = SimGlobals::getRBEngine();
+    //create the physical world - every framework gets its own, so several of them can be simulated side by side
+    pw = World::create();
     con = NULL;
     bip = NULL;
     bool conLoaded = false;
@@ -106,18 +106,24 @@ SimBiConFramework::~SimBiConFramework(void){
 	otherwise.
 */
 bool SimBiConFramework::advanceInTime(double dt, bool applyControl, bool recomputeTorques, bool advanceWorldInTime){
+	PROFILE_SCOPE(PROFILE_SIMULATION_STEP);
 	if (applyControl == false) 
 		con->resetTorques();
 	else
-		if (recomputeTorques == true)
+		if (recomputeTorques == true){
+			PROFILE_SCOPE(PROFILE_CONTROLLER_COMPUTE);
 			con->computeTorques(pw->getContactForces());
+		}
 
 	//not applying control is the same as just resetting the torques
-	con->applyTorques();
+	{
+		PROFILE_SCOPE(PROFILE_TORQUE_APPLICATION);
+		con->applyTorques();
+	}
 	if (advanceWorldInTime)
 		pw->advanceInTime(dt);
 
-
+	PROFILE_SCOPE(PROFILE_FSM_TRANSITION);
 	bool newFSMState = (con->advanceInTime(dt, pw->getContactForces()) != -1);
 	con->updateDAndV();
 
@@ -136,30 +142,26 @@ bool SimBiConFramework::advanceInTime(double dt, bool applyControl, bool recompu
 	populates the structure that is passed in with the state of the framework
 */
 void SimBiConFramework::getState(SimBiConFrameworkState* conFState){
-	conFState->worldState.clear();
-	//read in the state of the world (we'll assume that the rigid bodies and the ode world are synchronized), and the controller
-	pw->getState(&(conFState->worldState));
+	//read in the state of the world (we'll assume that the rigid bodies and the physics engine are synchronized), along with the contact
+	//force information, and the controller
+	pw->saveSnapshot(&(conFState->worldSnapshot));
 	con->getControllerState(&(conFState->conState));
 	conFState->lastFootPos = lastFootPos;
-	//now copy over the contact force information
-	conFState->cfi.clear();
-	DynamicArray<ContactPoint> *cfs = pw->getContactForces();
-	for (uint i=0;i<cfs->size();i++){
-		conFState->cfi.push_back(ContactPoint((*cfs)[i]));
-	}
+	conFState->lastStepTaken = lastStepTaken;
 }
 
 /**
-	populates the state of the framework with information passed in with the state of the framework
+	populates the state of the framework with information passed in with the state of the framework. Returns false if the state was not
+	taken from this framework.
 */
-void SimBiConFramework::setState(SimBiConFrameworkState& conFState){
+bool SimBiConFramework::setState(SimBiConFrameworkState& conFState){
 	//set the state of the world, and that of the controller
-	pw->setState(&(conFState.worldState));
+	if (!pw->restoreSnapshot(conFState.worldSnapshot))
+		return false;
 	con->setControllerState(conFState.conState);
 	lastFootPos = conFState.lastFootPos;
-	DynamicArray<ContactPoint> *cfs = pw->getContactForces();
-	cfs->clear();
-	//now copy over the contact force information
-	for (uint i = 0; i < conFState.cfi.size(); i++)
-		cfs->push_back(ContactPoint(conFState.cfi[i]));
+	lastStepTaken = conFState.lastStepTaken;
+	//the heading, d and v of the controller are computed from the state of the character, so they are brought up to date as well
+	con->updateDAndV();
+	return true;
 }
@@ -22,25 +22,27 @@
 */
 
 #pragma once
-#include "basecontrolframework.h"
+#include "BaseControlFramework.h"
 #include "Character.h"
 #include "SimBiController.h"
 
 /**
-	This structure is used to hold the state of the simbicon framework. This includes the world configuration (i.e. state of the rigid bodies), the
-	state of the Simbicon controller that is used and also the contact forces that are acting on the character. The forces are necessary because
-	the control will be using them - the simulation will actually be ok without them, since they are recomputed before integration anyway.
+	This structure is used to hold the state of the simbicon framework. This includes the world snapshot (i.e. state of the rigid bodies, the
+	contact forces that are acting on the character and the data the engine keeps between steps) and the state of the Simbicon controller that
+	is used. The forces are necessary because the control will be using them - the simulation will actually be ok without them, since they are
+	recomputed before integration anyway. Saving and restoring a state does not touch any file, so a simulation can be forked from the same
+	warmed up state as many times as needed.
 */
 typedef struct 
 {
 	//hold the world state here
-	DynamicArray<double> worldState;
+	WorldSnapshot worldSnapshot;
 	//hold the state of the controller here:
 	SimBiControllerState conState;
 	//position of the last stance foot - used to compute step lengths
 	Point3d lastFootPos;
-	//and this is used to hold the contact force information
-	DynamicArray<ContactPoint> cfi;
+	//and the last step that was taken
+	Vector3d lastStepTaken;
 } SimBiConFrameworkState;
 
 /**
@@ -98,9 +100,10 @@ public:
 	void getState(SimBiConFrameworkState* conFState);
 
 	/**
-		populates the state of the framework with information passed in with the state of the framework
+		populates the state of the framework with information passed in with the state of the framework. Returns false if the state was not
+		taken from this framework.
 	*/
-	void setState(SimBiConFrameworkState& conFState);
+	bool setState(SimBiConFrameworkState& conFState);
 
 	/**
 		this method returns the vector that corresponds to the last step taken
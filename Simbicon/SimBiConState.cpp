@@ -26,6 +26,7 @@
 #include <PUtils.h>
 #include "SimGlobals.h"
 #include "SimBiController.h"
+#include "ConBinary.h"
 #include <iostream>
 
 using namespace std;
@@ -630,3 +631,193 @@ void SimBiConState::updateDVTrajectories(SimBiController* con, Joint* j, Traject
 	vTrajZ = new Trajectory1D( newVTrajZ );
 }
 
+/**
+	This method is used to read the knots of a 1D trajectory from a compiled controller
+*/
+void SimBiConState::readTrajectory1D(ConBinaryReader& r, Trajectory1D& result){
+	//every knot is a pair of doubles
+	int knotCount = r.readCount(2 * sizeof(double));
+	for (int i=0;i<knotCount;i++){
+		double t = r.readDouble();
+		double value = r.readDouble();
+		result.addKnot(t, value);
+	}
+}
+
+/**
+	This method is used to write the knots of a 1D trajectory to a compiled controller
+*/
+void SimBiConState::writeTrajectory1D(ConBinaryWriter& w, Trajectory1D& result){
+	w.writeInt(result.getKnotCount());
+	for (int i=0;i<result.getKnotCount();i++){
+		w.writeDouble(result.getKnotPosition(i));
+		w.writeDouble(result.getKnotValue(i));
+	}
+}
+
+/**
+	This method is used to read a 1D trajectory that may be missing from a compiled controller. It returns NULL if it is missing.
+*/
+Trajectory1D* SimBiConState::readOptionalTrajectory1D(ConBinaryReader& r){
+	if (r.readInt() == 0)
+		return NULL;
+	Trajectory1D* result = new Trajectory1D();
+	readTrajectory1D(r, *result);
+	return result;
+}
+
+/**
+	This method is used to write a 1D trajectory that may be missing (NULL) to a compiled controller
+*/
+void SimBiConState::writeOptionalTrajectory1D(ConBinaryWriter& w, Trajectory1D* traj){
+	w.writeInt(traj != NULL);
+	if (traj != NULL)
+		writeTrajectory1D(w, *traj);
+}
+
+/**
+	This method is used to read a trajectory component from a compiled controller
+*/
+void TrajectoryComponent::readTrajectoryComponent(ConBinaryReader& r){
+	rotationAxis = r.readVector();
+	reverseAngleOnLeftStance = (r.readInt() != 0);
+	reverseAngleOnRightStance = (r.readInt() != 0);
+	offset = r.readDouble();
+
+	delete bFeedback;
+	bFeedback = NULL;
+	int feedbackType = r.readInt();
+	if (feedbackType == SBC_BINARY_LINEAR_FEEDBACK){
+		bFeedback = new LinearBalanceFeedback();
+		bFeedback->loadFromBinary(r);
+	}else if (feedbackType != SBC_BINARY_NO_FEEDBACK){
+		r.setFailed();
+		return;
+	}
+
+	SimBiConState::readTrajectory1D(r, baseTraj);
+}
+
+/**
+	This method is used to write a trajectory component to a compiled controller
+*/
+void TrajectoryComponent::writeTrajectoryComponent(ConBinaryWriter& w){
+	w.writeVector(rotationAxis);
+	w.writeInt(reverseAngleOnLeftStance);
+	w.writeInt(reverseAngleOnRightStance);
+	w.writeDouble(offset);
+
+	w.writeInt((bFeedback != NULL) ? SBC_BINARY_LINEAR_FEEDBACK : SBC_BINARY_NO_FEEDBACK);
+	if (bFeedback != NULL)
+		bFeedback->writeToBinary(w);
+
+	SimBiConState::writeTrajectory1D(w, baseTraj);
+}
+
+/**
+	This method is used to read a trajectory from a compiled controller
+*/
+void Trajectory::readTrajectory(ConBinaryReader& r){
+	r.readString(jName, 100);
+	relToCharFrame = (r.readInt() != 0);
+	delete strengthTraj;
+	strengthTraj = SimBiConState::readOptionalTrajectory1D(r);
+
+	//the smallest component is its axis, the two stance flags, its offset, the kind of feedback and the knot count
+	int componentCount = r.readCount(3 * sizeof(double) + 2 * sizeof(int) + sizeof(double) + 2 * sizeof(int));
+	for (int i=0;i<componentCount && !r.hasFailed();i++){
+		TrajectoryComponent* newComponent = new TrajectoryComponent();
+		newComponent->readTrajectoryComponent(r);
+		components.push_back(newComponent);
+	}
+}
+
+/**
+	This method is used to write a trajectory to a compiled controller
+*/
+void Trajectory::writeTrajectory(ConBinaryWriter& w){
+	w.writeString(jName);
+	w.writeInt(relToCharFrame);
+	SimBiConState::writeOptionalTrajectory1D(w, strengthTraj);
+
+	w.writeInt(components.size());
+	for (uint i=0;i<components.size();i++)
+		components[i]->writeTrajectoryComponent(w);
+}
+
+/**
+	This method is used to read the state parameters from a compiled controller
+*/
+void SimBiConState::readState(ConBinaryReader& r, int offset){
+	r.readString(description, 100);
+	nextStateIndex = r.readInt() + offset;
+	stateTime = r.readDouble();
+
+	reverseStance = false;
+	keepStance = false;
+	switch (r.readInt()){
+	case SBC_BINARY_STANCE_LEFT:
+		stateStance = LEFT_STANCE;
+		break;
+	case SBC_BINARY_STANCE_RIGHT:
+		stateStance = RIGHT_STANCE;
+		break;
+	case SBC_BINARY_STANCE_REVERSE:
+		reverseStance = true;
+		break;
+	case SBC_BINARY_STANCE_SAME:
+		keepStance = true;
+		break;
+	default:
+		r.setFailed();
+		return;
+	}
+
+	transitionOnFootContact = (r.readInt() != 0);
+	minPhiBeforeTransitionOnFootContact = r.readDouble();
+	minSwingFootForceForContact = r.readDouble();
+
+	dTrajX = readOptionalTrajectory1D(r);
+	dTrajZ = readOptionalTrajectory1D(r);
+	vTrajX = readOptionalTrajectory1D(r);
+	vTrajZ = readOptionalTrajectory1D(r);
+
+	//the smallest trajectory is an empty name, the frame flag, the strength flag and the component count
+	int trajectoryCount = r.readCount(4 * sizeof(int));
+	for (int i=0;i<trajectoryCount && !r.hasFailed();i++){
+		Trajectory* tempTraj = new Trajectory();
+		tempTraj->readTrajectory(r);
+		sTraj.push_back(tempTraj);
+	}
+}
+
+/**
+	This method is used to write the state parameters to a compiled controller
+*/
+void SimBiConState::writeState(ConBinaryWriter& w){
+	w.writeString(description);
+	w.writeInt(nextStateIndex);
+	w.writeDouble(stateTime);
+
+	if (reverseStance)
+		w.writeInt(SBC_BINARY_STANCE_REVERSE);
+	else if (keepStance)
+		w.writeInt(SBC_BINARY_STANCE_SAME);
+	else if (stateStance == RIGHT_STANCE)
+		w.writeInt(SBC_BINARY_STANCE_RIGHT);
+	else
+		w.writeInt(SBC_BINARY_STANCE_LEFT);
+
+	w.writeInt(transitionOnFootContact);
+	w.writeDouble(minPhiBeforeTransitionOnFootContact);
+	w.writeDouble(minSwingFootForceForContact);
+
+	writeOptionalTrajectory1D(w, dTrajX);
+	writeOptionalTrajectory1D(w, dTrajZ);
+	writeOptionalTrajectory1D(w, vTrajX);
+	writeOptionalTrajectory1D(w, vTrajZ);
+
+	w.writeInt(sTraj.size());
+	for (uint i=0;i<sTraj.size();i++)
+		sTraj[i]->writeTrajectory(w);
+}
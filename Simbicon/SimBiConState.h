@@ -131,6 +131,12 @@ public:
 	*/
 	void writeTrajectoryComponent(FILE* f);
     void writeTrajectoryComponent(std::ofstream& f);
+
+	/**
+		These methods are used to read and write a trajectory component in a compiled controller
+	*/
+	void readTrajectoryComponent(ConBinaryReader& r);
+	void writeTrajectoryComponent(ConBinaryWriter& w);
 };
 
 
@@ -166,7 +172,7 @@ public:
 	*/
 	Trajectory(){
 		leftStanceIndex = rightStanceIndex = -1;
-		strcpy_s(jName, "NoNameJoint");
+		strcpy(jName, "NoNameJoint");
 		strengthTraj = NULL;
 		relToCharFrame = false;
 	}
@@ -234,6 +240,12 @@ public:
 	*/
 	void writeTrajectory(FILE* f);
     void writeTrajectory(std::ofstream& f);
+
+	/**
+		These methods are used to read and write a trajectory in a compiled controller
+	*/
+	void readTrajectory(ConBinaryReader& r);
+	void writeTrajectory(ConBinaryWriter& w);
 };
 
 /**
@@ -287,7 +299,7 @@ public:
 		default constructor
 	*/
 	SimBiConState(void){
-		strcpy_s(description, "Uninitialized state");
+		strcpy(description, "Uninitialized state");
 		nextStateIndex = -1;
 		this->stateTime = 0;
 		transitionOnFootContact = true;
@@ -403,6 +415,13 @@ public:
 
     void writeState(std::ofstream& f, int index);
 
+	/**
+		These methods are used to read and write the state parameters in a compiled controller. As with the text files, the offset is
+		added to the index of the next state.
+	*/
+	void readState(ConBinaryReader& r, int offset);
+	void writeState(ConBinaryWriter& w);
+
 
 	/** 
 		Update all the trajectories to recenter them around the new given D and V trajectories
@@ -420,6 +439,18 @@ public:
 	static void writeTrajectory1D(FILE* f, Trajectory1D& result, int startingLineType, int endingLineType );
     static void writeTrajectory1D(std::ofstream& f, Trajectory1D& result, int startingLineType, int endingLineType );
 
+	/**
+		These methods are used to read and write the knots of a 1D trajectory in a compiled controller
+	*/
+	static void readTrajectory1D(ConBinaryReader& r, Trajectory1D& result);
+	static void writeTrajectory1D(ConBinaryWriter& w, Trajectory1D& result);
+
+	/**
+		These methods are used to read and write a 1D trajectory that may be missing (NULL) in a compiled controller
+	*/
+	static Trajectory1D* readOptionalTrajectory1D(ConBinaryReader& r);
+	static void writeOptionalTrajectory1D(ConBinaryWriter& w, Trajectory1D* traj);
+
 };
 
 
@@ -29,6 +29,7 @@
 #include <PUtils.h>
 #include "SimGlobals.h"
 #include "ConUtils.h"
+#include "ConBinary.h"
 #include <stdio.h>
 
 
@@ -142,15 +143,9 @@ void SimBiController::transitionToState(int stateIndex){
 /**
 	This method returns the net force on the body rb, acting from the ground
 */
-Vector3d SimBiController::getForceOn(RigidBody* rb, DynamicArray<ContactPoint> *cfs){
-	Vector3d fNet = Vector3d();
-	for (uint i=0;i<cfs->size();i++){
-		if ((*cfs)[i].rb1 == rb)
-			fNet += (*cfs)[i].f;
-		if ((*cfs)[i].rb2 == rb)
-			fNet -= (*cfs)[i].f;
-	}
-	return fNet;
+Vector3d SimBiController::getForceOn(RigidBody* rb){
+	//the world adds up the contact forces acting on each body once per step
+	return rb->getNetContactForce();
 }
 
 /**
@@ -203,12 +198,12 @@ bool SimBiController::isStanceFoot(RigidBody* rb){
 /**
 	This method returns the net force on the body rb, acting from the ground
 */
-Vector3d SimBiController::getForceOnFoot(RigidBody* foot, DynamicArray<ContactPoint> *cfs){
-	Vector3d fNet = getForceOn(foot, cfs);
+Vector3d SimBiController::getForceOnFoot(RigidBody* foot){
+	Vector3d fNet = getForceOn(foot);
 
 	//we will also look at all children of the foot that is passed in (to take care of toes).
 	for (uint i=0;i<((ArticulatedRigidBody*)foot)->cJoints.size();i++){
-		fNet += getForceOn(((ArticulatedRigidBody*)foot)->cJoints[i]->child, cfs);
+		fNet += getForceOn(((ArticulatedRigidBody*)foot)->cJoints[i]->child);
 	}
 	return fNet;
 }
@@ -224,23 +219,22 @@ int SimBiController::advanceInTime(double dt, DynamicArray<ContactPoint> *cfs){
 	}
 
 	bodyTouchedTheGround = false;
-	//see if anything else other than the feet touch the ground...
-	for (uint i=0;i<cfs->size();i++){
-		//if neither of the bodies involved are articulated, it means they are just props so we can ignore them
-		if ((*cfs)[i].rb1->isArticulated() == false && (*cfs)[i].rb2->isArticulated() == false)
-			continue;
-			
-		if (isFoot((*cfs)[i].rb1) || isFoot((*cfs)[i].rb2))
+	//see if anything else other than the feet touch the ground. Only the bodies of this character are looked at, so the contacts of other
+	//characters that share the world do not count
+	for (int i=-1;i<character->getJointCount();i++){
+		RigidBody* rb = (i < 0) ? root : character->getJoint(i)->child;
+		if (rb->getContactCount() == 0 || isFoot(rb))
 			continue;
 
 		bodyTouchedTheGround = true;
+		break;
 	}
 
 	//advance the phase of the controller
 	this->phi += dt/states[FSMStateIndex]->getStateTime();
 
 	//see if we have to transition to the next state in the FSM, and do it if so...
-	if (states[FSMStateIndex]->needTransition(phi, fabs(getForceOnFoot(swingFoot, cfs).dotProductWith(SimGlobals::up)), fabs(getForceOnFoot(stanceFoot, cfs).dotProductWith(SimGlobals::up)))){
+	if (states[FSMStateIndex]->needTransition(phi, fabs(getForceOnFoot(swingFoot).dotProductWith(SimGlobals::up)), fabs(getForceOnFoot(stanceFoot).dotProductWith(SimGlobals::up)))){
 		int newStateIndex = states[FSMStateIndex]->getNextStateIndex();
 		transitionToState(newStateIndex);
 		return newStateIndex;
@@ -253,9 +247,9 @@ int SimBiController::advanceInTime(double dt, DynamicArray<ContactPoint> *cfs){
 /**
 	This method is used to return the ratio of the weight that is supported by the stance foot.
 */
-double SimBiController::getStanceFootWeightRatio(DynamicArray<ContactPoint> *cfs){
-	Vector3d stanceFootForce = getForceOnFoot(stanceFoot, cfs);
-	Vector3d swingFootForce = getForceOnFoot(swingFoot, cfs);
+double SimBiController::getStanceFootWeightRatio(){
+	Vector3d stanceFootForce = getForceOnFoot(stanceFoot);
+	Vector3d swingFootForce = getForceOnFoot(swingFoot);
 	double totalYForce = (stanceFootForce + swingFootForce).dotProductWith(SimGlobals::up);
 
 	if (IS_ZERO(totalYForce))
@@ -433,7 +427,7 @@ void SimBiController::computeTorques(DynamicArray<ContactPoint> *cfs)
 	//compute the torques now, using the desired pose information - the hip torques will get overwritten below
 	PoseController::computeTorques(cfs);
 
-	double stanceHipToSwingHipRatio = getStanceFootWeightRatio(cfs);
+	double stanceHipToSwingHipRatio = getStanceFootWeightRatio();
 
 	if (stanceHipToSwingHipRatio < 0)
 		rootControlParams.strength = 0;
@@ -599,60 +593,134 @@ void SimBiController::resolveJoints(SimBiConState* state){
 	This method is used to write the details of the current controller to a file
 */
 void SimBiController::writeControllers(const char fileName[]){
-    std::fstream resFile(fileName, std::ios::out);
-    
-    bool isOpen = resFile.is_open();
-    if(isOpen)
-    {
-        std::cout << isOpen << std::endl;
-        int a;
-        a = 5;
-        a = 6;
-        a = 7;
-        std::cout << "caonima" << std::endl;
-    }
-    if(resFile.bad())
-    {
-        std::cout << "bla" << std::endl;
-    }
-    if(resFile.fail())
-    {
-        std::cout << "ble" << std::endl;
-    }
-    assert(resFile);
-    resFile << "caonima" << std::endl;
-
-//     resFile << getConLineString(CON_PD_GAINS_START) << std::endl;
-//     resFile << "#        joint name              Kp      Kd      MaxTorque    ScaleX        ScaleY        ScaleZ\n";
-//     resFile << "    root\t" << rootControlParams.kp << "\t" << rootControlParams.kd << "\t" << rootControlParams.maxAbsTorque << "\t" << rootControlParams.scale.x << "\t" << rootControlParams.scale.y << "\t" << rootControlParams.scale.z << std::endl;
-// 	writeGains(resFile);
-// 
-//     resFile << getConLineString(CON_PD_GAINS_END) << std::endl << std::endl;
-// 	
-// 	if( stanceHipDamping > 0 ) {
-//         resFile << getConLineString(CON_STANCE_HIP_DAMPING) << " " << stanceHipDamping << std::endl;
-// 		resFile << getConLineString(CON_STANCE_HIP_MAX_VELOCITY) << " " << stanceHipMaxVelocity << std::endl;
-// 	}
-// 
-//     resFile << std::endl;
-// 	
-// 
-// 	for( uint i=0; i<states.size(); ++i ) {
-//         resFile << std::endl << std::endl;
-// 		states[i]->writeState( resFile, i );
-// 
-// 	}
-// 
-//     resFile << std::endl << std::endl;
-// 
-//     resFile  << getConLineString(CON_START_AT_STATE) << " " << startingState << std::endl;
-//     resFile << getConLineString(CON_STARTING_STANCE) << " " << ((stanceFoot==lFoot)?"left":"right") << std::endl;
-// 	if( stateFileName == NULL )
-//         resFile << getConLineString(CON_CHARACTER_STATE) << " " << initialBipState << std::endl;
-// 	else
-//         resFile << getConLineString(CON_CHARACTER_STATE) << " " << stateFileName << std::endl;
-
-	resFile.close();
+	FILE* f = fopen(fileName, "w");
+	if (f == NULL){
+		printf("Cannot write the controller file %s\n", fileName);
+		return;
+	}
+
+	fprintf(f, "%s\n", getConLineString(CON_PD_GAINS_START));
+	fprintf(f, "#        joint name              Kp      Kd      MaxTorque    ScaleX        ScaleY        ScaleZ\n");
+	fprintf(f, "    root\t%lf\t%lf\t%lf\t%lf\t%lf\t%lf\n", rootControlParams.kp, rootControlParams.kd, rootControlParams.maxAbsTorque,
+		rootControlParams.scale.x, rootControlParams.scale.y, rootControlParams.scale.z);
+	writeGains(f);
+	fprintf(f, "%s\n\n", getConLineString(CON_PD_GAINS_END));
+
+	if (stanceHipDamping > 0){
+		fprintf(f, "%s %lf\n", getConLineString(CON_STANCE_HIP_DAMPING), stanceHipDamping);
+		fprintf(f, "%s %lf\n", getConLineString(CON_STANCE_HIP_MAX_VELOCITY), stanceHipMaxVelocity);
+	}
+	if (rootPredictiveTorqueScale != 0)
+		fprintf(f, "%s %lf\n", getConLineString(CON_ROOT_PRED_TORQUE_SCALE), rootPredictiveTorqueScale);
+
+	for (uint i=0;i<states.size();i++){
+		fprintf(f, "\n\n");
+		states[i]->writeState(f, i);
+	}
+	fprintf(f, "\n\n");
+
+	if (startingState >= 0)
+		fprintf(f, "%s %d\n", getConLineString(CON_START_AT_STATE), startingState);
+	fprintf(f, "%s %s\n", getConLineString(CON_STARTING_STANCE), (startingStance == LEFT_STANCE) ? "left" : "right");
+	if (initialBipState[0] != '\0')
+		fprintf(f, "%s %s\n", getConLineString(CON_CHARACTER_STATE), initialBipState);
+
+	fclose(f);
+}
+
+/**
+	This method writes the controller as a compiled (.sbcb) file, in the same order as the text files: the gains, the stance hip
+	parameters, the states, and then the way the controller starts. It returns false if the file could not be written.
+*/
+bool SimBiController::writeToBinaryFile(const char fileName[]){
+	ConBinaryWriter w(fileName);
+
+	w.writeDouble(rootControlParams.kp);
+	w.writeDouble(rootControlParams.kd);
+	w.writeDouble(rootControlParams.maxAbsTorque);
+	w.writeVector(rootControlParams.scale);
+	writeGains(w);
+
+	w.writeDouble(stanceHipDamping);
+	w.writeDouble(stanceHipMaxVelocity);
+	w.writeDouble(rootPredictiveTorqueScale);
+
+	w.writeInt(states.size());
+	for (uint i=0;i<states.size();i++)
+		states[i]->writeState(w);
+
+	w.writeInt(startingState);
+	w.writeInt(startingStance);
+	w.writeString(initialBipState);
+
+	if (!w.isGood()){
+		printf("Could not write the whole controller to %s\n", fileName);
+		return false;
+	}
+	return true;
+}
+
+/**
+	This method loads the controller from a compiled (.sbcb) file. It returns false if the file could not be loaded.
+*/
+bool SimBiController::loadFromBinaryFile(char* fName){
+	ConBinaryReader r(fName);
+	if (r.hasFailed())
+		return false;
+
+	//as with the text files, the state numbers of every file that is loaded come after the states that are already there
+	int stateOffset = this->states.size();
+
+	rootControlParams.kp = r.readDouble();
+	rootControlParams.kd = r.readDouble();
+	rootControlParams.maxAbsTorque = r.readDouble();
+	rootControlParams.scale = r.readVector();
+	readGains(r);
+
+	stanceHipDamping = r.readDouble();
+	stanceHipMaxVelocity = r.readDouble();
+	rootPredictiveTorqueScale = r.readDouble();
+
+	//the smallest state has an empty description, its next state, time, stance and transition, the two contact thresholds,
+	//four missing d and v trajectories and no trajectories of its own
+	int stateCount = r.readCount(4 * sizeof(int) + 3 * sizeof(double) + 4 * sizeof(int) + sizeof(int));
+	for (int i=0;i<stateCount;i++){
+		SimBiConState* tempState = new SimBiConState();
+		states.push_back(tempState);
+		tempState->readState(r, stateOffset);
+		if (r.hasFailed())
+			break;
+		//now we have to resolve all the joint names (i.e. figure out which joints they apply to).
+		resolveJoints(tempState);
+	}
+
+	int stateNr = r.readInt();
+	int stanceToStartWith = r.readInt();
+	char stateFileName[100];
+	r.readString(stateFileName, 100);
+
+	if (r.hasFailed() || (stanceToStartWith != LEFT_STANCE && stanceToStartWith != RIGHT_STANCE)){
+		printf("The controller file %s is corrupt\n", fName);
+		//a half loaded controller would still walk, just not the way it should, so the states of this file are dropped
+		for (uint i=stateOffset;i<states.size();i++)
+			delete states[i];
+		states.resize(stateOffset);
+		return false;
+	}
+	if (!r.isAtEnd())
+		printf("Warning: the controller file %s has data past the end of the controller\n", fName);
+
+	if (stateNr >= 0 && states.size() > 0){
+		transitionToState(stateNr);
+		startingState = stateNr;
+	}
+	setStance(stanceToStartWith);
+	startingStance = stanceToStartWith;
+	if (stateFileName[0] != '\0'){
+		character->loadReducedStateFromFile(stateFileName);
+		strcpy(initialBipState, stateFileName);
+	}
+	return true;
 }
 
 /**
@@ -682,6 +750,11 @@ void SimBiController::parseGainLine(char* line){
 	This method loads all the pertinent information regarding the simbicon controller from a file.
 */
 void SimBiController::loadFromFile(char* fName){
+    if (isBinaryControllerFile(fName)){
+        loadFromBinaryFile(fName);
+        return;
+    }
+
     FILE *f = fopen(fName, "r");
 
     //to be able to load multiple controllers from multiple files,
@@ -133,12 +133,12 @@ private:
 	/**
 		This method returns the net force on the body rb, acting from the ground
 	*/
-	Vector3d getForceOn(RigidBody* rb, DynamicArray<ContactPoint> *cfs);
+	Vector3d getForceOn(RigidBody* rb);
 
 	/**
 		This method returns the net force on the body rb, acting from the ground
 	*/
-	Vector3d getForceOnFoot(RigidBody* foot, DynamicArray<ContactPoint> *cfs);
+	Vector3d getForceOnFoot(RigidBody* foot);
 
 	/**
 		This method is used to determine if the rigid body that is passed in as a parameter is a
@@ -159,7 +159,7 @@ private:
 	/**
 		This method is used to return the ratio of the weight that is supported by the stance foot.
 	*/
-	double getStanceFootWeightRatio(DynamicArray<ContactPoint> *cfs);
+	double getStanceFootWeightRatio();
 
 	/**
 		This method is used to compute the torques that need to be applied to the stance and swing hips, given the
@@ -228,10 +228,21 @@ public:
 	void setControllerState(const SimBiControllerState &cs);
 	
 	/**
-		This method loads all the pertinent information regarding the simbicon controller from a file.
+		This method loads all the pertinent information regarding the simbicon controller from a file. Compiled controllers are
+		recognized by their header and loaded with loadFromBinaryFile, everything else is parsed as a text .sbc file.
 	*/
 	void loadFromFile(char* fName);
 
+	/**
+		This method loads the controller from a compiled (.sbcb) file. It returns false if the file could not be loaded.
+	*/
+	bool loadFromBinaryFile(char* fName);
+
+	/**
+		This method writes the controller as a compiled (.sbcb) file. It returns false if the file could not be written.
+	*/
+	bool writeToBinaryFile(const char fileName[]);
+
 	/**
 		This method is used to return the value of bodyGroundContact
 	*/
@@ -268,7 +279,7 @@ public:
 	}
 
 	/**
-		This method is used to write the current controller to a file
+		This method is used to write the current controller to a text .sbc file
 	*/
 	void writeControllers(const char fileName[]);
 
@@ -297,6 +308,13 @@ public:
 	 */
 	SimBiConState* getState( uint idx );
 
+	/**
+		This method returns the number of states of this controller
+	*/
+	inline int getStateCount(){
+		return states.size();
+	}
+
 	/**
 		This method makes it possible to evaluate the debug pose at any phase angle
 		Negative phase angle = Use the current controller phase angle
@@ -33,7 +33,6 @@ Vector3d SimGlobals::up = Vector3d(0, 1, 0);
 int SimGlobals::forceHeadingControl = 1;
 double SimGlobals::desiredHeading = 0;
 double SimGlobals::dt = 1.0/(2000.0);
-World* SimGlobals::activeRbEngine = NULL;
 
 double SimGlobals::conInterpolationValue;
 double SimGlobals::bipDesiredVelocity;
@@ -24,7 +24,6 @@
 #pragma once
 
 #include <Vector3d.h>
-#include <PhysX3World.h>
 #include <string>
 #include <fstream>
 #include <iostream>
@@ -52,8 +51,6 @@ public:
 	//and this is the desired time interval for each simulation timestep (does not apply to animations that are played back).
 	static double dt;
 
-	static World* activeRbEngine;
-
 	//temp..
 	static double targetPos;
 	static double targetPosX;
@@ -85,11 +82,4 @@ public:
 	~SimGlobals(void){
 	}
 
-	inline static World* getRBEngine(){
-		if (activeRbEngine == NULL)
-			activeRbEngine = new PhysX3World();
-		return activeRbEngine;
-//		return new PhysEng();
-	}
-
 };
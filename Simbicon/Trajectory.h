@@ -35,48 +35,110 @@
 	This class is used to represent generic trajectories. The class parameter T can be anything that provides basic operation such as addition and subtraction.
 	We'll define a trajectory that can be parameterized by a one-d parameter (called t). Based on a set of knots ( tuples <t, T>), we can evaluate the 
 	trajectory at any t, through interpolation. This is not used for extrapolation. Outside the range of the knots, the closest known value is returned instead.
+	The Catmull-Rom spline is compiled into one cubic per segment whenever the knots change, so evaluating it only takes a binary search and a
+	polynomial. A cubic only depends on the four knots around its segment, so changing one knot only recompiles the four segments next to it.
+	Evaluation does not modify the trajectory, so it can be done from several threads at once.
 */
 
 template <class T> class GenericTrajectory
 {
 private:
+	//the Catmull-Rom spline between knots i and i+1 is c0 + c1*u + c2*u^2 + c3*u^3, where u = (t - tValues[i]) * invLength goes from 0 to 1
+	typedef struct Segment_struct{
+		double invLength;
+		T c0, c1, c2, c3;
+	} Segment;
+
 	DynamicArray<double> tValues;
 	DynamicArray<T> values;
-
-	// A caching variable to optimize searching
-	volatile int lastIndex;
-
+	//one segment for each pair of consecutive knots. The ones next to a knot are recomputed whenever that knot changes
+	DynamicArray<Segment> segments;
 
 	/**
 		This method returns the index of the first knot whose value is larger than the parameter value t. If no such index exists (t is larger than any
 		of the values stored), then values.size() is returned.
 	*/
-	int getFirstLargerIndex(double t)
+	int getFirstLargerIndex(double t) const
     {
 		int size = tValues.size();
 		if(size == 0) return 0;
-		if(t < tValues[(lastIndex+size-1)%size]) lastIndex = 0;
-		for(int i = 0; i<size;i++)
-        {
-			int index = (i + lastIndex) % size;
-			if(t < tValues[index]) 
-            {
-				lastIndex = index;
-				return index;
-			}
+		//binary search for the last knot that is not larger than t. The comparison only picks which half to keep, so it compiles without branches
+		const double* first = &tValues[0];
+		const double* base = first;
+		int n = size;
+		while (n > 1){
+			int half = n / 2;
+			base = (base[half] <= t) ? (base + half) : base;
+			n -= half;
+		}
+		return (int)(base - first) + ((*base <= t) ? 1 : 0);
+	}
+
+	/**
+		This method recomputes the coefficients of the cubic of every segment of the Catmull-Rom spline.
+	*/
+	void updateSegments()
+    {
+		int size = tValues.size();
+		segments.resize((size > 1) ? (size - 1) : 0);
+		updateSegments(0, size - 2);
+	}
+
+	/**
+		This method recomputes the coefficients of the cubics of the segments first to last. Segment i goes from knot i to knot i+1, but its
+		cubic also depends on knots i-1 and i+2, so when knot k changes, segments k-2 to k+1 need to be recomputed. The range is clamped to
+		the segments that exist, and the segments array must already have one entry per pair of consecutive knots.
+	*/
+	void updateSegments(int first, int last)
+    {
+		int size = tValues.size();
+		if (first < 0) first = 0;
+		if (last > size - 2) last = size - 2;
+		for (int i=first;i<=last;i++){
+			//approximate the derivatives at the two ends of the segment from the neighbouring knots
+			T p0 = (i-1<0)?(values[i]):(values[i-1]);
+			T p1 = values[i];
+			T p2 = values[i+1];
+			T p3 = (i+2>=size)?(values[i+1]):(values[i+2]);
+
+#ifdef FANCY_SPLINES
+			double t0 = (i-1<0)?(tValues[i]):(tValues[i-1]);
+			double t1 = tValues[i];
+			double t2 = tValues[i+1];
+			double t3 = (i+2>=size)?(tValues[i+1]):(tValues[i+2]);
+
+			double d1 = (t2-t0);
+			double d2 = (t3-t1);
+
+			if (d1 > -TINY && d1  < 0) d1 = -TINY;
+			if (d1 < TINY && d1  >= 0) d1 = TINY;
+			if (d2 > -TINY && d2  < 0) d2 = -TINY;
+			if (d2 < TINY && d2  >= 0) d2 = TINY;
+
+			T m1 = (p2 - p0) * (1-(t1-t0)/d1);
+			T m2 = (p3 - p1) * (1-(t3-t2)/d2);
+#else
+			T m1 = (p2 - p0) * 0.5;
+			T m2 = (p3 - p1) * 0.5;
+#endif
+
+			//the four hermite basis functions from wikipedia, collected by powers of u
+			Segment& seg = segments[i];
+			seg.invLength = 1.0 / (tValues[i+1] - tValues[i]);
+			seg.c0 = p1;
+			seg.c1 = m1;
+			seg.c2 = p1 * -3 + p2 * 3 - m1 * 2 - m2;
+			seg.c3 = p1 * 2 - p2 * 2 + m1 + m2;
 		}
-		return size;
 	}
 
 public:
 	GenericTrajectory(void)
     {
-		lastIndex = 0;
 	}
 
 	GenericTrajectory(GenericTrajectory<T>& other)
     {
-		lastIndex = 0;
 		copy(other);
 	}
 	~GenericTrajectory(void)
@@ -87,9 +149,10 @@ public:
 	/**
 		This method performs linear interpolation to evaluate the trajectory at the point t
 	*/
-	T evaluate_linear(double t)
+	T evaluate_linear(double t) const
     {
 		int size = tValues.size();
+		if (size == 0) return T();
 		if (t<=tValues[0]) return values[0];
 		if (t>=tValues[size-1])	return values[size-1];
 		int index = getFirstLargerIndex(t);
@@ -103,56 +166,24 @@ public:
 	/**
 		This method interprets the trajectory as a Catmul-Rom spline, and evaluates it at the point t
 	*/
-	T evaluate_catmull_rom(double t)
+	T evaluate_catmull_rom(double t) const
     {
 		int size = tValues.size();
+		if (size == 0) return T();
 		if (t<=tValues[0]) return values[0];
 		if (t>=tValues[size-1])	return values[size-1];
 		int index = getFirstLargerIndex(t);
-		
-		//now that we found the interval, get a value that indicates how far we are along it
-		t = (t-tValues[index-1]) / (tValues[index]-tValues[index-1]);
-
-		//approximate the derivatives at the two ends
-		double t0, t1, t2, t3;
-		T p0, p1, p2, p3;
-		p0 = (index-2<0)?(values[index-1]):(values[index-2]);
-		p1 = values[index-1];
-		p2 = values[index];
-		p3 = (index+1>=size)?(values[index]):(values[index+1]);
-
-		t0 = (index-2<0)?(tValues[index-1]):(tValues[index-2]);
-		t1 = tValues[index-1];
-		t2 = tValues[index];
-		t3 = (index+1>=size)?(tValues[index]):(tValues[index+1]);
-
-		double d1 = (t2-t0);
-		double d2 = (t3-t1);
-
-		if (d1 > -TINY && d1  < 0) d1 = -TINY;
-		if (d1 < TINY && d1  >= 0) d1 = TINY;
-		if (d2 > -TINY && d2  < 0) d2 = -TINY;
-		if (d2 < TINY && d2  >= 0) d2 = TINY;
-
-#ifdef FANCY_SPLINES
-		T m1 = (p2 - p0) * (1-(t1-t0)/d1);
-		T m2 = (p3 - p1) * (1-(t3-t2)/d2);
-#else
-		T m1 = 0.5*(p2 - p0);
-		T m2 = 0.5*(p3 - p1);
-#endif
-
-		t2 = t*t;
-		t3 = t2*t;
 
-		//and now perform the interpolation using the four hermite basis functions from wikipedia
-		return p1*(2*t3-3*t2+1) + m1*(t3-2*t2+t) + p2*(-2*t3+3*t2) + m2 * (t3 - t2);
+		//now that we found the segment, get a value that indicates how far we are along it, and evaluate its cubic
+		const Segment& seg = segments[index-1];
+		double u = (t-tValues[index-1]) * seg.invLength;
+		return seg.c0 + (seg.c1 + (seg.c2 + seg.c3 * u) * u) * u;
 	}
 
 	/**
 		Returns the value of the ith knot. It is assumed that i is within the correct range.
 	*/
-	T getKnotValue(int i)
+	T getKnotValue(int i) const
     {
 		return values[i];
 	}
@@ -160,7 +191,7 @@ public:
 	/**
 		Returns the position of the ith knot. It is assumed that i is within the correct range.
 	*/
-	double getKnotPosition(int i)
+	double getKnotPosition(int i) const
     {
 		return tValues[i];
 	}
@@ -171,6 +202,7 @@ public:
 	void setKnotValue(int i, const T& val)
     {
 		values[i] = val;
+		updateSegments(i-2, i+1);
 	}
 
 	/**
@@ -181,12 +213,13 @@ public:
 		if( i-1 >= 0               && tValues[i-1] >= pos ) return;
 		if( (uint)(i+1) < tValues.size()-1 && tValues[i+1] <= pos ) return;
 		tValues[i] = pos;
+		updateSegments(i-2, i+1);
 	}
 
 	/**
 		Return the smallest tValue or infinity if none
 	*/
-	double getMinPosition()
+	double getMinPosition() const
     {
 		if(tValues.empty()) 
 			return std::numeric_limits<double>::infinity();
@@ -196,7 +229,7 @@ public:
 	/**
 		Return the largest tValue or -infinity if none
 	*/
-	double getMaxPosition()
+	double getMaxPosition() const
     {
 		if(tValues.empty()) 
 			return -std::numeric_limits<double>::infinity();
@@ -207,7 +240,7 @@ public:
 	/**
 		returns the number of knots in this trajectory
 	*/
-	int getKnotCount()
+	int getKnotCount() const
     {
 		return tValues.size();
 	}
@@ -220,8 +253,13 @@ public:
 		//first we need to know where to insert it, based on the t-values
 		int index = getFirstLargerIndex(t);
 
+		//the new knot splits the segment it falls in. Inserting a segment at its index keeps all the other segments in line with their knots
+		int segmentCount = segments.size();
 		tValues.insert(tValues.begin()+index, t);
 		values.insert(values.begin()+index, val);
+		if (tValues.size() > 1)
+			segments.insert(segments.begin() + ((index < segmentCount) ? index : segmentCount), Segment());
+		updateSegments(index-2, index+1);
 	}
 
 	/**
@@ -230,8 +268,13 @@ public:
 	*/
 	void removeKnot(int i)
     {
+		//the two segments on either side of the knot become one
+		int segmentCount = segments.size();
 		tValues.erase(tValues.begin()+i);
 		values.erase(values.begin()+i);
+		if (segmentCount > 0)
+			segments.erase(segments.begin() + ((i < segmentCount) ? i : segmentCount - 1));
+		updateSegments(i-2, i+1);
 	}
 
 	/**
@@ -240,6 +283,7 @@ public:
 	void clear(){
 		tValues.clear();
 		values.clear();
+		segments.clear();
 	}
 
 	/**
@@ -296,6 +340,7 @@ public:
 			tValues.push_back(other.tValues[i]);
 			values.push_back(other.values[i]);
 		}
+		updateSegments();
 	}
 
 };
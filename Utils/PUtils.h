@@ -19,7 +19,7 @@ typedef unsigned int uint;
 */
 inline void readDoublesFromFile(FILE* f, DynamicArray<double> *d){
 	double temp;
-	while (fscanf_s(f, "%lf\n", &temp) == 1)
+	while (fscanf(f, "%lf\n", &temp) == 1)
 		d->push_back(temp);
 }
 
@@ -76,7 +76,7 @@ inline DynamicArray<char*> getTokens(char* input){
 	while (input[0]!='\0'){
 		result.push_back(input);
 		char tempStr[100];
-		sscanf_s(input, "%s", tempStr);
+		sscanf(input, "%99s", tempStr);
 		input = lTrim(input + strlen(tempStr));
 	}
 	return result;
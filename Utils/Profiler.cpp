@@ -0,0 +1,260 @@
+#include "stdafx.h"
+
+#include "Profiler.h"
+#include <mutex>
+#include <algorithm>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+using namespace std;
+
+DynamicArray<ProfilerThreadData*> Profiler::threads;
+PROFILER_THREAD_LOCAL ProfilerThreadData* Profiler::currentThread = NULL;
+long long Profiler::startTicks = Profiler::getTicks();
+long long Profiler::ticksPerSecond = 0;
+bool Profiler::enabled = false;
+int Profiler::maxEventsPerThread = 1 << 20;
+
+//this only guards the list of threads - every thread records into its own data
+static mutex threadsLock;
+
+//the file the trace is written to when the program exits
+static char exitTraceFileName[200] = "";
+
+static const char* zoneNames[PROFILE_ZONE_COUNT] = {
+	"simulation step",
+	"controller compute",
+	"torque application",
+	"engine simulate",
+	"engine fetch",
+	"contact processing",
+	"state sync",
+	"FSM transition"
+};
+
+/**
+	This method turns the profiler on or off. The times recorded so far are kept.
+*/
+void Profiler::setEnabled(bool enabled){
+	Profiler::enabled = enabled;
+}
+
+/**
+	returns the current value of the performance counter
+*/
+long long Profiler::getTicks(){
+#ifdef WIN32
+	LARGE_INTEGER count;
+	QueryPerformanceCounter(&count);
+	return count.QuadPart;
+#else
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (long long)t.tv_sec * 1000000000LL + t.tv_nsec;
+#endif
+}
+
+/**
+	returns the number of ticks of the performance counter in one second
+*/
+long long Profiler::getTicksPerSecond(){
+	if (ticksPerSecond == 0){
+#ifdef WIN32
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency(&frequency);
+		ticksPerSecond = frequency.QuadPart;
+#else
+		ticksPerSecond = 1000000000LL;
+#endif
+	}
+	return ticksPerSecond;
+}
+
+/**
+	returns the name of the zone that is passed in as a parameter
+*/
+const char* Profiler::getZoneName(int zone){
+	if (zone < 0 || zone >= PROFILE_ZONE_COUNT)
+		return "unknown";
+	return zoneNames[zone];
+}
+
+/**
+	returns the data of the calling thread, creating it the first time the thread records something
+*/
+ProfilerThreadData* Profiler::getThreadData(){
+	if (currentThread != NULL)
+		return currentThread;
+
+	ProfilerThreadData* data = new ProfilerThreadData();
+	data->droppedEvents = 0;
+	//the trace grows in large blocks, so the timed code is rarely slowed down by a reallocation
+	data->events.reserve(min(maxEventsPerThread, 1 << 16));
+	lock_guard<mutex> lock(threadsLock);
+	data->threadIndex = (int)threads.size();
+	threads.push_back(data);
+	currentThread = data;
+	return data;
+}
+
+/**
+	This method records one pass through a zone, which went from the tick start to the tick end.
+*/
+void Profiler::record(int zone, long long start, long long end){
+	ProfilerThreadData* data = getThreadData();
+	long long ticks = end - start;
+
+	ProfileZoneStats& s = data->stats[zone];
+	if (s.calls == 0 || ticks < s.minTicks)
+		s.minTicks = ticks;
+	if (s.calls == 0 || ticks > s.maxTicks)
+		s.maxTicks = ticks;
+	s.calls++;
+	s.totalTicks += ticks;
+
+	if ((int)data->events.size() >= maxEventsPerThread){
+		data->droppedEvents++;
+		return;
+	}
+	ProfileEvent e;
+	e.zone = zone;
+	e.start = start;
+	e.end = end;
+	data->events.push_back(e);
+}
+
+/**
+	This method forgets everything that has been recorded so far. The threads keep their data, so nothing is freed under them.
+*/
+void Profiler::reset(){
+	lock_guard<mutex> lock(threadsLock);
+	for (uint i=0;i<threads.size();i++){
+		for (int j=0;j<PROFILE_ZONE_COUNT;j++)
+			threads[i]->stats[j] = ProfileZoneStats();
+		threads[i]->events.clear();
+		threads[i]->droppedEvents = 0;
+	}
+	startTicks = getTicks();
+}
+
+/**
+	This method adds the stats of all the threads for the zone passed in as a parameter.
+*/
+ProfileZoneStats Profiler::getTotalStats(int zone){
+	ProfileZoneStats total;
+	lock_guard<mutex> lock(threadsLock);
+	for (uint i=0;i<threads.size();i++){
+		const ProfileZoneStats& s = threads[i]->stats[zone];
+		if (s.calls == 0)
+			continue;
+		if (total.calls == 0 || s.minTicks < total.minTicks)
+			total.minTicks = s.minTicks;
+		if (total.calls == 0 || s.maxTicks > total.maxTicks)
+			total.maxTicks = s.maxTicks;
+		total.calls += s.calls;
+		total.totalTicks += s.totalTicks;
+	}
+	return total;
+}
+
+/**
+	prints one line of the summary table
+*/
+static void printSummaryLine(FILE* f, const char* zoneName, const char* threadName, const ProfileZoneStats& s, double ticksPerMicrosecond){
+	fprintf(f, "%-20s %-8s %10lld %12.3f %10.3f %10.3f %10.3f\n", zoneName, threadName, s.calls, s.totalTicks / ticksPerMicrosecond / 1000,
+		s.totalTicks / ticksPerMicrosecond / s.calls, s.minTicks / ticksPerMicrosecond, s.maxTicks / ticksPerMicrosecond);
+}
+
+/**
+	This method prints a table with the time spent in every zone, for each thread and for all of them together. The times of the zones
+	include the time of the zones that are nested in them.
+*/
+void Profiler::printSummary(FILE* f){
+	double ticksPerMicrosecond = getTicksPerSecond() / 1000000.0;
+	fprintf(f, "%-20s %-8s %10s %12s %10s %10s %10s\n", "zone", "thread", "calls", "total (ms)", "mean (us)", "min (us)", "max (us)");
+	for (int zone=0;zone<PROFILE_ZONE_COUNT;zone++){
+		ProfileZoneStats total = getTotalStats(zone);
+		if (total.calls == 0)
+			continue;
+		lock_guard<mutex> lock(threadsLock);
+		//the threads are only listed one by one if there is more than one of them in this zone
+		int threadCount = 0;
+		for (uint i=0;i<threads.size();i++)
+			if (threads[i]->stats[zone].calls > 0)
+				threadCount++;
+		if (threadCount > 1){
+			for (uint i=0;i<threads.size();i++){
+				if (threads[i]->stats[zone].calls == 0)
+					continue;
+				char threadName[20];
+				sprintf(threadName, "%d", threads[i]->threadIndex);
+				printSummaryLine(f, zoneNames[zone], threadName, threads[i]->stats[zone], ticksPerMicrosecond);
+			}
+		}
+		printSummaryLine(f, zoneNames[zone], "all", total, ticksPerMicrosecond);
+	}
+
+	lock_guard<mutex> lock(threadsLock);
+	long long dropped = 0;
+	for (uint i=0;i<threads.size();i++)
+		dropped += threads[i]->droppedEvents;
+	if (dropped > 0)
+		fprintf(f, "%lld passes through the zones did not fit in the trace\n", dropped);
+}
+
+/**
+	This method writes all the recorded passes through the zones as a Chrome trace (JSON). It returns false if the file cannot be written.
+*/
+bool Profiler::writeChromeTrace(const char* fileName){
+	FILE* f = fopen(fileName, "w");
+	if (f == NULL){
+		printf("Cannot write the trace %s\n", fileName);
+		return false;
+	}
+
+	double ticksPerMicrosecond = getTicksPerSecond() / 1000000.0;
+	lock_guard<mutex> lock(threadsLock);
+	fprintf(f, "{\"traceEvents\":[\n");
+	bool first = true;
+	for (uint i=0;i<threads.size();i++){
+		ProfilerThreadData* data = threads[i];
+		fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}", first ? "" : ",\n",
+			data->threadIndex, data->threadIndex);
+		first = false;
+		for (uint j=0;j<data->events.size();j++){
+			const ProfileEvent& e = data->events[j];
+			fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"simulation\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", zoneNames[e.zone],
+				data->threadIndex, (e.start - startTicks) / ticksPerMicrosecond, (e.end - e.start) / ticksPerMicrosecond);
+		}
+	}
+	fprintf(f, "\n],\"displayTimeUnit\":\"ns\"}\n");
+	fclose(f);
+	return true;
+}
+
+/**
+	writes the reports that were asked for with reportAtExit
+*/
+static void writeExitReport(){
+	printf("Time spent in each phase of the simulation:\n");
+	Profiler::printSummary(stdout);
+	if (Profiler::writeChromeTrace(exitTraceFileName))
+		printf("The trace was written to %s\n", exitTraceFileName);
+}
+
+/**
+	This method enables the profiler, and makes it print the summary and write the trace to the file passed in as a parameter when the
+	program exits.
+*/
+void Profiler::reportAtExit(const char* traceFileName){
+	setEnabled(true);
+	bool registered = (exitTraceFileName[0] != '\0');
+	strncpy(exitTraceFileName, traceFileName, 199);
+	exitTraceFileName[199] = '\0';
+	if (!registered)
+		atexit(writeExitReport);
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "PUtils.h"
+
+/**
+	These are the phases of a simulation step that are timed. Each one is a zone of the profiler, and a zone can be entered from any thread.
+*/
+#define PROFILE_SIMULATION_STEP			0
+#define PROFILE_CONTROLLER_COMPUTE		1
+#define PROFILE_TORQUE_APPLICATION		2
+#define PROFILE_ENGINE_SIMULATE			3
+#define PROFILE_ENGINE_FETCH			4
+#define PROFILE_CONTACT_PROCESSING		5
+#define PROFILE_STATE_SYNC				6
+#define PROFILE_FSM_TRANSITION			7
+#define PROFILE_ZONE_COUNT				8
+
+#ifdef _MSC_VER
+#define PROFILER_THREAD_LOCAL __declspec(thread)
+#else
+#define PROFILER_THREAD_LOCAL __thread
+#endif
+
+/**
+	This structure holds the time spent in one zone, by one thread.
+*/
+typedef struct ProfileZoneStats_struct{
+	long long calls;
+	long long totalTicks;
+	long long minTicks;
+	long long maxTicks;
+	ProfileZoneStats_struct() : calls(0), totalTicks(0), minTicks(0), maxTicks(0) {}
+} ProfileZoneStats;
+
+/**
+	This structure records one pass through a zone, for the trace.
+*/
+typedef struct ProfileEvent_struct{
+	int zone;
+	long long start;
+	long long end;
+} ProfileEvent;
+
+/**
+	This is what the profiler knows about one thread. Only that thread ever writes to it, so recording a zone takes no lock.
+*/
+typedef struct ProfilerThreadData_struct{
+	int threadIndex;
+	ProfileZoneStats stats[PROFILE_ZONE_COUNT];
+	DynamicArray<ProfileEvent> events;
+	//the passes that did not fit in the trace any more. They are still in the stats
+	long long droppedEvents;
+} ProfilerThreadData;
+
+/**
+	This class measures where the time of the simulation goes. The code that is timed is marked with PROFILE_SCOPE(zone), which records how long
+	the rest of the enclosing block takes. The profiler is off until it is enabled, and then a scope costs two reads of the performance counter.
+
+	The times are kept separately for every thread, and they can be printed as a table (printSummary) or written as a trace that the Chrome
+	tracing viewer (chrome://tracing) can open (writeChromeTrace). The reports, and reset, should only be used while no zone is being timed.
+*/
+class Profiler{
+private:
+	//the data of every thread that has recorded something so far
+	static DynamicArray<ProfilerThreadData*> threads;
+	//the data of the calling thread, or NULL if it has not recorded anything yet
+	static PROFILER_THREAD_LOCAL ProfilerThreadData* currentThread;
+	//the time the events of the trace are measured from
+	static long long startTicks;
+	//the number of ticks of the performance counter in one second
+	static long long ticksPerSecond;
+
+	/**
+		returns the data of the calling thread, creating it the first time the thread records something
+	*/
+	static ProfilerThreadData* getThreadData();
+
+public:
+	//nothing is recorded while this is false
+	static bool enabled;
+	//the number of passes through the zones that are kept for the trace, for each thread
+	static int maxEventsPerThread;
+
+	/**
+		This method turns the profiler on or off. The times recorded so far are kept.
+	*/
+	static void setEnabled(bool enabled);
+
+	/**
+		returns the current value of the performance counter
+	*/
+	static long long getTicks();
+
+	/**
+		returns the number of ticks of the performance counter in one second
+	*/
+	static long long getTicksPerSecond();
+
+	/**
+		returns the name of the zone that is passed in as a parameter
+	*/
+	static const char* getZoneName(int zone);
+
+	/**
+		This method records one pass through a zone, which went from the tick start to the tick end.
+	*/
+	static void record(int zone, long long start, long long end);
+
+	/**
+		This method forgets everything that has been recorded so far.
+	*/
+	static void reset();
+
+	/**
+		This method adds the stats of all the threads for the zone passed in as a parameter.
+	*/
+	static ProfileZoneStats getTotalStats(int zone);
+
+	/**
+		This method prints a table with the time spent in every zone, for each thread and for all of them together. The times of the zones
+		include the time of the zones that are nested in them.
+	*/
+	static void printSummary(FILE* f = stdout);
+
+	/**
+		This method writes all the recorded passes through the zones as a Chrome trace (JSON). It returns false if the file cannot be written.
+	*/
+	static bool writeChromeTrace(const char* fileName);
+
+	/**
+		This method enables the profiler, and makes it print the summary and write the trace to the file passed in as a parameter when the
+		program exits.
+	*/
+	static void reportAtExit(const char* traceFileName);
+};
+
+/**
+	An instance of this class times the block it is declared in, from its construction to the end of the block.
+*/
+class ProfileScope{
+private:
+	int zone;
+	bool active;
+	long long start;
+public:
+	inline ProfileScope(int zone){
+		this->zone = zone;
+		active = Profiler::enabled;
+		if (active)
+			start = Profiler::getTicks();
+	}
+
+	inline ~ProfileScope(void){
+		if (active)
+			Profiler::record(zone, start, Profiler::getTicks());
+	}
+};
+
+#define PROFILE_SCOPE_NAME_(line) profileScope##line
+#define PROFILE_SCOPE_NAME(line) PROFILE_SCOPE_NAME_(line)
+#define PROFILE_SCOPE(zone) ProfileScope PROFILE_SCOPE_NAME(__LINE__)(zone)
@@ -43,7 +43,8 @@
 
 int gsl_blas_ddot (const gsl_vector * X, const gsl_vector * Y, double *result){
   if (X->size == Y->size){
-	  *result = ddot (&INT (X->size), X->data, &INT (X->stride), Y->data, &INT (Y->stride));
+	  integer n = INT (X->size), incX = INT (X->stride), incY = INT (Y->stride);
+	  *result = ddot (&n, X->data, &incX, Y->data, &incY);
       return GSL_SUCCESS;
     }
   else {
@@ -59,7 +60,8 @@ int gsl_blas_ddot (const gsl_vector * X, const gsl_vector * Y, double *result){
 */
 
 double gsl_blas_dnrm2 (const gsl_vector * X){
-  return dnrm2 (&INT (X->size), X->data, &INT (X->stride));
+  integer n = INT (X->size), incX = INT (X->stride);
+  return dnrm2 (&n, X->data, &incX);
 }
 
 /**
@@ -67,7 +69,8 @@ double gsl_blas_dnrm2 (const gsl_vector * X){
 */
 int gsl_blas_dswap (gsl_vector * X, gsl_vector * Y){
   if (X->size == Y->size){
-      dswap (&INT (X->size), X->data, &INT (X->stride), Y->data, &INT (Y->stride));
+      integer n = INT (X->size), incX = INT (X->stride), incY = INT (Y->stride);
+      dswap (&n, X->data, &incX, Y->data, &incY);
       return GSL_SUCCESS;
     }
   else{
@@ -82,7 +85,8 @@ int gsl_blas_dswap (gsl_vector * X, gsl_vector * Y){
 */
 int gsl_blas_dcopy (const gsl_vector * X, gsl_vector * Y){
   if (X->size == Y->size){
-      dcopy (&INT (X->size), X->data, &INT (X->stride), Y->data, &INT (Y->stride));
+      integer n = INT (X->size), incX = INT (X->stride), incY = INT (Y->stride);
+      dcopy (&n, X->data, &incX, Y->data, &incY);
       return GSL_SUCCESS;
     }
   else {
@@ -111,9 +115,10 @@ gsl_blas_dgemv (CBLAS_TRANSPOSE_t TransA, double alpha, const gsl_matrix * A,
   if ((TransA == CblasNoTrans && N == X->size && M == Y->size)
       || (TransA == CblasTrans && M == X->size && N == Y->size))
     {
-      dgemv (&aTransp, &INT (N), &INT (M), &alpha, A->data,
-                   &INT (A->tda), X->data, &INT (X->stride), &beta, Y->data,
-                   &INT (Y->stride));
+      integer n = INT (N), m = INT (M), lda = INT (A->tda), incX = INT (X->stride), incY = INT (Y->stride);
+      dgemv (&aTransp, &n, &m, &alpha, A->data,
+                   &lda, X->data, &incX, &beta, Y->data,
+                   &incY);
       return GSL_SUCCESS;
     }
   else
@@ -155,9 +160,10 @@ int gsl_blas_dgemm (CBLAS_TRANSPOSE_t TransA, CBLAS_TRANSPOSE_t TransB,
 
   if (M == MA && N == NB && NA == MB)   /* [MxN] = [MAxNA][MBxNB] */
     {
-	  dgemm (&bTransp, &aTransp, &INT (N), &INT (M), &INT (NA),
-                   &alpha, B->data, &INT (B->tda), A->data, &INT (A->tda), &beta,
-                   C->data, &INT (C->tda));
+	  integer n = INT (N), m = INT (M), k = INT (NA), ldb = INT (B->tda), lda = INT (A->tda), ldc = INT (C->tda);
+	  dgemm (&bTransp, &aTransp, &n, &m, &k,
+                   &alpha, B->data, &ldb, A->data, &lda, &beta,
+                   C->data, &ldc);
       return GSL_SUCCESS;
     }
   else